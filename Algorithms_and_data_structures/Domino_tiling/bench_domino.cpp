@@ -0,0 +1,308 @@
+/**
+ * Benchmark and differential-testing harness for the Domino problem engines.
+ *
+ * The program generates boards from a seed for a sweep of sizes (k rows, n columns)
+ * and value distributions (all-positive, mixed sign, mostly negative). In the first phase
+ * every engine is run on tiny boards and its answer is compared with the other engines
+ * and with a brute force. In the second phase every engine is timed on larger boards,
+ * their answers are cross-checked again and time, peak memory and cells/sec are reported.
+ *
+ * Each timed run is executed in a forked child process, so the reported peak memory
+ * (max RSS) belongs to that single run and not to the whole harness.
+ *
+ * Usage: ./bench_domino [seed]
+ * Exit code is 1 if any two answers differ or a run fails, 0 otherwise.
+ *
+ * Author: Kacper Pasinski
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "domino.hpp"
+using namespace std;
+
+/* Engines and distributions taking part in the benchmark */
+
+using Board = vector<vector<int>>;
+
+struct Engine {
+    const char* name;
+    long long (*solve)(Board& board, int n, int k);
+};
+
+// Every engine computing maxDominoSuma over the whole board should be listed here.
+const vector<Engine> engines = {
+    {"bitmask-dp", solveDomino},
+};
+
+enum class Distribution { AllPositive, Mixed, MostlyNegative };
+
+const vector<pair<Distribution, const char*>> distributions = {
+    {Distribution::AllPositive, "positive"},
+    {Distribution::Mixed, "mixed"},
+    {Distribution::MostlyNegative, "negative"},
+};
+
+// Cell values stay within [-MAX_VALUE, MAX_VALUE].
+const int MAX_VALUE = 1000;
+
+// Boards with at most this many cells are also solved by brute force.
+const int BRUTE_FORCE_MAX_CELLS = 20;
+
+/* Board generation */
+
+/**
+ * Generates a k x n board with values drawn from the given distribution.
+ *
+ * @param n The total number of columns in the board.
+ * @param k The total number of rows in the board.
+ * @param dist The distribution of the cell values.
+ * @param rng The random number generator (seeded by the caller).
+ * @return The generated board.
+ */
+Board generateBoard(int n, int k, Distribution dist, mt19937_64& rng) {
+    uniform_int_distribution<int> positive(1, MAX_VALUE);
+    uniform_int_distribution<int> mixed(-MAX_VALUE, MAX_VALUE);
+    uniform_int_distribution<int> percent(0, 99);
+
+    Board board(k, vector<int> (n));
+    for (int i = 0; i < k; ++i) {
+        for (int j = 0; j < n; ++j) {
+            switch (dist) {
+                case Distribution::AllPositive:
+                    board[i][j] = positive(rng);
+                    break;
+                case Distribution::Mixed:
+                    board[i][j] = mixed(rng);
+                    break;
+                case Distribution::MostlyNegative:
+                    // Roughly 90% of the cells are negative.
+                    board[i][j] = (percent(rng) < 90) ? -positive(rng) : positive(rng);
+                    break;
+            }
+        }
+    }
+    return board;
+}
+
+/* Brute force reference */
+
+/**
+ * Recursively tries every set of non-overlapping dominoes, cell by cell in row-major order.
+ * Every uncovered cell is either left empty or becomes the top-left end of a horizontal
+ * or vertical domino.
+ *
+ * @param cell The index (row * n + col) of the cell being processed.
+ * @param covered Flags of the cells already covered by a domino.
+ * @param board The board with values in each cell.
+ * @param n The total number of columns in the board.
+ * @param k The total number of rows in the board.
+ * @return The maximum sum achievable over the cells from the given one to the end.
+ */
+long long bruteForce(int cell, vector<bool>& covered, const Board& board, int n, int k) {
+    if (cell == n * k)
+        return 0;
+
+    int row = cell / n;
+    int col = cell % n;
+    if (covered[cell])
+        return bruteForce(cell + 1, covered, board, n, k);
+
+    long long best = bruteForce(cell + 1, covered, board, n, k);
+
+    if (col + 1 < n && !covered[cell + 1]) {
+        covered[cell + 1] = true;
+        best = max(best, board[row][col] + board[row][col + 1]
+            + bruteForce(cell + 1, covered, board, n, k));
+        covered[cell + 1] = false;
+    }
+
+    if (row + 1 < k) {
+        covered[cell + n] = true;
+        best = max(best, board[row][col] + board[row + 1][col]
+            + bruteForce(cell + 1, covered, board, n, k));
+        covered[cell + n] = false;
+    }
+
+    return best;
+}
+
+/* Measurements */
+
+struct RunResult {
+    bool ok;
+    long long answer;
+    double seconds;
+    long maxRssKb;
+};
+
+/**
+ * Runs the engine on the board in a forked child, so that the peak memory can be measured
+ * for this run alone. The child sends back the answer and the elapsed time through a pipe.
+ *
+ * @param engine The engine to run.
+ * @param board The board to solve.
+ * @param n The total number of columns in the board.
+ * @param k The total number of rows in the board.
+ * @return The answer, the time it took and the peak resident set size of the child.
+ */
+RunResult runIsolated(const Engine& engine, Board& board, int n, int k) {
+    RunResult result = {false, 0, 0.0, 0};
+
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return result;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        auto start = chrono::steady_clock::now();
+        long long answer = engine.solve(board, n, k);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        double seconds = elapsed.count();
+        bool written = write(fds[1], &answer, sizeof(answer)) == sizeof(answer)
+            && write(fds[1], &seconds, sizeof(seconds)) == sizeof(seconds);
+        _exit(written ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool received = read(fds[0], &result.answer, sizeof(result.answer)) == sizeof(result.answer)
+        && read(fds[0], &result.seconds, sizeof(result.seconds)) == sizeof(result.seconds);
+    close(fds[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return result;
+    }
+
+    result.ok = received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    result.maxRssKb = usage.ru_maxrss; // In kilobytes on Linux.
+    return result;
+}
+
+/* Phases of the harness */
+
+/**
+ * Compares every engine against the brute force on all tiny boards of the sweep.
+ *
+ * @param rng The random number generator used to create boards.
+ * @return The number of mismatching answers.
+ */
+int differentialPhase(mt19937_64& rng) {
+    const int BOARDS_PER_SIZE = 25;
+    int mismatches = 0;
+    int checked = 0;
+
+    for (int k = 1; k <= 4; ++k) {
+        for (int n = 1; n * k <= BRUTE_FORCE_MAX_CELLS; ++n) {
+            for (auto& [dist, distName] : distributions) {
+                for (int t = 0; t < BOARDS_PER_SIZE; ++t) {
+                    Board board = generateBoard(n, k, dist, rng);
+                    vector<bool> covered(n * k, false);
+                    long long expected = bruteForce(0, covered, board, n, k);
+
+                    for (const Engine& engine : engines) {
+                        long long answer = engine.solve(board, n, k);
+                        ++checked;
+                        if (answer != expected) {
+                            ++mismatches;
+                            cerr << "MISMATCH " << engine.name << " k=" << k << " n=" << n
+                                 << " dist=" << distName << ": got " << answer
+                                 << ", brute force " << expected << "\n";
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    cout << "differential: " << checked << " runs checked against brute force, "
+         << mismatches << " mismatches\n";
+    return mismatches;
+}
+
+/**
+ * Times every engine on larger boards and checks that all engines agree with each other.
+ *
+ * @param rng The random number generator used to create boards.
+ * @return The number of boards on which the engines disagreed or a run failed.
+ */
+int performancePhase(mt19937_64& rng) {
+    const vector<pair<int, int>> sizes = {
+        {2, 20000}, {4, 20000}, {6, 10000}, {8, 2000}, {10, 500}, {12, 100},
+    };
+    int failures = 0;
+
+    printf("\n%4s %7s %-9s %-12s %16s %10s %12s %12s\n",
+           "k", "n", "dist", "engine", "answer", "time[ms]", "peak[KB]", "Mcells/s");
+
+    for (auto [k, n] : sizes) {
+        for (auto& [dist, distName] : distributions) {
+            Board board = generateBoard(n, k, dist, rng);
+
+            bool first = true;
+            long long reference = 0;
+            for (const Engine& engine : engines) {
+                RunResult run = runIsolated(engine, board, n, k);
+                if (!run.ok) {
+                    ++failures;
+                    cerr << "FAILED " << engine.name << " k=" << k << " n=" << n
+                         << " dist=" << distName << "\n";
+                    continue;
+                }
+
+                double cellsPerSecond = run.seconds > 0 ? (double) n * k / run.seconds : 0.0;
+                printf("%4d %7d %-9s %-12s %16lld %10.2f %12ld %12.3f\n",
+                       k, n, distName, engine.name, run.answer, run.seconds * 1000.0,
+                       run.maxRssKb, cellsPerSecond / 1e6);
+
+                if (first) {
+                    reference = run.answer;
+                    first = false;
+                } else if (run.answer != reference) {
+                    ++failures;
+                    cerr << "MISMATCH " << engine.name << " k=" << k << " n=" << n
+                         << " dist=" << distName << ": got " << run.answer
+                         << ", expected " << reference << "\n";
+                }
+            }
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long long seed = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 2024;
+    cout << "seed: " << seed << "\n";
+    mt19937_64 rng(seed);
+
+    int failures = differentialPhase(rng);
+    failures += performancePhase(rng);
+
+    if (failures > 0) {
+        cout << "\n" << failures << " failures\n";
+        return 1;
+    }
+    cout << "\nall engines agree\n";
+    return 0;
+}
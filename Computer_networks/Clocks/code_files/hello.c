@@ -19,8 +19,8 @@
  * @param dst The address of the peer to send the HELLO to.
  */
 void send_hello(const struct sockaddr_in *dst) {
-    uint8_t buf[MSG_MAX_SIZE];
-    size_t len = msg_build_hello(buf, sizeof(buf));
+    uint8_t *buf = state.send_buf;
+    size_t len = msg_build_hello(buf, MSG_MAX_SIZE);
     if (len > 0) {
        //  printf("Sending HELLO to %s:%" PRIu16 "\n",
        // inet_ntoa(dst->sin_addr), ntohs(dst->sin_port));
@@ -46,19 +46,19 @@ void hello_handle(const uint8_t *buf, size_t len, const struct sockaddr_in *src)
         return;
     }
 
-    peer_info_t infos[PEER_MAX];
+    peer_info_t *infos = state.peer_infos;
     size_t cnt = 0;
     for (size_t i = 0; i < state.peer_list.count && cnt < PEER_MAX; ++i) {
-        peer_t *p = &state.peer_list.peers[i];
-        if (memcmp(&p->addr, src, sizeof(*src)) == 0)
+        const struct sockaddr_in *addr = &state.peer_list.addrs[i];
+        if (memcmp(addr, src, sizeof(*src)) == 0)
             continue;
-        infos[cnt].addr = p->addr.sin_addr;
-        infos[cnt].port = p->addr.sin_port;
+        infos[cnt].addr = addr->sin_addr;
+        infos[cnt].port = addr->sin_port;
         cnt++;
     }
 
-    uint8_t out[MSG_MAX_SIZE];
-    size_t out_len = msg_build_hello_reply(out, sizeof(out), infos, cnt);
+    uint8_t *out = state.send_buf;
+    size_t out_len = msg_build_hello_reply(out, MSG_MAX_SIZE, infos, cnt);
     if (out_len > 0) {
        //  printf("Sending HELLO_REPLY to %s:%d\n",
        // inet_ntoa(src->sin_addr), ntohs(src->sin_port));
@@ -81,7 +81,7 @@ void hello_reply_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
     // printf("Received HELLO_REPLY from %s:%d\n",
     //    inet_ntoa(src->sin_addr), ntohs(src->sin_port));
 
-    peer_info_t infos[PEER_MAX];
+    peer_info_t *infos = state.peer_infos;
     uint16_t cnt;
     if (!msg_parse_hello_reply(buf, len, infos, PEER_MAX, &cnt)) {
         print_invalid_message(buf, len);
@@ -103,8 +103,8 @@ void hello_reply_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
         peer_addr.sin_port = infos[i].port;
         if (peer_list_find(&state.peer_list, &peer_addr))
             continue;
-        uint8_t out[MSG_MAX_SIZE];
-        size_t out_len = msg_build_connect(out, sizeof(out));
+        uint8_t *out = state.send_buf;
+        size_t out_len = msg_build_connect(out, MSG_MAX_SIZE);
         if (out_len > 0) {
             // printf("Sending CONNECT message to %s:%d\n",
             //        inet_ntoa(peer_addr.sin_addr), ntohs(peer_addr.sin_port));
@@ -137,8 +137,8 @@ void connect_handle(const uint8_t *buf, size_t len, const struct sockaddr_in *sr
 
     peer_list_add(&state.peer_list, src);
 
-    uint8_t out[MSG_MAX_SIZE];
-    size_t out_len = msg_build_ack_connect(out, sizeof(out));
+    uint8_t *out = state.send_buf;
+    size_t out_len = msg_build_ack_connect(out, MSG_MAX_SIZE);
     if (out_len > 0) {
         // printf("Sending ACK_CONNECT message to %s:%d\n",
         //        inet_ntoa(src->sin_addr), ntohs(src->sin_port));
@@ -45,7 +45,7 @@ void leader_handle(const uint8_t *buf, size_t len) {
  * This function desynchronizes from a leader after not hearing from them in 20 seconds.
  */
 void ditch_leader(void) {
-    state.sync_source = NULL;
+    state.sync_source = PEER_NONE;
     state.level = 255;
     state.offset = 0;
 }
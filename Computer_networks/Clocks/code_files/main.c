@@ -116,13 +116,14 @@ int main(int argc, char *argv[]) {
             }
 
         /* 4.3 Detect lost synchronization after 20 seconds of silence */
-        if (state.sync_source) {
+        if (state.sync_source != PEER_NONE) {
+            peer_t *source = &state.peer_list.peers[state.sync_source];
             // printf("DEBUG: Current time: %ld, Last message from source
-            // : %ld\n", state.current_time, state.sync_source->last_message_to_be_synced);
-            if (state.current_time - state.sync_source->last_message_to_be_synced >= 10000) {
+            // : %ld\n", state.current_time, source->last_message_to_be_synced);
+            if (state.current_time - source->last_message_to_be_synced >= 10000) {
                 // printf("WARN: Lost contact with sync source %s:%d — desynchronizing\n",
-                //        inet_ntoa(state.sync_source->addr.sin_addr),
-                //        ntohs(state.sync_source->addr.sin_port));
+                //        inet_ntoa(state.peer_list.addrs[state.sync_source].sin_addr),
+                //        ntohs(state.peer_list.addrs[state.sync_source].sin_port));
                 ditch_leader();
             }
         }
@@ -140,9 +141,9 @@ int main(int argc, char *argv[]) {
 
         /* 4.5 Handle incoming message */
         if (FD_ISSET(sock_fd, &read_fds)) {
-            uint8_t buf[MSG_MAX_SIZE];
+            uint8_t *buf = state.recv_buf;
             struct sockaddr_in src;
-            ssize_t len = udp_recvfrom(sock_fd, buf, sizeof(buf), &src, false);
+            ssize_t len = udp_recvfrom(sock_fd, buf, MSG_MAX_SIZE, &src, false);
             if (len < 0) {
                 syserr("recvfrom failed");
             }
@@ -1,47 +1,197 @@
 /**
  * @file peer_list.c
  * @brief Implementation of peer management (add, find, track connections).
+ *
+ * Both lists keep their entries in dense arrays, which is what gets iterated, and
+ * find them by address through a hash index, so lookup, insert and removal take O(1)
+ * time however many peers the node knows. The arrays and the index start empty and
+ * double when full, so a node in a small mesh only pays for the peers it has.
  */
 
+#include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include "state.h"
 
 #include "peer_list.h"
 
 /**
- * Initializes the peer list by clearing all entries and resetting the count.
+ * Returns the index key of an address: IPv4 address and port, in network byte order.
+ */
+static uint64_t peer_key(const struct sockaddr_in *addr) {
+    return ((uint64_t)addr->sin_addr.s_addr << 16) | addr->sin_port;
+}
+
+/**
+ * Returns the slot where probing for a key starts (Fibonacci hashing).
+ */
+static size_t index_home(const peer_index_t *index, uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - index->bits));
+}
+
+/**
+ * Finds the slot holding a key.
+ *
+ * @return The slot, or SIZE_MAX if the key is not in the index.
+ */
+static size_t index_slot(const peer_index_t *index, uint64_t key) {
+    if (!index->slots) return SIZE_MAX;
+    const size_t mask = ((size_t)1 << index->bits) - 1;
+    for (size_t i = index_home(index, key);; i = (i + 1) & mask) {
+        uint64_t slot = index->slots[i];
+        if (slot == 0) return SIZE_MAX;
+        if (slot >> 16 == key) return i;
+    }
+}
+
+/**
+ * Returns the position stored for a key, or -1 if the key is not in the index.
+ */
+static long index_find(const peer_index_t *index, uint64_t key) {
+    size_t i = index_slot(index, key);
+    return i == SIZE_MAX ? -1 : (long)(index->slots[i] & 0xffff) - 1;
+}
+
+/**
+ * Puts a slot value into the first free slot of its probe run.
+ */
+static void index_place(peer_index_t *index, uint64_t slot) {
+    const size_t mask = ((size_t)1 << index->bits) - 1;
+    size_t i = index_home(index, slot >> 16);
+    while (index->slots[i] != 0) i = (i + 1) & mask;
+    index->slots[i] = slot;
+}
+
+/**
+ * Makes room in the index for one more key, doubling it (and rehashing every key)
+ * once it would be more than half full.
+ *
+ * @return false if the memory could not be allocated.
+ */
+static bool index_reserve(peer_index_t *index, size_t count) {
+    if (index->slots && (count + 1) * 2 <= ((size_t)1 << index->bits)) return true;
+
+    peer_index_t grown;
+    grown.bits = index->slots ? index->bits + 1 : PEER_INDEX_MIN_BITS;
+    grown.slots = calloc((size_t)1 << grown.bits, sizeof(uint64_t));
+    if (!grown.slots) return false;
+
+    if (index->slots) {
+        for (size_t i = 0; i < ((size_t)1 << index->bits); i++) {
+            if (index->slots[i] != 0) index_place(&grown, index->slots[i]);
+        }
+        free(index->slots);
+    }
+    *index = grown;
+    return true;
+}
+
+/**
+ * Stores the position of a key that is not in the index yet; index_reserve() must
+ * have made room for it.
+ */
+static void index_insert(peer_index_t *index, uint64_t key, size_t position) {
+    index_place(index, (key << 16) | (position + 1));
+}
+
+/**
+ * Changes the position stored for a key that is in the index.
+ */
+static void index_move(peer_index_t *index, uint64_t key, size_t position) {
+    index->slots[index_slot(index, key)] = (key << 16) | (position + 1);
+}
+
+/**
+ * Removes a key from the index.
+ *
+ * The entries after it in the probe run are shifted back into the hole when their
+ * home slot allows it, so no tombstones are left and lookups stay short.
+ */
+static void index_remove(peer_index_t *index, uint64_t key) {
+    size_t hole = index_slot(index, key);
+    if (hole == SIZE_MAX) return;
+
+    const size_t mask = ((size_t)1 << index->bits) - 1;
+    for (size_t i = (hole + 1) & mask; index->slots[i] != 0; i = (i + 1) & mask) {
+        size_t home = index_home(index, index->slots[i] >> 16);
+        // The entry may fill the hole only if its home is not between the hole and it.
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index->slots[hole] = index->slots[i];
+            hole = i;
+        }
+    }
+    index->slots[hole] = 0;
+}
+
+/**
+ * Returns the capacity an array of peers grows to when it is full.
+ */
+static size_t next_capacity(size_t capacity) {
+    size_t next = capacity ? capacity * 2 : 8;
+    return next < PEER_MAX ? next : PEER_MAX;
+}
+
+/**
+ * Initializes the peer list as empty; nothing is allocated until the first peer is added.
  *
  * @param list Pointer to the peer list to initialize.
  */
 void peer_list_init(peer_list_t *list) {
-    list->count = 0;
-    memset(list->peers, 0, sizeof(list->peers));
+    memset(list, 0, sizeof(*list));
 }
 
 /**
- * Initializes the peer possibilities list by clearing all entries and resetting the count.
+ * Initializes the peer possibilities list as empty; nothing is allocated until the first
+ * address is added.
  *
  * @param list Pointer to the peer possibilities list to initialize.
  */
 void peer_possibilities_init(peer_possibilities_t *list) {
-    list->count = 0;
-    memset(list->peers, 0, sizeof(list->peers));
+    memset(list, 0, sizeof(*list));
+}
+
+/**
+ * Releases the memory of the peer list and leaves it empty.
+ *
+ * @param list Pointer to the peer list.
+ */
+void peer_list_free(peer_list_t *list) {
+    free(list->peers);
+    free(list->addrs);
+    free(list->index.slots);
+    peer_list_init(list);
+}
+
+/**
+ * Releases the memory of the peer possibilities list and leaves it empty.
+ *
+ * @param list Pointer to the peer possibilities list.
+ */
+void peer_possibilities_free(peer_possibilities_t *list) {
+    free(list->peers);
+    free(list->index.slots);
+    peer_possibilities_init(list);
 }
 
 /**
- * Searches for a peer in the list by socket address.
+ * Searches for a peer in the list by socket address (IPv4 address and port).
  *
  * @param list Pointer to the peer list.
  * @param addr Pointer to the socket address to search for.
  * @return Pointer to the found peer, or NULL if not found.
  */
 peer_t *peer_list_find(peer_list_t *list, const struct sockaddr_in *addr) {
-    for (size_t i = 0; i < list->count; ++i) {
-        if (memcmp(&list->peers[i].addr, addr, sizeof(struct sockaddr_in)) == 0)
-            return &list->peers[i];
-    }
-    return NULL;
+    long i = index_find(&list->index, peer_key(addr));
+    return i < 0 ? NULL : &list->peers[i];
+}
+
+/**
+ * Returns the position of a peer of the list, which stays the same while the list grows.
+ *
+ * @param list Pointer to the peer list.
+ * @param p Pointer to a peer of the list.
+ * @return Index of the peer in list->peers and list->addrs.
+ */
+size_t peer_list_position(const peer_list_t *list, const peer_t *p) {
+    return (size_t)(p - list->peers);
 }
 
 /**
@@ -49,7 +199,8 @@ peer_t *peer_list_find(peer_list_t *list, const struct sockaddr_in *addr) {
  *
  * @param list Pointer to the peer list.
  * @param addr Pointer to the socket address of the new peer.
- * @return Pointer to the added or existing peer, or NULL if the list is full.
+ * @return Pointer to the added or existing peer, or NULL if the list is full (or memory
+ *         ran out).
  */
 peer_t *peer_list_add(peer_list_t *list, const struct sockaddr_in *addr) {
     peer_t *existing = peer_list_find(list, addr);
@@ -57,24 +208,48 @@ peer_t *peer_list_add(peer_list_t *list, const struct sockaddr_in *addr) {
 
     if (list->count >= PEER_MAX) return NULL;
 
+    if (list->count == list->capacity) {
+        size_t capacity = next_capacity(list->capacity);
+        peer_t *peers = realloc(list->peers, capacity * sizeof(*peers));
+        if (!peers) return NULL;
+        list->peers = peers;
+        struct sockaddr_in *addrs = realloc(list->addrs, capacity * sizeof(*addrs));
+        if (!addrs) return NULL;
+        list->addrs = addrs;
+        list->capacity = capacity;
+    }
+    if (!index_reserve(&list->index, list->count)) return NULL;
+
+    index_insert(&list->index, peer_key(addr), list->count);
+    list->addrs[list->count] = *addr;
     peer_t *p = &list->peers[list->count++];
     memset(p, 0, sizeof(*p));
-    p->addr = *addr;
     return p;
 }
 
 /**
- * Adds a peer address to the possibilities list if not already present.
+ * Removes a peer from the list.
  *
- * @param list Pointer to the peer possibilities list.
- * @param addr Pointer to the peer address to add.
+ * The last peer of the list moves into the freed position, so a position or pointer
+ * kept for it (e.g. the synchronization source) must be looked up again.
+ *
+ * @param list Pointer to the peer list.
+ * @param addr Pointer to the socket address of the peer.
+ * @return true if the peer was in the list, false otherwise.
  */
-bool peer_possibilities_find(peer_possibilities_t *list, const struct sockaddr_in *addr) {
-    for (size_t i = 0; i < list->count; ++i) {
-        if (memcmp(&list->peers[i], addr, sizeof(struct sockaddr_in)) == 0)
-            return true;
+bool peer_list_remove(peer_list_t *list, const struct sockaddr_in *addr) {
+    uint64_t key = peer_key(addr);
+    long i = index_find(&list->index, key);
+    if (i < 0) return false;
+
+    index_remove(&list->index, key);
+    size_t last = --list->count;
+    if ((size_t)i != last) {
+        list->peers[i] = list->peers[last];
+        list->addrs[i] = list->addrs[last];
+        index_move(&list->index, peer_key(&list->addrs[i]), (size_t)i);
     }
-    return false;
+    return true;
 }
 
 /**
@@ -84,10 +259,49 @@ bool peer_possibilities_find(peer_possibilities_t *list, const struct sockaddr_i
  * @param addr Pointer to the peer address to search for.
  * @return true if the address is found, false otherwise.
  */
+bool peer_possibilities_find(peer_possibilities_t *list, const struct sockaddr_in *addr) {
+    return index_find(&list->index, peer_key(addr)) >= 0;
+}
+
+/**
+ * Adds a peer address to the possibilities list if not already present.
+ *
+ * @param list Pointer to the peer possibilities list.
+ * @param addr Pointer to the peer address to add.
+ */
 void peer_possibilities_add(peer_possibilities_t *list, const struct sockaddr_in *addr) {
-    if (peer_possibilities_find(list, addr)) return;
+    if (peer_possibilities_find(list, addr) || list->count >= PEER_MAX) return;
+
+    if (list->count == list->capacity) {
+        size_t capacity = next_capacity(list->capacity);
+        struct sockaddr_in *peers = realloc(list->peers, capacity * sizeof(*peers));
+        if (!peers) return;
+        list->peers = peers;
+        list->capacity = capacity;
+    }
+    if (!index_reserve(&list->index, list->count)) return;
+
+    index_insert(&list->index, peer_key(addr), list->count);
+    list->peers[list->count++] = *addr;
+}
 
-    if (list->count < PEER_MAX) {
-        list->peers[list->count++] = *addr;
+/**
+ * Removes a peer address from the possibilities list.
+ *
+ * @param list Pointer to the peer possibilities list.
+ * @param addr Pointer to the peer address to remove.
+ * @return true if the address was in the list, false otherwise.
+ */
+bool peer_possibilities_remove(peer_possibilities_t *list, const struct sockaddr_in *addr) {
+    uint64_t key = peer_key(addr);
+    long i = index_find(&list->index, key);
+    if (i < 0) return false;
+
+    index_remove(&list->index, key);
+    size_t last = --list->count;
+    if ((size_t)i != last) {
+        list->peers[i] = list->peers[last];
+        index_move(&list->index, peer_key(&list->peers[i]), (size_t)i);
     }
-}
\ No newline at end of file
+    return true;
+}
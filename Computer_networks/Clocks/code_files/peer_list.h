@@ -15,27 +15,54 @@
 /* Maximum number of peers the node can store */
 #define PEER_MAX 65535
 
-/* Structure representing a peer node */
+/* Position that stands for no peer */
+#define PEER_NONE SIZE_MAX
+
+/* log2 of the slots a hash index starts with; it doubles whenever it gets half full */
+#define PEER_INDEX_MIN_BITS 4
+
+/*
+ * Open-addressing (linear probing) hash index over (IPv4 address, port), mapping a peer
+ * to its position in a dense array. A slot holds the 48-bit key and the position + 1,
+ * so probing never touches the array; 0 marks an empty slot. No slots are allocated
+ * until the first insertion.
+ */
+typedef struct {
+    uint64_t *slots;  // Array of 1 << bits slots, or NULL
+    unsigned bits;    // log2 of the number of slots
+} peer_index_t;
+
+/*
+ * Synchronization state of a peer node: what every SYNC message reads and updates,
+ * kept apart from the addresses so that the array stays compact.
+ */
 typedef struct {
-    struct sockaddr_in addr;  // IP address and port of the peer
-    bool waiting_to_be_synced;  // Have they sent us SYNC_START but no DELAY_RESPONSE yet
-    bool attempted_to_sync;   // Have we sent SYNC_START and waiting for a response
     uint64_t  T1, T2, T3;     // Timestamps used during synchronization
-    uint8_t   expected_level; // Expected synchronization level from peer
     uint64_t  last_message_to_sync;   // Timestamp of the last sent SYNC_START
     uint64_t  last_message_to_be_synced; // Timestamp of the last received SYNC_START/DELAY_RESPONSE
+    bool waiting_to_be_synced;  // Have they sent us SYNC_START but no DELAY_RESPONSE yet
+    bool attempted_to_sync;   // Have we sent SYNC_START and waiting for a response
+    uint8_t   expected_level; // Expected synchronization level from peer
 } peer_t;
 
-/* Structure representing a list of known peers */
+/*
+ * Structure representing a list of known peers. Peer i is peers[i] at addrs[i]; both
+ * arrays grow together, so a peer_t pointer is only valid until the next addition.
+ */
 typedef struct {
-    peer_t peers[PEER_MAX];    // Array of peer structures
-    size_t count;              // Current number of peers
+    peer_t *peers;               // Synchronization state of each peer
+    struct sockaddr_in *addrs;   // IP address and port of each peer
+    size_t count;                // Current number of peers
+    size_t capacity;             // Allocated length of peers and addrs
+    peer_index_t index;          // Position of each peer, by address
 } peer_list_t;
 
 /* Structure representing a list of peers we attempted to connect to */
 typedef struct {
-    struct sockaddr_in peers[PEER_MAX];  // Array of peer addresses
-    size_t count;                        // Current number of connection attempts
+    struct sockaddr_in *peers;  // Array of peer addresses
+    size_t count;               // Current number of connection attempts
+    size_t capacity;            // Allocated length of peers
+    peer_index_t index;         // Position of each address in peers
 } peer_possibilities_t;
 
 /* Initializes the peer list */
@@ -44,16 +71,31 @@ void peer_list_init(peer_list_t *list);
 /* Initializes the peer possibilities list */
 void peer_possibilities_init(peer_possibilities_t *list);
 
+/* Releases the memory of the peer list and empties it */
+void peer_list_free(peer_list_t *list);
+
+/* Releases the memory of the peer possibilities list and empties it */
+void peer_possibilities_free(peer_possibilities_t *list);
+
 /* Finds a peer in the list by its address */
 peer_t *peer_list_find(peer_list_t *list, const struct sockaddr_in *addr);
 
 /* Adds a peer to the list (or returns existing one if already present) */
 peer_t *peer_list_add(peer_list_t *list, const struct sockaddr_in *addr);
 
+/* Returns the position of a peer of the list */
+size_t peer_list_position(const peer_list_t *list, const peer_t *p);
+
+/* Removes a peer from the list; the last peer moves into its place */
+bool peer_list_remove(peer_list_t *list, const struct sockaddr_in *addr);
+
 /* Checks if a peer address is already in the possibilities list */
 bool peer_possibilities_find(peer_possibilities_t *list, const struct sockaddr_in *addr);
 
 /* Adds a peer address to the possibilities list */
 void peer_possibilities_add(peer_possibilities_t *list, const struct sockaddr_in *addr);
 
+/* Removes a peer address from the possibilities list; the last one moves into its place */
+bool peer_possibilities_remove(peer_possibilities_t *list, const struct sockaddr_in *addr);
+
 #endif /* PEER_LIST_H */
\ No newline at end of file
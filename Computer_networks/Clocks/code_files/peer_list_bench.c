@@ -0,0 +1,137 @@
+/**
+ * @file peer_list_bench.c
+ * @brief Micro-benchmark of the peer list: hash-indexed lookup against a linear scan.
+ *
+ * For 1000, 10000 and PEER_MAX random peers it measures, in nanoseconds per operation,
+ * lookups of known and unknown addresses through peer_list_find() and through the
+ * memcmp scan the list used before it had an index, and peer_list_add() and
+ * peer_list_remove() of the whole list.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "peer_list.h"
+
+/* Number of lookups timed per measurement */
+#define LOOKUPS 200000
+
+static peer_list_t list;
+static struct sockaddr_in known[PEER_MAX];
+static struct sockaddr_in unknown[PEER_MAX];
+
+/**
+ * Returns a monotonic timestamp in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Returns a pseudo-random 64-bit number (xorshift64*).
+ */
+static uint64_t next_random(void) {
+    static uint64_t x = 0x2545F4914F6CDD1Dull;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    return x * 0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * Fills addrs with count random addresses that are not in the list.
+ */
+static void random_addresses(struct sockaddr_in *addrs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        do {
+            uint64_t r = next_random();
+            memset(&addrs[i], 0, sizeof(addrs[i]));
+            addrs[i].sin_family = AF_INET;
+            addrs[i].sin_addr.s_addr = (uint32_t)r;
+            addrs[i].sin_port = (uint16_t)(r >> 32);
+        } while (peer_list_find(&list, &addrs[i]) != NULL);
+    }
+}
+
+/**
+ * Linear search, as peer_list_find() did before the index.
+ */
+static peer_t *linear_find(peer_list_t *l, const struct sockaddr_in *addr) {
+    for (size_t i = 0; i < l->count; i++) {
+        if (memcmp(&l->addrs[i], addr, sizeof(struct sockaddr_in)) == 0) {
+            return &l->peers[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Times LOOKUPS lookups of addresses picked from addrs.
+ *
+ * @return Nanoseconds per lookup.
+ */
+static double time_lookups(peer_t *(*find)(peer_list_t *, const struct sockaddr_in *),
+                           const struct sockaddr_in *addrs, size_t count, size_t lookups) {
+    size_t found = 0;
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < lookups; i++) {
+        found += find(&list, &addrs[(i * 7919) % count]) != NULL;
+    }
+    uint64_t elapsed = now_ns() - start;
+    if (found != 0 && found != lookups) fprintf(stderr, "unexpected lookup results\n");
+    return (double)elapsed / (double)lookups;
+}
+
+int main(void) {
+    const size_t sizes[] = {1000, 10000, PEER_MAX};
+
+    printf("%8s %12s %12s %12s %12s %10s %10s\n", "peers", "index hit", "index miss",
+           "linear hit", "linear miss", "add", "remove");
+    peer_list_init(&list);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        random_addresses(known, n);
+
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            if (peer_list_add(&list, &known[i]) == NULL) {
+                fprintf(stderr, "peer list full\n");
+                return 1;
+            }
+        }
+        double add = (double)(now_ns() - start) / (double)n;
+        random_addresses(unknown, n);
+
+        // The linear scan is slow enough that fewer lookups give a stable figure.
+        size_t linear_lookups = LOOKUPS / (n / 1000);
+        double index_hit = time_lookups(peer_list_find, known, n, LOOKUPS);
+        double index_miss = time_lookups(peer_list_find, unknown, n, LOOKUPS);
+        double linear_hit = time_lookups(linear_find, known, n, linear_lookups);
+        double linear_miss = time_lookups(linear_find, unknown, n, linear_lookups);
+
+        start = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            if (!peer_list_remove(&list, &known[(i * 7919) % n])) {
+                fprintf(stderr, "peer not removed\n");
+                return 1;
+            }
+        }
+        double remove = (double)(now_ns() - start) / (double)n;
+        if (list.count != 0) {
+            fprintf(stderr, "peers left after removal\n");
+            return 1;
+        }
+        peer_list_free(&list);
+
+        printf("%8zu %12.1f %12.1f %12.1f %12.1f %10.1f %10.1f\n", n, index_hit, index_miss,
+               linear_hit, linear_miss, add, remove);
+    }
+    printf("(nanoseconds per operation)\n");
+    return 0;
+}
@@ -9,10 +9,14 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <stdlib.h>
+
 #include "state.h"
+#include "err.h"
 
 /**
- * Initializes the node state with default values.
+ * Initializes the node state with default values and allocates the scratch buffers
+ * once. The peer lists start empty and grow with the mesh.
  *
  * @param sock_fd File descriptor of the UDP socket.
  */
@@ -22,7 +26,14 @@ void state_init(int sock_fd) {
     peer_list_init(&state.peer_list);
     peer_possibilities_init(&state.peer_possibilities);
     state.offset = 0;
-    state.sync_source = NULL;
+    state.sync_source = PEER_NONE;
+
+    // Scratch buffers: only the pages a message actually uses become resident.
+    state.recv_buf = malloc(MSG_MAX_SIZE);
+    state.send_buf = malloc(MSG_MAX_SIZE);
+    state.peer_infos = malloc(PEER_MAX * sizeof(peer_info_t));
+    if (!state.recv_buf || !state.send_buf || !state.peer_infos)
+        fatal("Cannot allocate message buffers");
 
     // Initialize time tracking
     struct timespec ts;
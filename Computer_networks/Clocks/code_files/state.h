@@ -17,10 +17,13 @@ typedef struct {
     peer_possibilities_t peer_possibilities; /* List of possible peers (for connection tracking) */
     uint64_t start_time;            /* Time when the node started (ms since CLOCK_MONOTONIC) */
     uint64_t current_time;          /* Current time (ms relative to start_time) */
-    peer_t *sync_source;            /* Pointer to the current synchronization source */
+    size_t sync_source;             /* Position of the current synchronization source in peer_list, PEER_NONE if none */
     uint8_t level;                  /* Synchronization level (0 = leader, 255 = not synchronized) */
     int64_t offset;                 /* Time offset if synchronized */
     uint64_t last_sync_reply;       /* Timestamp of last SYNC_START reply */
+    uint8_t *recv_buf;              /* Received message (MSG_MAX_SIZE bytes) */
+    uint8_t *send_buf;              /* Message being built for sending (MSG_MAX_SIZE bytes) */
+    peer_info_t *peer_infos;        /* Peers listed in a HELLO_REPLY (PEER_MAX entries) */
 } node_state_t;
 
 /* Global node state instance. */
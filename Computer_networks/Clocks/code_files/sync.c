@@ -25,10 +25,10 @@ void sync_broadcast(void) {
     if (state.level >= 254) return;
 
     for (uint16_t i = 0; i < state.peer_list.count; ++i) {
-        peer_t *p = &state.peer_list.peers[i];
+        const struct sockaddr_in *addr = &state.peer_list.addrs[i];
         // printf("Broadcast SYNC_START to %s:%d\n",
-        //        inet_ntoa(p->addr.sin_addr), ntohs(p->addr.sin_port));
-        send_sync_start(&p->addr, p);
+        //        inet_ntoa(addr->sin_addr), ntohs(addr->sin_port));
+        send_sync_start(addr, &state.peer_list.peers[i]);
     }
 }
 
@@ -40,12 +40,12 @@ void sync_broadcast(void) {
  */
 void send_sync_start(const struct sockaddr_in *dst, peer_t *p) {
     update_current_time();
-    uint64_t T1 = state.current_time - (state.sync_source ? state.offset : 0);
+    uint64_t T1 = state.current_time - (state.sync_source != PEER_NONE ? state.offset : 0);
     p->last_message_to_sync = state.current_time;
     p->attempted_to_sync = true;
 
-    uint8_t buf[MSG_MAX_SIZE];
-    size_t len = msg_build_sync_start(buf, sizeof(buf), state.level, T1);
+    uint8_t *buf = state.send_buf;
+    size_t len = msg_build_sync_start(buf, MSG_MAX_SIZE, state.level, T1);
     if (!len) {
         fprintf(stderr, "ERROR: msg_build_sync_start failed\n");
         return;
@@ -74,7 +74,7 @@ void sync_start_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
 
     uint8_t lvl;
     uint64_t T1;
-    uint64_t T2 = state.current_time - (state.sync_source ? state.offset : 0);
+    uint64_t T2 = state.current_time - (state.sync_source != PEER_NONE ? state.offset : 0);
     peer_t *p = peer_list_find(&state.peer_list, src);
 
     // Incorrect messages
@@ -83,12 +83,14 @@ void sync_start_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
         return;
     }
 
+    bool from_source = peer_list_position(&state.peer_list, p) == state.sync_source;
+
     // Ignored messages
-    if ((lvl >= state.level / 2 && p != state.sync_source) || lvl >= state.level)
+    if ((lvl >= state.level / 2 && !from_source) || lvl >= state.level)
         return;
 
     // Message from the source but they have a greater level now
-    if (p == state.sync_source && lvl >= state.level) {
+    if (from_source && lvl >= state.level) {
         ditch_leader();
         return;
     }
@@ -102,10 +104,10 @@ void sync_start_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
     // printf("Responder: SYNC_START(level=%u,T1=%" PRIu64 ") from %s:%d at T2=%" PRIu64 "\n",
     //    lvl, T1, inet_ntoa(src->sin_addr), ntohs(src->sin_port), T2);
     update_current_time();
-    p->T3 = state.current_time - (state.sync_source ? state.offset : 0);
+    p->T3 = state.current_time - (state.sync_source != PEER_NONE ? state.offset : 0);
 
-    uint8_t dr[MSG_MAX_SIZE];
-    size_t dr_len = msg_build_delay_request(dr, sizeof(dr));
+    uint8_t *dr = state.send_buf;
+    size_t dr_len = msg_build_delay_request(dr, MSG_MAX_SIZE);
     if (dr_len) {
         // printf("Sending: DELAY_REQUEST -> %s:%d\n",
         //        inet_ntoa(src->sin_addr), ntohs(src->sin_port));
@@ -122,7 +124,7 @@ void sync_start_handle(const uint8_t *buf, size_t len, const struct sockaddr_in
  */
 void delay_request_handle(const uint8_t *buf, size_t len, const struct sockaddr_in *src) {
     update_current_time();
-    uint64_t T4 = state.current_time - (state.sync_source ? state.offset : 0);
+    uint64_t T4 = state.current_time - (state.sync_source != PEER_NONE ? state.offset : 0);
     peer_t *p = peer_list_find(&state.peer_list, src);
 
     // Incorrect messages
@@ -141,8 +143,8 @@ void delay_request_handle(const uint8_t *buf, size_t len, const struct sockaddr_
     // printf("Received DELAY_REQUEST from %s:%d at T3=%" PRIu64 "\n",
     //        inet_ntoa(src->sin_addr), ntohs(src->sin_port), T4);
 
-    uint8_t resp[MSG_MAX_SIZE];
-    size_t resp_len = msg_build_delay_response(resp, sizeof(resp), state.level, T4);
+    uint8_t *resp = state.send_buf;
+    size_t resp_len = msg_build_delay_response(resp, MSG_MAX_SIZE, state.level, T4);
     if (resp_len > 0) {
         // printf("Sending DELAY_RESPONSE(T4=%" PRIu64 ") to %s:%d\n",
         //        T4, inet_ntoa(src->sin_addr), ntohs(src->sin_port));
@@ -185,7 +187,7 @@ void delay_response_handle(const uint8_t *buf, size_t len, const struct sockaddr
       + (int64_t)p->T3 - (int64_t)T4;
     offset /= 2;
     state.offset = offset;
-    state.sync_source = p;
+    state.sync_source = peer_list_position(&state.peer_list, p);
     state.level = lvl + 1;
     state.last_sync_reply = 0;
 
@@ -211,9 +213,9 @@ void get_time_handle(const uint8_t *buf, size_t len, const struct sockaddr_in *s
     // printf("Received GET_TIME request from %s:%d\n", inet_ntoa(src->sin_addr), ntohs(src->sin_port));
 
     update_current_time();
-    uint8_t time_buf[MSG_MAX_SIZE];
-    uint64_t current_time = state.current_time - (state.sync_source ? state.offset : 0);
-    size_t time_len = msg_build_time(time_buf, sizeof(time_buf), state.level, current_time);
+    uint8_t *time_buf = state.send_buf;
+    uint64_t current_time = state.current_time - (state.sync_source != PEER_NONE ? state.offset : 0);
+    size_t time_len = msg_build_time(time_buf, MSG_MAX_SIZE, state.level, current_time);
     if (time_len > 0) {
         // printf("Sending TIME response to %s:%d\n", inet_ntoa(src->sin_addr), ntohs(src->sin_port));  // Debug print
         udp_sendto(state.sock_fd, time_buf, time_len, src);
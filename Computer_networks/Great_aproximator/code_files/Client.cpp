@@ -11,55 +11,52 @@
 #include <arpa/inet.h>  // inet_ntop
 #include <fcntl.h>      // fcntl
 
+#include "LineBuffer.hpp"
 #include "ManualInput.hpp"
 #include "Strategy.hpp"
 #include "utils.hpp"
+#include "binary_protocol.hpp"
 #include "protocol.hpp"
 
 /**
- * @brief Attempts to connect to the server using the address list from getaddrinfo.
+ * @brief Attempts to connect to the server at each of its resolved addresses in turn.
+ *
+ * A host of the form "unix:<path>" is a Unix-domain socket on this machine.
  *
  * @return Socket descriptor on success, or -1 on failure.
  */
 int connectToServer(const std::string &host, int port,
                     bool forceIPv4, bool forceIPv6, std::string &outIP)
 {
-    struct addrinfo hints, *res, *rp;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_flags    = AI_ADDRCONFIG;
-    hints.ai_protocol = 0;
-
+    int family = AF_UNSPEC;
     if (forceIPv4 && !forceIPv6) {
-        hints.ai_family = AF_INET;
+        family = AF_INET;
     } else if (forceIPv6 && !forceIPv4) {
-        hints.ai_family = AF_INET6;
-    } else {
-        hints.ai_family = AF_UNSPEC;
+        family = AF_INET6;
     }
 
-    std::string portStr = std::to_string(port);
-    int gaiErr = getaddrinfo(host.c_str(), portStr.c_str(), &hints, &res);
-    if (gaiErr != 0) {
-        std::cerr << "ERROR: getaddrinfo: " << gai_strerror(gaiErr) << "\n";
-        return -1;
-    }
+    std::vector<SocketAddress> addresses;
+    if (!resolveServer(host, port, family, addresses)) return -1;
 
     int sockfd = -1;
     char ipbuf[INET6_ADDRSTRLEN];
 
-    for (rp = res; rp != nullptr; rp = rp->ai_next) {
-        sockfd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+    for (const SocketAddress &address : addresses) {
+        sockfd = socket(address.family, SOCK_STREAM, 0);
         if (sockfd < 0) continue;
 
-        if (connect(sockfd, rp->ai_addr, rp->ai_addrlen) == 0) {
-            void *addr;
-            if (rp->ai_family == AF_INET) {
-                addr = &((struct sockaddr_in*)rp->ai_addr)->sin_addr;
+        if (connect(sockfd, (const struct sockaddr*)&address.addr, address.length) == 0) {
+            if (address.family == AF_UNIX) {
+                outIP = host;
+                break;
+            }
+            const void *addr;
+            if (address.family == AF_INET) {
+                addr = &((const struct sockaddr_in*)&address.addr)->sin_addr;
             } else {
-                addr = &((struct sockaddr_in6*)rp->ai_addr)->sin6_addr;
+                addr = &((const struct sockaddr_in6*)&address.addr)->sin6_addr;
             }
-            inet_ntop(rp->ai_family, addr, ipbuf, sizeof(ipbuf));
+            inet_ntop(address.family, addr, ipbuf, sizeof(ipbuf));
             outIP = ipbuf;
             break;
         }
@@ -68,7 +65,6 @@ int connectToServer(const std::string &host, int port,
         sockfd = -1;
     }
 
-    freeaddrinfo(res);
     if (sockfd < 0) {
         std::cerr << "ERROR: failed to connect to " << host << ":" << port << "\n";
         return -1;
@@ -76,6 +72,93 @@ int connectToServer(const std::string &host, int port,
     return sockfd;
 }
 
+/**
+ * @brief Blocks until the COEFF line arrives and parses it; exits on any error.
+ *
+ * @param sockfd Blocking socket connected to the server.
+ * @param input Line buffer of the socket; handed to the game loop afterwards, so nothing
+ *              sent right after COEFF is lost.
+ * @param coeffs Output: the coefficients.
+ */
+static void receiveTextCOEFF(int sockfd, LineBuffer &input, std::vector<double> &coeffs) {
+    std::string_view line;
+    bool closed = false;
+    while (!input.nextLine(line)) {
+        if (closed || input.full()) {
+            std::cerr << "ERROR: unexpected disconnect or failed to read COEFF\n";
+            close(sockfd);
+            exit(1);
+        }
+        closed = input.fill(sockfd) == LineBuffer::FillStatus::Closed;
+    }
+
+    std::vector<std::string_view> tokens;
+    splitBySpace(line, tokens);
+    if (tokens.empty() || tokens[0] != "COEFF") {
+        std::cerr << "ERROR: bad message instead of COEFF: " << line << "\n";
+        close(sockfd);
+        exit(1);
+    }
+    if (tokens.size() > 9) {
+        std::cerr << "ERROR: too many arguments in COEFF: " << line << "\n";
+        close(sockfd);
+        exit(1);
+    }
+    if (tokens.size() < 2) {
+        std::cerr << "ERROR: COEFF message has no coefficients: `" << line << "`\n";
+        close(sockfd);
+        exit(1);
+    }   
+
+    coeffs.reserve(tokens.size() - 1);
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        double v;
+        if (!parseReal(tokens[i], v)) {
+            std::cerr << "ERROR: invalid coefficient in COEFF: " << tokens[i] << "\n";
+            close(sockfd);
+            exit(1);
+        }
+        coeffs.push_back(v);
+    }
+}
+
+/**
+ * @brief Blocks until the binary COEFF frame arrives and parses it; exits on any error.
+ *
+ * @param sockfd Blocking socket connected to the server (after HELLO_BIN).
+ * @param input Input buffer of the socket; handed to the game loop afterwards.
+ * @param coeffs Output: the coefficients.
+ */
+static void receiveBinaryCOEFF(int sockfd, LineBuffer &input, std::vector<double> &coeffs) {
+    std::string_view frame;
+    LineBuffer::FrameStatus status;
+    bool closed = false;
+    while ((status = input.nextFrame(frame)) == LineBuffer::FrameStatus::Incomplete) {
+        if (closed) break;
+        closed = input.fill(sockfd) == LineBuffer::FillStatus::Closed;
+    }
+    if (status != LineBuffer::FrameStatus::Complete) {
+        std::cerr << "ERROR: unexpected disconnect or failed to read COEFF\n";
+        close(sockfd);
+        exit(1);
+    }
+
+    FrameType type;
+    std::string_view payload;
+    if (!splitFrame(frame, type, payload) || type != FrameType::COEFF) {
+        std::cerr << "ERROR: bad frame instead of COEFF (type "
+                  << static_cast<int>(frame[0]) << ")\n";
+        close(sockfd);
+        exit(1);
+    }
+    if (!parseBinaryDoubles(payload, coeffs) || coeffs.size() > 8) {
+        std::cerr << "ERROR: COEFF frame must carry 1 to 8 coefficients ("
+                  << payload.size() << " payload bytes)\n";
+        close(sockfd);
+        exit(1);
+    }
+}
+
 /**
  * @brief Entry point for the client gameplay logic.
  *
@@ -92,13 +175,19 @@ int connectToServer(const std::string &host, int port,
  * @param forceIPv4 Whether to force IPv4 usage.
  * @param forceIPv6 Whether to force IPv6 usage.
  * @param autoMode Whether to use automatic strategy instead of manual input.
+ * @param roomId Room to join, sent in HELLO (empty to let the server place the player).
+ * @param binary Whether to negotiate binary frames (auto mode only).
+ * @param budget Maximum number of PUTs in auto mode (negative: unlimited).
  */
 void runClient(const std::string &playerId,
                const std::string &serverAddr,
                int port,
                bool forceIPv4,
                bool forceIPv6,
-               bool autoMode)
+               bool autoMode,
+               const std::string &roomId,
+               bool binary,
+               long budget)
 {
     // 1) Establish TCP connection to the server.
     std::string resolvedIP;
@@ -107,56 +196,28 @@ void runClient(const std::string &playerId,
         // connectToServer already printed an error
         exit(1);
     }
-    std::cout << "Connected to [" << resolvedIP << "]:" << port << ".\n";
+    if (isLocalAddress(resolvedIP)) {
+        std::cout << "Connected to " << resolvedIP << ".\n";
+    } else {
+        std::cout << "Connected to [" << resolvedIP << "]:" << port << ".\n";
+    }
 
     // 2) Send HELLO immediately.
-    std::string helloMsg = makeHELLO(playerId);
+    std::string helloMsg = makeHELLO(playerId, roomId, binary);
     if (!writeAll(sockfd, helloMsg)) {
         std::cerr << "ERROR: failed to send HELLO\n";
         close(sockfd);
         exit(1);
     }
 
-    // 3) Block until we receive a COEFF line.  Socket is still in blocking mode.
-    bool success = false;
-    std::string line;
-    do {
-        line = readLine(sockfd, success);
-        if (!success) {
-            std::cerr << "ERROR: unexpected disconnect or failed to read COEFF\n";
-            close(sockfd);
-            exit(1);
-        }
-    } while (line.empty()); // readLine may return "" with success=false if no full "\r\n" yet
-
-    // 4) Parse the COEFF message.
-    auto tokens = splitBySpace(line);
-    if (tokens.empty() || tokens[0] != "COEFF") {
-        std::cerr << "ERROR: bad message instead of COEFF: " << line << "\n";
-        close(sockfd);
-        exit(1);
-    }
-    if (tokens.size() > 9) {
-        std::cerr << "ERROR: too many arguments in COEFF: " << line << "\n";
-        close(sockfd);
-        exit(1);
-    }
-    if (tokens.size() < 2) {
-        std::cerr << "ERROR: COEFF message has no coefficients: `" << line << "`\n";
-        close(sockfd);
-        exit(1);
-    }   
-
+    // 3) Block until we receive COEFF.  Socket is still in blocking mode.
+    //    The same buffer is handed to the game loop, so nothing sent right after COEFF is lost.
+    LineBuffer input;
     std::vector<double> coeffs;
-    coeffs.reserve(tokens.size() - 1);
-    for (size_t i = 1; i < tokens.size(); ++i) {
-        double v;
-        if (!parseReal(tokens[i], v)) {
-            std::cerr << "ERROR: invalid coefficient in COEFF: " << tokens[i] << "\n";
-            close(sockfd);
-            exit(1);
-        }
-        coeffs.push_back(v);
+    if (binary) {
+        receiveBinaryCOEFF(sockfd, input, coeffs);
+    } else {
+        receiveTextCOEFF(sockfd, input, coeffs);
     }
 
     std::cout << "Received coefficients";
@@ -165,16 +226,16 @@ void runClient(const std::string &playerId,
     }
     std::cout << ".\n";
 
-    // 5) Switch stdin and the socket to non-blocking mode now that COEFF is handled.
+    // 4) Switch stdin and the socket to non-blocking mode now that COEFF is handled.
 
-    // 5a) stdin → non-blocking
+    // 4a) stdin → non-blocking
     if (!configureStdinNonBlocking()) {
         std::cerr << "ERROR: failed to set stdin to non-blocking\n";
         close(sockfd);
         exit(1);
     }
 
-    // 5b) socket → non-blocking
+    // 4b) socket → non-blocking
     int flags = fcntl(sockfd, F_GETFL, 0);
     if (flags < 0) {
         std::cerr << "ERROR: fcntl(F_GETFL): " << strerror(errno) << "\n";
@@ -187,11 +248,11 @@ void runClient(const std::string &playerId,
         exit(1);
     }
 
-    // 6) Jump directly into the chosen mode (auto or manual).
+    // 5) Jump directly into the chosen mode (auto or manual).
     if (autoMode) {
-        runAutoMode(sockfd, playerId, resolvedIP, port, coeffs);
+        runAutoMode(sockfd, input, playerId, resolvedIP, port, coeffs, binary, budget);
     } else {
-        runManualMode(sockfd, playerId, resolvedIP, port);
+        runManualMode(sockfd, input, playerId, resolvedIP, port);
     }
 
     // Once runAutoMode()/runManualMode() returns, close the socket.
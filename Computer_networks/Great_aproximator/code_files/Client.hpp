@@ -5,13 +5,13 @@
 #include <vector>
 
 /**
- * @brief Connects to the specified server using IPv4 or IPv6.
+ * @brief Connects to the specified server using IPv4, IPv6 or a Unix-domain socket.
  *
- * @param host Hostname or IP address of the server.
- * @param port Port number.
+ * @param host Hostname or IP address of the server, or "unix:<path>".
+ * @param port Port number (not used for a Unix-domain socket).
  * @param forceIPv4 If true, forces IPv4 connection.
  * @param forceIPv6 If true, forces IPv6 connection.
- * @param outIP Output: string with resolved IP address.
+ * @param outIP Output: string with resolved IP address (or the "unix:" address).
  * @return int Socket descriptor on success, -1 on failure.
  */
 int connectToServer(const std::string &host,
@@ -29,12 +29,18 @@ int connectToServer(const std::string &host,
  * @param forceIPv4 Force IPv4.
  * @param forceIPv6 Force IPv6.
  * @param autoMode If true, uses automatic strategy.
+ * @param roomId Room to join (empty to let the server place the player).
+ * @param binary Negotiate binary frames with HELLO_BIN (auto mode only).
+ * @param budget Maximum number of PUTs in auto mode (negative: unlimited).
  */
 void runClient(const std::string &playerId,
                const std::string &serverAddr,
                int port,
                bool forceIPv4,
                bool forceIPv6,
-               bool autoMode);
+               bool autoMode,
+               const std::string &roomId,
+               bool binary,
+               long budget);
 
 #endif // CLIENT_HPP
@@ -1,60 +1,135 @@
 #ifndef CLIENTSTATE_HPP
 #define CLIENTSTATE_HPP
 
-#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "LineBuffer.hpp"
+#include "OutputQueue.hpp"
+#include "Snapshot.hpp"
+#include "StateEncoder.hpp"
+#include "TokenBucket.hpp"
+
+struct Room;
+
+/**
+ * @brief Data of a client needed only at HELLO, for BAD_PUT, in log messages and at the
+ *        end of the game; kept out of ClientState so the per-event data stays compact.
+ */
+struct ClientProfile {
+    /// Player identifier received from HELLO message.
+    std::string playerId;
+
+    /// Room ID requested in HELLO (empty: matchmaking or the global game).
+    std::string roomName;
+
+    /// Coefficients of the polynomial sent to the client (shared with the COEFF store).
+    std::shared_ptr<const std::vector<double>> coeffs;
+
+    /// Full BAD_PUT message (or frame) to be sent.
+    std::string badPutMsg;
+
+    /// State from the snapshot of a restarted server, applied when the player joins its game.
+    std::unique_ptr<SnapshotPlayer> restored;
+};
+
 /**
  * @brief Represents the state of a connected client during the game.
+ *
+ * Holds what the event loop touches on every message and timer; the rest is in
+ * `profile`. The approximation f̂(0..K) lives in the ClientTable's arena, in the row
+ * of the client's slot.
  */
 struct ClientState {
     /// File descriptor for the client socket.
     int sockfd;
 
-    /// Player identifier received from HELLO message.
-    std::string playerId;
+    /// Index of the client in its ClientTable (set by ClientTable::insert()).
+    uint32_t slot = 0;
+
+    /// Connection number in the traffic trace (0 if traffic is not recorded).
+    uint32_t traceId = 0;
 
     /// Number of lowercase letters in the playerId (used for delay calculation).
     int lowercase = 0;
 
-    /// Indicates whether the COEFF message has been sent to this client.
-    bool hasSentCoeff = false;
+    /// Total penalty points accumulated by this client.
+    int penalty = 0;
 
-    /// Deadline for receiving HELLO message after connection (3s timeout).
-    std::chrono::steady_clock::time_point helloDeadline;
+    /// Number of correct PUTs sent by this client.
+    int correctPutCountForThisClient = 0;
 
-    /// Coefficients of the polynomial sent to the client.
-    std::vector<double> coeffs;
+    /// The client sent HELLO_BIN: all messages after HELLO are binary frames.
+    bool binary = false;
 
-    /// Current state of the approximation function f̂(0..K).
-    std::vector<double> approx;
+    /// The game ended for this client; it is closed once SCORING has been flushed.
+    bool closing = false;
 
-    // Delayed responses
+    /// Indicates whether the COEFF message has been sent to this client.
+    bool hasSentCoeff = false;
 
     /// Whether a BAD_PUT message is pending to be sent after 1 second.
     bool pendingBadPut = false;
 
-    /// Full BAD_PUT message to be sent.
-    std::string badPutMsg;
-
-    /// Timestamp when BAD_PUT should be sent.
-    std::chrono::steady_clock::time_point badPutAt;
-
     /// Whether a STATE message is pending to be sent after delay.
     bool pendingState = false;
 
-    /// Full STATE message to be sent.
-    std::string stateMsg;
+    /// Counted among the connections awaiting HELLO (see GameCoordinator::admitConnection()).
+    bool awaitingHello = false;
 
-    /// Timestamp when STATE should be sent.
-    std::chrono::steady_clock::time_point stateAt;
+    /// The client sent HELLO for the global game during the pause after the last one;
+    /// its reads are paused and it joins when the next game starts.
+    bool waitingForRound = false;
 
-    /// Number of correct PUTs sent by this client.
-    int correctPutCountForThisClient = 0;
+    /// The client ran out of rate-limit tokens and has not caught up since; its reads
+    /// are paused while `resumeTimer` is pending.
+    bool throttled = false;
 
-    /// Total penalty points accumulated by this client.
-    int penalty = 0;
+    /// Timer closing the connection if HELLO does not arrive within 3s.
+    uint64_t helloTimer = 0;
+
+    /// Timer sending the pending BAD_PUT (only the latest one is live).
+    uint64_t badPutTimer = 0;
+
+    /// Timer sending the pending STATE.
+    uint64_t stateTimer = 0;
+
+    /// Timer resuming the reads of a throttled client.
+    uint64_t resumeTimer = 0;
+
+    /// Timer closing a closing client that has not read SCORING within LINGER_TIMEOUT.
+    uint64_t lingerTimer = 0;
+
+    /// Lines (or frames) the client may still send now (server option -l).
+    TokenBucket lineTokens;
+
+    /// Bytes the client may still send now (server option -b).
+    TokenBucket byteTokens;
+
+    /// Room the player is in, or nullptr for the global game.
+    Room *room = nullptr;
+
+    /// Bytes received from the client, framed into lines or binary frames.
+    LineBuffer input;
+
+    /// Messages waiting to be written to the client's socket.
+    OutputQueue output;
+
+    /// Encoded STATE message (or frame), updated slot by slot on every correct PUT.
+    StateEncoder stateMsg;
+
+    /// Points of f̂ the client has changed, so a snapshot reads only these; sorted, and
+    /// cleared of repeats and of points back at zero, whenever the record is encoded.
+    std::vector<uint32_t> touchedPoints;
+
+    /// The client's record in the last snapshot; cleared whenever its penalty, correct
+    /// PUTs or f̂ change, so only changed clients are encoded again.
+    std::string snapshotRecord;
+
+    /// Player ID, room request, coefficients and BAD_PUT text.
+    std::unique_ptr<ClientProfile> profile;
 
     /**
      * @brief Constructs a ClientState object.
@@ -64,9 +139,9 @@ struct ClientState {
      */
     ClientState(int fd, int K)
         : sockfd(fd),
-          coeffs(),
-          approx(K + 1, 0.0)
+          stateMsg(K),
+          profile(std::make_unique<ClientProfile>())
     {}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,38 @@
+#include "ClientTable.hpp"
+
+#include <algorithm>
+
+ClientTable::ClientTable(int K) : rowSize(static_cast<size_t>(K) + 1) {}
+
+ClientState &ClientTable::insert(ClientState &&state) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        // The most recently freed slot is the most likely to still be cached.
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+        arena.resize(arena.size() + rowSize);
+    }
+
+    const int fd = state.sockfd;
+    if (static_cast<size_t>(fd) >= slotOfFd.size()) {
+        slotOfFd.resize(std::max(static_cast<size_t>(fd) + 1, slotOfFd.size() * 2), -1);
+    }
+    slotOfFd[fd] = static_cast<int32_t>(slot);
+
+    ClientState &stored = slots[slot].emplace(std::move(state));
+    stored.slot = slot;
+    std::fill_n(approx(stored), rowSize, 0.0);
+    ++count;
+    return stored;
+}
+
+void ClientTable::erase(int fd) {
+    int32_t slot = slotOfFd[fd];
+    slotOfFd[fd] = -1;
+    slots[slot].reset();
+    freeSlots.push_back(static_cast<uint32_t>(slot));
+    --count;
+}
@@ -0,0 +1,85 @@
+#ifndef CLIENT_TABLE_HPP
+#define CLIENT_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ClientState.hpp"
+
+/**
+ * @brief Clients of one shard, looked up by socket descriptor in O(1).
+ *
+ * Clients live in a dense array of slots; a per-descriptor array maps a socket to its
+ * slot, so finding the client of a ready socket or an expired timer is two array reads
+ * instead of a tree walk. Freed slots are reused before the array grows, so it stays
+ * about as large as the number of clients and a scan over all of them is a linear pass.
+ *
+ * The approximations f̂(0..K) of all clients are rows of one contiguous arena, indexed
+ * by slot, instead of one heap block per client.
+ *
+ * Inserting may move the clients (the arrays grow), so a reference or approx() pointer
+ * stays valid only until the next insert(); erasing never moves other clients.
+ */
+class ClientTable {
+public:
+    /**
+     * @param K Maximum point index (an approximation row holds K + 1 values).
+     */
+    explicit ClientTable(int K);
+
+    /**
+     * @brief Returns the client using the socket, or nullptr if it is not in the table.
+     */
+    ClientState *find(int fd) {
+        if (fd < 0 || static_cast<size_t>(fd) >= slotOfFd.size()) return nullptr;
+        int32_t slot = slotOfFd[fd];
+        return slot < 0 ? nullptr : &*slots[slot];
+    }
+
+    /**
+     * @brief Adds a client under its socket descriptor, with an all-zero approximation.
+     *
+     * @param state The client (state.sockfd must not be in the table yet).
+     * @return The stored client.
+     */
+    ClientState &insert(ClientState &&state);
+
+    /**
+     * @brief Removes the client using the socket (it must be in the table).
+     */
+    void erase(int fd);
+
+    /// Number of clients.
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the client's approximation f̂(0..K).
+     */
+    double *approx(const ClientState &state) {
+        return arena.data() + static_cast<size_t>(state.slot) * rowSize;
+    }
+
+    /**
+     * @brief Calls fn(ClientState &) for every client, in slot order.
+     *
+     * fn must not insert or erase clients.
+     */
+    template <typename Fn>
+    void forEach(Fn &&fn) {
+        for (auto &slot : slots) {
+            if (slot) fn(*slot);
+        }
+    }
+
+private:
+    size_t rowSize;                              ///< K + 1.
+    std::vector<int32_t> slotOfFd;               ///< Socket → slot, -1 if none.
+    std::vector<std::optional<ClientState>> slots;
+    std::vector<uint32_t> freeSlots;             ///< Empty slots, most recently freed last.
+    std::vector<double> arena;                   ///< Approximation rows, one per slot.
+    size_t count = 0;
+};
+
+#endif // CLIENT_TABLE_HPP
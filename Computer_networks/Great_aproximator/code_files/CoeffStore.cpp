@@ -0,0 +1,131 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CoeffStore.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+#include "utils.hpp"
+
+CoeffStore::CoeffStore(std::string filename, Order order)
+    : filename(std::move(filename)), order(order) {}
+
+bool CoeffStore::parseOrder(const std::string &name, Order &out) {
+    if (name == "seq")    { out = Order::Sequential; return true; }
+    if (name == "wrap")   { out = Order::Wrap;       return true; }
+    if (name == "random") { out = Order::Random;     return true; }
+    return false;
+}
+
+/**
+ * @brief Encodes the COEFF messages of an entry whose coefficients are set.
+ */
+static void encodeEntry(CoeffStore::Entry &entry) {
+    std::string msg = "COEFF";
+    for (double v : entry.coeffs) msg += " " + std::to_string(v);
+    msg += CRLF;
+    entry.message = std::make_shared<const std::string>(std::move(msg));
+    entry.binaryMessage = std::make_shared<const std::string>(
+        makeDoublesFrame(FrameType::COEFF, entry.coeffs));
+}
+
+/**
+ * @brief Parses one line of the file into an entry with its encoded COEFF messages.
+ *
+ * @return false if the line is not a valid COEFF message.
+ */
+static bool parseEntry(std::string_view line, std::vector<std::string_view> &tokens,
+                       CoeffStore::Entry &entry)
+{
+    splitBySpace(line, tokens);
+    if (!parseCOEFF(tokens, entry.coeffs)) return false;
+    encodeEntry(entry);
+    return true;
+}
+
+std::shared_ptr<const CoeffStore::Entry> CoeffStore::makeEntry(std::vector<double> coeffs) {
+    auto entry = std::make_shared<Entry>();
+    entry->coeffs = std::move(coeffs);
+    encodeEntry(*entry);
+    return entry;
+}
+
+bool CoeffStore::load() {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: unable to open file " << filename << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        std::cerr << "ERROR: no COEFF lines in file " << filename << "\n";
+        close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "ERROR: mmap(" << filename << "): " << strerror(errno) << "\n";
+        return false;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    std::string_view text(static_cast<const char*>(data), st.st_size);
+    std::vector<std::string_view> tokens;
+    size_t lineNo = 0;
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        ++lineNo;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        Entry entry;
+        if (!parseEntry(line, tokens, entry)) {
+            std::cerr << "ERROR: invalid COEFF line " << lineNo << " in file: " << line << "\n";
+            continue;
+        }
+        snapshot->entries.push_back(std::move(entry));
+    }
+    munmap(data, st.st_size);
+
+    if (snapshot->entries.empty()) {
+        std::cerr << "ERROR: no valid COEFF lines in file " << filename << "\n";
+        return false;
+    }
+    std::cout << "Loaded " << snapshot->entries.size() << " COEFF lines from "
+              << filename << ".\n";
+    std::atomic_store(&current, std::move(snapshot));
+    return true;
+}
+
+std::shared_ptr<const CoeffStore::Entry> CoeffStore::next() {
+    std::shared_ptr<Snapshot> snapshot = std::atomic_load(&current);
+    if (!snapshot) return nullptr;
+
+    const size_t count = snapshot->entries.size();
+    size_t index;
+    if (order == Order::Random) {
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        index = std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+    } else if (order == Order::Wrap) {
+        index = cursor.fetch_add(1, std::memory_order_relaxed) % count;
+    } else {
+        // Refused players do not move the cursor, so a longer file loaded later goes on
+        // with the first line nobody has received.
+        uint64_t n = cursor.load(std::memory_order_relaxed);
+        do {
+            if (n >= count) return nullptr;
+        } while (!cursor.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+        index = n;
+    }
+    // Shares ownership of the snapshot, so a reload cannot free the entry.
+    return std::shared_ptr<const Entry>(snapshot, &snapshot->entries[index]);
+}
@@ -0,0 +1,94 @@
+#ifndef COEFF_STORE_HPP
+#define COEFF_STORE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief COEFF lines of the server, parsed and encoded in advance.
+ *
+ * The file is memory-mapped and parsed once, at startup or on reload; every valid line
+ * becomes an entry holding the coefficients and the ready COEFF wire messages (text and
+ * binary). Handing out a COEFF on HELLO is then an index computation and a reference
+ * count increment; it never touches the filesystem or parses anything.
+ *
+ * A reload builds a complete new snapshot aside and publishes it with one atomic pointer
+ * swap, so the event loops are never blocked by it. Clients that already received a
+ * COEFF keep their copy of the coefficients. The position in the file is kept across
+ * reloads: the Sequential order goes on with the next line number of the new file (and
+ * refuses players if the new file is not that long) instead of starting over.
+ */
+class CoeffStore {
+public:
+    /// How entries are handed out to consecutive players.
+    enum class Order {
+        Sequential, ///< Each line once, in file order; then players are refused.
+        Wrap,       ///< In file order, starting over after the last line.
+        Random      ///< Uniformly random line for every player.
+    };
+
+    /// One COEFF line.
+    struct Entry {
+        std::vector<double> coeffs;                  ///< Parsed coefficients a0..aN.
+        std::shared_ptr<const std::string> message;       ///< "COEFF a0 ... aN\r\n".
+        std::shared_ptr<const std::string> binaryMessage; ///< Binary COEFF frame.
+    };
+
+    /**
+     * @brief Creates an empty store; call load() before use.
+     *
+     * @param filename File with one COEFF line per player.
+     * @param order How entries are handed out.
+     */
+    CoeffStore(std::string filename, Order order);
+
+    /**
+     * @brief Parses the file into a new snapshot and publishes it.
+     *
+     * Invalid lines are reported and skipped. On failure (file unreadable or no valid
+     * line) the previous snapshot stays in use. Safe to call while other threads
+     * call next(); meant for startup and for the SIGHUP handler thread.
+     *
+     * @return true if a new snapshot was published, false otherwise.
+     */
+    bool load();
+
+    /**
+     * @brief Picks the COEFF for the next player (safe to call from any shard).
+     *
+     * @return The entry, or nullptr if the Sequential order has used up all lines.
+     *         The entry stays valid as long as the returned pointer is held.
+     */
+    std::shared_ptr<const Entry> next();
+
+    /**
+     * @brief Builds an entry, with its encoded COEFF messages, from coefficients.
+     *
+     * Used for the COEFF of a player restored from a snapshot (see SnapshotStore).
+     */
+    static std::shared_ptr<const Entry> makeEntry(std::vector<double> coeffs);
+
+    /**
+     * @brief Parses an order name ("seq", "wrap" or "random").
+     *
+     * @return true if the name is valid, false otherwise.
+     */
+    static bool parseOrder(const std::string &name, Order &out);
+
+private:
+    /// Entries of one version of the file.
+    struct Snapshot {
+        std::vector<Entry> entries;
+    };
+
+    const std::string filename;
+    const Order order;
+    std::shared_ptr<Snapshot> current; ///< Accessed only with std::atomic_load/store.
+    /// Next entry for Sequential and Wrap; outside the snapshot, so it survives reloads.
+    std::atomic<uint64_t> cursor{0};
+};
+
+#endif // COEFF_STORE_HPP
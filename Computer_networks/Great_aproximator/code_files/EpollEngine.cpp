@@ -0,0 +1,196 @@
+#include "EpollEngine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <sys/socket.h>
+
+EpollEngine::~EpollEngine() {
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool EpollEngine::open() {
+    epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        std::cerr << "ERROR: epoll_create1(): " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds a descriptor to an epoll instance, printing the error on failure.
+ */
+static bool watch(int epollFd, int fd, uint32_t events) {
+    struct epoll_event ev{};
+    ev.events  = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::cerr << "ERROR: epoll_ctl(ADD): " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool EpollEngine::addListener(int fd, bool shared) {
+    // EPOLLEXCLUSIVE: a new connection on a shared socket wakes one shard, not all.
+    if (!watch(epollFd, fd, EPOLLIN | EPOLLET | (shared ? uint32_t(EPOLLEXCLUSIVE) : 0))) return false;
+    listeners.push_back(fd);
+    return true;
+}
+
+bool EpollEngine::setWakeFd(int fd) {
+    if (!watch(epollFd, fd, EPOLLIN | EPOLLET)) return false;
+    wakeFd = fd;
+    return true;
+}
+
+void EpollEngine::forget(int fd) {
+    if (static_cast<size_t>(fd) < paused.size()) paused[fd] = 0;
+    if (static_cast<size_t>(fd) < hungUp.size()) hungUp[fd] = 0;
+}
+
+bool EpollEngine::addClient(int fd) {
+    forget(fd);
+    syscalls.add();
+    // EPOLLOUT only fires on the not-writable → writable edge, i.e. when a blocked
+    // output queue can make progress again.
+    return watch(epollFd, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+}
+
+bool EpollEngine::releaseClient(int fd, LineBuffer &, OutputQueue &) {
+    // Unread bytes stay in the socket; the new owner's EPOLL_CTL_ADD reports them.
+    forget(fd);
+    syscalls.add();
+    if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr) < 0) {
+        std::cerr << "ERROR: epoll_ctl(DEL): " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+void EpollEngine::removeClient(int fd) {
+    // Closing the socket removes it from the epoll instance.
+    forget(fd);
+}
+
+void EpollEngine::pauseClient(int fd) {
+    if (static_cast<size_t>(fd) >= paused.size()) paused.resize(fd + 1);
+    paused[fd] = 1;
+}
+
+void EpollEngine::resumeClient(int fd) {
+    if (static_cast<size_t>(fd) < paused.size()) paused[fd] = 0;
+}
+
+/**
+ * @brief Waits for readiness events until the given wall-clock timeout.
+ *
+ * epoll_wait() takes milliseconds, which is fine for delays of whole game seconds but
+ * not for a fast time scale, where one game second may be a millisecond of wall-clock
+ * time. epoll_pwait2() (Linux 5.11+) takes nanoseconds; on older kernels this falls back
+ * to epoll_wait() with the timeout rounded up, so the loop never wakes up early.
+ */
+int EpollEngine::waitForEvents(std::chrono::nanoseconds timeout) {
+    syscalls.add();
+    if (timeout < std::chrono::nanoseconds::zero()) {
+        return epoll_wait(epollFd, ready.data(), MAX_EVENTS, -1);
+    }
+    static std::atomic<bool> havePwait2{true};
+    if (havePwait2.load(std::memory_order_relaxed)) {
+        struct timespec ts;
+        ts.tv_sec = timeout.count() / 1000000000;
+        ts.tv_nsec = timeout.count() % 1000000000;
+        int count = epoll_pwait2(epollFd, ready.data(), MAX_EVENTS, &ts, nullptr);
+        if (count >= 0 || errno != ENOSYS) return count;
+        havePwait2.store(false, std::memory_order_relaxed);
+    }
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout);
+    return epoll_wait(epollFd, ready.data(), MAX_EVENTS, static_cast<int>(ms.count()));
+}
+
+void EpollEngine::acceptAll(int listenFd) {
+    // The listening socket is edge-triggered, so accept() is repeated until it would block.
+    while (true) {
+        struct sockaddr_storage clientAddr{};
+        socklen_t addrLen = sizeof(clientAddr);
+        int clientFd = accept4(listenFd, (struct sockaddr*)&clientAddr, &addrLen, SOCK_NONBLOCK);
+        syscalls.add();
+        if (clientFd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "ERROR: accept(): " << strerror(errno) << "\n";
+            }
+            return;
+        }
+        if (!addClient(clientFd)) {
+            close(clientFd);
+            continue;
+        }
+        batch.push_back({IoEventKind::Accepted, clientFd});
+    }
+}
+
+bool EpollEngine::wait(std::chrono::nanoseconds timeout) {
+    batch.clear();
+    int count = waitForEvents(timeout);
+    if (count < 0) {
+        if (errno == EINTR) return true;
+        std::cerr << "ERROR: epoll_wait(): " << strerror(errno) << "\n";
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        int fd = ready[i].data.fd;
+        uint32_t flags = ready[i].events;
+        if (std::find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+            acceptAll(fd);
+            continue;
+        }
+        if (fd == wakeFd) {
+            // Resets the counter.
+            uint64_t value;
+            ssize_t got = read(wakeFd, &value, sizeof(value));
+            (void)got;
+            syscalls.add();
+            batch.push_back({IoEventKind::Wake, fd});
+            continue;
+        }
+        if (flags & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            if (static_cast<size_t>(fd) >= hungUp.size()) hungUp.resize(fd + 1);
+            hungUp[fd] = 1;
+        }
+        if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            batch.push_back({IoEventKind::Readable, fd});
+        }
+        if (flags & EPOLLOUT) batch.push_back({IoEventKind::Writable, fd});
+    }
+    return true;
+}
+
+LineBuffer::FillStatus EpollEngine::receive(IoEvent &event, LineBuffer &input) {
+    // New bytes still raise edges, but they are left in the socket.
+    if (static_cast<size_t>(event.fd) < paused.size() && paused[event.fd]) {
+        return LineBuffer::FillStatus::Drained;
+    }
+    uint64_t calls = 0;
+    bool untilEof = static_cast<size_t>(event.fd) < hungUp.size() && hungUp[event.fd];
+    LineBuffer::FillStatus status = input.fill(event.fd, &calls, untilEof);
+    syscalls.add(calls);
+    return status;
+}
+
+OutputQueue::FlushStatus EpollEngine::send(int fd, OutputQueue &output) {
+    uint64_t calls = 0;
+    OutputQueue::FlushStatus status = output.flush(fd, &calls);
+    syscalls.add(calls);
+    return status;
+}
+
+bool EpollEngine::sent(const IoEvent &, OutputQueue &) {
+    // Readiness only: the write is made by the next send().
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef EPOLL_ENGINE_HPP
+#define EPOLL_ENGINE_HPP
+
+#include <sys/epoll.h>
+
+#include "IoEngine.hpp"
+
+/**
+ * @brief IoEngine on an edge-triggered epoll instance.
+ *
+ * Client sockets are registered for EPOLLIN | EPOLLOUT | EPOLLRDHUP, edge-triggered:
+ * a Readable event means "read until EAGAIN" and a Writable event means a full socket
+ * buffer has room again. Once a client's socket reports EPOLLRDHUP or EPOLLHUP, it is
+ * read until the end of the stream, since no later edge would report it. A paused client
+ * is simply not read: its bytes stay in the socket until it is resumed. Listening sockets
+ * are drained with accept4() as soon as they are reported, so clients arrive as Accepted
+ * events.
+ */
+class EpollEngine : public IoEngine {
+public:
+    explicit EpollEngine(Counter &syscalls) : IoEngine(syscalls) {}
+    ~EpollEngine() override;
+
+    /**
+     * @brief Creates the epoll instance.
+     *
+     * @return false on error (printed).
+     */
+    bool open();
+
+    bool addListener(int fd, bool shared) override;
+    bool setWakeFd(int fd) override;
+    bool addClient(int fd) override;
+    bool releaseClient(int fd, LineBuffer &input, OutputQueue &output) override;
+    void removeClient(int fd) override;
+    void pauseClient(int fd) override;
+    void resumeClient(int fd) override;
+    bool wait(std::chrono::nanoseconds timeout) override;
+    LineBuffer::FillStatus receive(IoEvent &event, LineBuffer &input) override;
+    OutputQueue::FlushStatus send(int fd, OutputQueue &output) override;
+    bool sent(const IoEvent &event, OutputQueue &output) override;
+
+private:
+    /// Waits for readiness events; returns their number or -1 with errno set.
+    int waitForEvents(std::chrono::nanoseconds timeout);
+
+    /// Accepts every pending connection of a listening socket.
+    void acceptAll(int listenFd);
+
+    /// Clears the per-descriptor flags of a client joining or leaving the engine.
+    void forget(int fd);
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::vector<int> listeners;
+    std::vector<uint8_t> paused;         ///< By descriptor.
+    std::vector<uint8_t> hungUp;         ///< By descriptor: the peer shut down its side.
+    std::vector<struct epoll_event> ready = std::vector<struct epoll_event>(MAX_EVENTS);
+};
+
+#endif // EPOLL_ENGINE_HPP
@@ -0,0 +1,31 @@
+#include "GameClock.hpp"
+
+#include <cmath>
+
+/// Written once at startup, before the shards start; read-only afterwards.
+static double timeScale = 1.0;
+
+/// Wall-clock instant at which game time and steady time were equal.
+static std::chrono::steady_clock::time_point realOrigin;
+
+void GameClock::setScale(double scale) {
+    timeScale = scale;
+    realOrigin = std::chrono::steady_clock::now();
+}
+
+double GameClock::scale() {
+    return timeScale;
+}
+
+GameClock::time_point GameClock::now() {
+    auto real = std::chrono::steady_clock::now();
+    if (timeScale == 1.0) return time_point(real.time_since_epoch());
+
+    auto elapsed = static_cast<double>((real - realOrigin).count()) * timeScale;
+    return time_point(realOrigin.time_since_epoch() + duration(static_cast<rep>(elapsed)));
+}
+
+std::chrono::steady_clock::duration GameClock::toReal(duration gameTime) {
+    if (timeScale == 1.0) return gameTime;
+    return duration(static_cast<rep>(std::ceil(gameTime.count() / timeScale)));
+}
@@ -0,0 +1,53 @@
+#ifndef GAME_CLOCK_HPP
+#define GAME_CLOCK_HPP
+
+#include <chrono>
+
+/**
+ * @brief Clock of the game rules: HELLO timeout, delayed STATE and BAD_PUT, linger
+ *        after SCORING and the pause between games.
+ *
+ * By default it is the steady clock. With a time scale S (server option -x) game time
+ * runs S times faster than wall-clock time: a STATE delayed by 3 seconds is sent 3/S
+ * seconds after the PUT. Every delay is scaled by the same factor, so timers expire
+ * in the same order as in a normal game and the rules stay the same, only faster.
+ *
+ * Meets the standard Clock requirements, so TimerQueue and std::chrono arithmetic work
+ * with it unchanged.
+ */
+class GameClock {
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<GameClock>;
+    static constexpr bool is_steady = true;
+
+    /// Upper bound of the time scale (keeps game time within 64-bit nanoseconds
+    /// for more than 100 days of wall-clock time).
+    static constexpr double MAX_SCALE = 1000.0;
+
+    /**
+     * @brief Sets how many times faster than wall-clock time the game runs.
+     *
+     * Must be called before any thread reads the clock.
+     *
+     * @param scale Factor in the range 1..MAX_SCALE.
+     */
+    static void setScale(double scale);
+
+    /// Current time scale (1 unless changed by setScale()).
+    static double scale();
+
+    /**
+     * @brief Returns the current game time.
+     */
+    static time_point now();
+
+    /**
+     * @brief Converts a game-time interval to the wall-clock time it takes, rounded up.
+     */
+    static std::chrono::steady_clock::duration toReal(duration gameTime);
+};
+
+#endif // GAME_CLOCK_HPP
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <unistd.h>
+
+#include "GameCoordinator.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+
+GameCoordinator::GameCoordinator(int K, int M, CoeffStore &coeffs, int roomSize,
+                                 const ClientLimits &limits)
+    : k(K), m(M), matchSize(roomSize), clientLimits(limits), coeffStore(coeffs),
+      pool(std::max(1, static_cast<int>(std::thread::hardware_concurrency())) - 1) {}
+
+void GameCoordinator::addShard(int wakeFd) {
+    wakeFds.push_back(wakeFd);
+    inboxes.emplace_back();
+}
+
+std::string GameCoordinator::nextMatchmadeRoom() {
+    uint64_t player = matchedPlayers.fetch_add(1, std::memory_order_relaxed);
+    return "#" + std::to_string(player / matchSize);
+}
+
+bool GameCoordinator::admitConnection() {
+    if (clientLimits.maxAwaitingHello <= 0) return true;
+    if (awaitingHello.fetch_add(1, std::memory_order_relaxed) >= clientLimits.maxAwaitingHello) {
+        awaitingHello.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+int GameCoordinator::roomShard(const std::string &room) const {
+    return static_cast<int>(std::hash<std::string>{}(room) % wakeFds.size());
+}
+
+void GameCoordinator::handOff(int shard, ClientState &&state) {
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        inboxes[shard].push_back(std::move(state));
+    }
+    uint64_t one = 1;
+    ssize_t written = write(wakeFds[shard], &one, sizeof(one));
+    (void)written; // EAGAIN means the shard is already due to wake up.
+}
+
+std::vector<ClientState> GameCoordinator::takeHandOffs(int shard) {
+    std::vector<ClientState> result;
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    result.swap(inboxes[shard]);
+    return result;
+}
+
+void GameCoordinator::addCorrectPut(int count) {
+    if (correctPutCount.fetch_add(count, std::memory_order_relaxed) + count < m) return;
+    if (ending.exchange(true, std::memory_order_acq_rel)) return;
+
+    // Wake every shard, including ones sleeping in their I/O wait with no client activity.
+    uint64_t one = 1;
+    for (int fd : wakeFds) {
+        ssize_t written = write(fd, &one, sizeof(one));
+        (void)written; // The counter only has to be non-zero; EAGAIN means it already is.
+    }
+}
+
+void GameCoordinator::removeCorrectPuts(int count) {
+    correctPutCount.fetch_sub(count, std::memory_order_relaxed);
+}
+
+GameCoordinator::Scoring GameCoordinator::encodeScoring(const Results &results) {
+    return {std::make_shared<const std::string>(makeSCORING(results)),
+            std::make_shared<const std::string>(makeBinarySCORING(results))};
+}
+
+GameCoordinator::Scoring GameCoordinator::finishRound(Results &&results) {
+    std::unique_lock<std::mutex> lock(roundMutex);
+    std::move(results.begin(), results.end(), std::back_inserter(roundResults));
+
+    if (++contributed < wakeFds.size()) {
+        uint64_t current = round;
+        roundDone.wait(lock, [&]{ return round != current; });
+        return scoring;
+    }
+
+    std::sort(roundResults.begin(), roundResults.end(),
+              [](auto &a, auto &b){ return a.first < b.first; });
+    scoring = encodeScoring(roundResults);
+
+    roundResults.clear();
+    contributed = 0;
+    correctPutCount.store(0, std::memory_order_relaxed);
+    ending.store(false, std::memory_order_release);
+    ++round;
+    roundDone.notify_all();
+    return scoring;
+}
@@ -0,0 +1,204 @@
+#ifndef GAME_COORDINATOR_HPP
+#define GAME_COORDINATOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ClientState.hpp"
+#include "CoeffStore.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Limits on what one client may send and on connections awaiting HELLO.
+ *
+ * Rates are per second of game time, so they scale with the time scale; 0 means no limit.
+ */
+struct ClientLimits {
+    double linesPerSecond = 0;   ///< Lines (or binary frames) per second.
+    double bytesPerSecond = 0;   ///< Bytes per second.
+    int maxAwaitingHello = 0;    ///< Connections that have not sent HELLO yet, over all shards.
+};
+
+/**
+ * @brief Game state shared by all server shards (worker threads).
+ *
+ * Every shard owns its listening socket, event loop, clients and timers; the only
+ * things they share are the COEFF store, the count of correct PUTs towards M and the
+ * end of the game. The PUT count is one atomic, so counting a PUT costs a single
+ * atomic add and never takes a lock.
+ *
+ * When the count reaches M, every shard is woken through its wake descriptor (an
+ * eventfd watched by its I/O engine). Each shard then hands its players' results
+ * to finishRound() and waits there until all shards have done so; the last one builds
+ * the common SCORING message. Because shards stop handling PUTs while waiting, no PUT
+ * of the old game can be counted towards the next one.
+ *
+ * That global game is played by everyone who is not in a room (see RoomTable). A room
+ * lives in one shard; a player whose room is owned by another shard is handed off to
+ * it through that shard's inbox. With matchmaking, the coordinator numbers players in
+ * HELLO order across all shards, so every matchmade room gets exactly roomSize players.
+ */
+class GameCoordinator {
+public:
+    using Results = std::vector<std::pair<std::string, double>>;
+
+    /// SCORING of one game in both encodings, shared by all of its players.
+    struct Scoring {
+        std::shared_ptr<const std::string> text;   ///< "SCORING ...\r\n".
+        std::shared_ptr<const std::string> binary; ///< Binary SCORING frame.
+    };
+
+    /**
+     * @brief Encodes sorted results as SCORING, once per protocol.
+     */
+    static Scoring encodeScoring(const Results &results);
+
+    /**
+     * @brief Creates the coordinator of a game.
+     *
+     * @param K Maximum point index.
+     * @param M Number of correct PUTs that ends the game.
+     * @param coeffs Preloaded COEFF lines.
+     * @param roomSize Players per matchmade room; 0 if players without a room ID
+     *                 play the global game.
+     * @param limits Per-client rate limits and the cap on connections awaiting HELLO.
+     */
+    GameCoordinator(int K, int M, CoeffStore &coeffs, int roomSize,
+                    const ClientLimits &limits = {});
+
+    /**
+     * @brief Registers a shard; must be called for every shard before any of them starts.
+     *
+     * @param wakeFd Descriptor that becomes readable when the shard has to take part
+     *               in the end of the game (an eventfd watched by the shard's I/O engine).
+     */
+    void addShard(int wakeFd);
+
+    /// Maximum point index.
+    int K() const { return k; }
+
+    /// Number of correct PUTs that ends a game.
+    int M() const { return m; }
+
+    /// Players per matchmade room (0: no matchmaking).
+    int roomSize() const { return matchSize; }
+
+    /// Per-client rate limits.
+    const ClientLimits &limits() const { return clientLimits; }
+
+    /**
+     * @brief Counts a new connection as awaiting HELLO, unless the cap is reached.
+     *
+     * @return false if the connection has to be refused.
+     */
+    bool admitConnection();
+
+    /**
+     * @brief Stops counting a connection admitted by admitConnection() (HELLO or closed).
+     */
+    void helloDone() { awaitingHello.fetch_sub(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the ID of the matchmade room for the next player without a room ID.
+     *
+     * Matchmade IDs start with '#', so they never clash with IDs sent in HELLO.
+     */
+    std::string nextMatchmadeRoom();
+
+    /**
+     * @brief Makes matchmaking start at room "#<rooms>", after the rooms restored from
+     *        a snapshot (call before any shard starts).
+     */
+    void skipMatchmadeRooms(uint64_t rooms) { matchedPlayers.store(rooms * matchSize); }
+
+    /// Number of registered shards.
+    int shardCount() const { return static_cast<int>(wakeFds.size()); }
+
+    /**
+     * @brief Returns the index of the shard that owns the room with the given ID.
+     */
+    int roomShard(const std::string &room) const;
+
+    /**
+     * @brief Moves a client (after its HELLO) to another shard and wakes that shard.
+     *
+     * The socket must already be released by the sending shard's I/O engine.
+     *
+     * @param shard Index of the receiving shard.
+     * @param state The client, with its buffered input.
+     */
+    void handOff(int shard, ClientState &&state);
+
+    /**
+     * @brief Returns the clients handed off to the shard since the last call.
+     */
+    std::vector<ClientState> takeHandOffs(int shard);
+
+    /// Preloaded COEFF lines (safe to use from any shard).
+    CoeffStore &coeffs() { return coeffStore; }
+
+    /// Threads that compute scores at the end of a game (shared by all shards).
+    ThreadPool &scoringPool() { return pool; }
+
+    /**
+     * @brief Counts correct PUTs (one, or a restored player's); the PUT that reaches M
+     *        ends the game for all shards.
+     */
+    void addCorrectPut(int count = 1);
+
+    /**
+     * @brief Forgets the correct PUTs of a player who disconnected.
+     *
+     * @param count Number of the player's correct PUTs.
+     */
+    void removeCorrectPuts(int count);
+
+    /**
+     * @brief Returns true if the game has ended and the shard has to call finishRound().
+     */
+    bool endRequested() const { return ending.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Contributes a shard's results and waits until every shard has contributed.
+     *
+     * The last shard sorts all results by player ID, builds the SCORING message and
+     * resets the PUT count, which releases the others.
+     *
+     * @param results Results of the shard's players (player ID, error).
+     * @return The SCORING message for all players.
+     */
+    Scoring finishRound(Results &&results);
+
+private:
+    const int k;
+    const int m;
+    const int matchSize;
+    const ClientLimits clientLimits;
+    std::atomic<uint64_t> matchedPlayers{0};
+    std::atomic<int> awaitingHello{0};
+
+    CoeffStore &coeffStore;
+    ThreadPool pool;
+
+    std::atomic<int> correctPutCount{0};
+    std::atomic<bool> ending{false};
+    std::vector<int> wakeFds;
+
+    std::mutex inboxMutex;
+    std::vector<std::vector<ClientState>> inboxes; ///< Handed-off clients, per shard.
+
+    std::mutex roundMutex;
+    std::condition_variable roundDone;
+    uint64_t round = 0;           ///< Number of finished games.
+    size_t contributed = 0;       ///< Shards that have contributed to the current round.
+    Results roundResults;
+    Scoring scoring;
+};
+
+#endif // GAME_COORDINATOR_HPP
@@ -0,0 +1,29 @@
+#include "IoEngine.hpp"
+#include "EpollEngine.hpp"
+#include "UringEngine.hpp"
+
+bool IoEngine::parseBackend(const std::string &name, Backend &out) {
+    if (name == "epoll") {
+        out = Backend::Epoll;
+    } else if (name == "uring") {
+        out = Backend::Uring;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *IoEngine::backendName(Backend backend) {
+    return backend == Backend::Uring ? "uring" : "epoll";
+}
+
+std::unique_ptr<IoEngine> IoEngine::create(Backend backend, Counter &syscalls) {
+    if (backend == Backend::Uring) {
+        auto engine = std::make_unique<UringEngine>(syscalls);
+        if (!engine->open()) return nullptr;
+        return engine;
+    }
+    auto engine = std::make_unique<EpollEngine>(syscalls);
+    if (!engine->open()) return nullptr;
+    return engine;
+}
@@ -0,0 +1,190 @@
+#ifndef IO_ENGINE_HPP
+#define IO_ENGINE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineBuffer.hpp"
+#include "Metrics.hpp"
+#include "OutputQueue.hpp"
+
+/**
+ * @brief What an I/O event reports.
+ */
+enum class IoEventKind : uint8_t {
+    Accepted, ///< A client connected; `fd` is its socket, already registered with the engine.
+    Readable, ///< The client sent data or closed the connection; take it with receive().
+    Writable, ///< The client's socket takes output again, or a send completed; see sent().
+    Wake      ///< The shard's wake eventfd was signalled (handoffs or the end of the game).
+};
+
+/**
+ * @brief One event of a shard's socket: readiness (epoll) or a completion (io_uring).
+ */
+struct IoEvent {
+    IoEventKind kind;
+    int fd;                  ///< Client socket (the new one for Accepted).
+    uint32_t generation;     ///< Registration of `fd` the completion belongs to (io_uring).
+    int result;              ///< Completion result: bytes, 0 at end of stream or -errno (io_uring).
+    std::string_view data;   ///< Received bytes not taken by receive() yet (io_uring).
+
+    IoEvent(IoEventKind kind, int fd, uint32_t generation = 0, int result = 1,
+            std::string_view data = {})
+        : kind(kind), fd(fd), generation(generation), result(result), data(data) {}
+};
+
+/**
+ * @brief The socket I/O of one shard: accepting, waiting, reading and writing.
+ *
+ * The game logic (Server.cpp) sees only IoEvents, LineBuffers and OutputQueues, so the
+ * same code runs on either backend:
+ *
+ *  - epoll: readiness events; receive() and send() make the read and write calls.
+ *  - io_uring: multishot accept and multishot recv into a ring of provided buffers,
+ *    so received bytes arrive with the event; send() queues a send that is submitted
+ *    together with the next wait, so one io_uring_enter() per loop iteration carries
+ *    all the shard's sends and collects all its input.
+ *
+ * An engine belongs to one shard thread. System calls made on the I/O path are
+ * counted in the counter given at creation.
+ */
+class IoEngine {
+public:
+    /// Available implementations.
+    enum class Backend { Epoll, Uring };
+
+    /**
+     * @brief Parses a backend name: "epoll" or "uring".
+     *
+     * @return false if the name is unknown.
+     */
+    static bool parseBackend(const std::string &name, Backend &out);
+
+    /**
+     * @brief Returns the name of a backend.
+     */
+    static const char *backendName(Backend backend);
+
+    /**
+     * @brief Creates an engine in the calling thread.
+     *
+     * @param backend Implementation to use.
+     * @param syscalls Counter of the system calls made by the engine.
+     * @return The engine, or nullptr if it cannot be set up (the error is printed).
+     */
+    static std::unique_ptr<IoEngine> create(Backend backend, Counter &syscalls);
+
+    virtual ~IoEngine() = default;
+
+    /**
+     * @brief Starts accepting connections on a listening socket.
+     *
+     * @param fd Non-blocking listening socket.
+     * @param shared The socket is also watched by other shards; wake only one of them.
+     * @return false on error (printed).
+     */
+    virtual bool addListener(int fd, bool shared) = 0;
+
+    /**
+     * @brief Watches the eventfd the coordinator signals; a signal becomes a Wake event.
+     *
+     * @return false on error (printed).
+     */
+    virtual bool setWakeFd(int fd) = 0;
+
+    /**
+     * @brief Registers a client socket that was accepted by another shard.
+     *
+     * @return false on error (printed); the caller closes the socket.
+     */
+    virtual bool addClient(int fd) = 0;
+
+    /**
+     * @brief Unregisters a client that moves to another shard, without closing it.
+     *
+     * Bytes the engine already received for the client are appended to its input and
+     * a send in flight is waited for, so nothing is lost in the move.
+     *
+     * @return false on error (printed); the caller closes the socket.
+     */
+    virtual bool releaseClient(int fd, LineBuffer &input, OutputQueue &output) = 0;
+
+    /**
+     * @brief Forgets a client whose socket is closed, or about to be; later events for it
+     *        are dropped.
+     */
+    virtual void removeClient(int fd) = 0;
+
+    /**
+     * @brief Stops reading a client's socket until resumeClient().
+     *
+     * Bytes the engine had already received are still handed out by receive(); the
+     * rest stays in the socket, so the kernel's receive window pushes back on the sender.
+     */
+    virtual void pauseClient(int fd) = 0;
+
+    /**
+     * @brief Reads a paused client's socket again.
+     *
+     * No event reports bytes that arrived while the client was paused: the caller
+     * calls receive() with a synthetic Readable event.
+     */
+    virtual void resumeClient(int fd) = 0;
+
+    /**
+     * @brief Submits pending sends and waits for events.
+     *
+     * @param timeout Longest wait; negative waits until an event arrives.
+     * @return false on an unrecoverable error (printed).
+     */
+    virtual bool wait(std::chrono::nanoseconds timeout) = 0;
+
+    /**
+     * @brief Returns the events collected by the last wait().
+     *
+     * They stay valid until the next wait(); handlers may be called in any order.
+     */
+    std::vector<IoEvent> &events() { return batch; }
+
+    /**
+     * @brief Moves a client's received bytes into its input buffer.
+     *
+     * Call again after consuming lines while it returns Full.
+     *
+     * @param event Readable event of the client (or a synthetic one with no data).
+     * @param input The client's input buffer.
+     * @return Drained when everything available was taken, Full if the buffer is full,
+     *         Closed at end of stream or on error.
+     */
+    virtual LineBuffer::FillStatus receive(IoEvent &event, LineBuffer &input) = 0;
+
+    /**
+     * @brief Writes a client's queued output, or queues the write.
+     *
+     * @return Done if nothing is left to write, Blocked while output is pending (the
+     *         client gets a Writable event), Error if the connection is broken.
+     */
+    virtual OutputQueue::FlushStatus send(int fd, OutputQueue &output) = 0;
+
+    /**
+     * @brief Accounts for a Writable event before the client is flushed again.
+     *
+     * @return false if the completed send failed (the connection is broken).
+     */
+    virtual bool sent(const IoEvent &event, OutputQueue &output) = 0;
+
+protected:
+    explicit IoEngine(Counter &syscalls) : syscalls(syscalls) {}
+
+    /// Maximum number of events collected by one wait().
+    static constexpr size_t MAX_EVENTS = 1024;
+
+    Counter &syscalls;
+    std::vector<IoEvent> batch;
+};
+
+#endif // IO_ENGINE_HPP
@@ -0,0 +1,63 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/// Buckets per power of two (and the number of exact buckets is twice that).
+static const int SUB_BUCKET_BITS = 6;
+static const uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BUCKET_BITS;
+
+/// Enough buckets for any 64-bit value.
+static const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * SUB_BUCKETS + SUB_BUCKETS;
+
+LatencyHistogram::LatencyHistogram() : counts(BUCKET_COUNT, 0) {}
+
+size_t LatencyHistogram::bucketCount() {
+    return BUCKET_COUNT;
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t value) {
+    if (value < 2 * SUB_BUCKETS) return static_cast<size_t>(value);
+    int highBit = 63 - __builtin_clzll(value);
+    int shift = highBit - SUB_BUCKET_BITS;
+    // value >> shift is in [SUB_BUCKETS, 2 * SUB_BUCKETS).
+    return static_cast<size_t>(shift) * SUB_BUCKETS + (value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(size_t bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+    uint64_t mantissa = bucket - static_cast<uint64_t>(shift) * SUB_BUCKETS;
+    return (mantissa << shift) + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+    ++counts[bucketOf(value)];
+    ++total;
+    maxValue = std::max(maxValue, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    total += other.total;
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    maxValue = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p * total));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(bucketMidpoint(i), maxValue);
+    }
+    return maxValue;
+}
@@ -0,0 +1,62 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Histogram of latencies with fixed relative precision.
+ *
+ * Values (nanoseconds) below 128 get a bucket each; above that, every power of two is
+ * split into 64 buckets, so a reported percentile is within 1/64 (about 1.6%) of the
+ * true value. Recording is O(1) and the memory is fixed (a few thousand counters), no
+ * matter how many samples are recorded, unlike keeping every sample and sorting.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    /**
+     * @brief Records one sample.
+     */
+    void record(std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Adds all samples of another histogram.
+     */
+    void merge(const LatencyHistogram &other);
+
+    /**
+     * @brief Removes all samples.
+     */
+    void reset();
+
+    /// Number of recorded samples.
+    uint64_t count() const { return total; }
+
+    /// Largest recorded sample, in nanoseconds.
+    uint64_t max() const { return maxValue; }
+
+    /**
+     * @brief Returns the value at the given percentile, in nanoseconds.
+     *
+     * @param p Percentile as a fraction (e.g. 0.99); 0 if there are no samples.
+     */
+    uint64_t percentile(double p) const;
+
+private:
+    /// Fills snapshots of itself (same buckets, atomic counters).
+    friend class SharedHistogram;
+
+    static size_t bucketCount();
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketMidpoint(size_t bucket);
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t maxValue = 0;
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
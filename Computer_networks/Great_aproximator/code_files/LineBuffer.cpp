@@ -0,0 +1,115 @@
+#include "LineBuffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/uio.h>
+
+LineBuffer::LineBuffer(size_t initialCapacity)
+    : data(initialCapacity)
+{}
+
+bool LineBuffer::reserve(size_t needed) {
+    if (data.size() - writePos >= needed) return true;
+
+    // Move the unconsumed bytes to the front before growing the array.
+    if (readPos > 0) {
+        std::memmove(data.data(), data.data() + readPos, writePos - readPos);
+        writePos -= readPos;
+        scanPos -= readPos;
+        readPos = 0;
+        if (data.size() - writePos >= needed) return true;
+    }
+
+    if (writePos + needed > MAX_SIZE) return false;
+    data.resize(std::min(MAX_SIZE, std::max(data.size() * 2, writePos + needed)));
+    return true;
+}
+
+LineBuffer::FillStatus LineBuffer::fill(int fd, uint64_t *syscalls, bool untilEof) {
+    static thread_local char scratch[64 * 1024];
+
+    while (true) {
+        if (writePos == data.size() && !reserve(1)) return FillStatus::Full;
+
+        struct iovec iov[2];
+        iov[0].iov_base = data.data() + writePos;
+        iov[0].iov_len  = data.size() - writePos;
+        iov[1].iov_base = scratch;
+        iov[1].iov_len  = std::min(sizeof(scratch), MAX_SIZE - data.size());
+        size_t requested = iov[0].iov_len + iov[1].iov_len;
+
+        ssize_t n = readv(fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+        if (syscalls) ++*syscalls;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FillStatus::Drained;
+            return FillStatus::Closed;
+        }
+        if (n == 0) return FillStatus::Closed;
+
+        size_t got = static_cast<size_t>(n);
+        totalRead += got;
+        size_t direct = std::min(got, iov[0].iov_len);
+        writePos += direct;
+        if (got > direct) {
+            size_t spilled = got - direct;
+            reserve(spilled); // Cannot fail: the scratch length was capped by MAX_SIZE.
+            std::memcpy(data.data() + writePos, scratch, spilled);
+            writePos += spilled;
+        }
+
+        // A short read from a stream socket means its receive queue is empty; new data
+        // will raise a new edge-triggered event, so the extra read() returning EAGAIN is
+        // skipped. A FIN that came with the data raises none, hence untilEof.
+        if (got < requested && !untilEof) return FillStatus::Drained;
+    }
+}
+
+size_t LineBuffer::append(std::string_view bytes) {
+    size_t n = std::min(bytes.size(), MAX_SIZE - (writePos - readPos));
+    if (n == 0 || !reserve(n)) return 0;
+    std::memcpy(data.data() + writePos, bytes.data(), n);
+    writePos += n;
+    totalRead += n;
+    return n;
+}
+
+bool LineBuffer::nextLine(std::string_view &line) {
+    const char *base = data.data();
+    size_t from = std::max(scanPos, readPos);
+    while (from + 1 < writePos) {
+        const void *cr = std::memchr(base + from, '\r', writePos - from - 1);
+        if (cr == nullptr) break;
+        size_t pos = static_cast<const char*>(cr) - base;
+        if (base[pos + 1] == '\n') {
+            line = std::string_view(base + readPos, pos - readPos);
+            readPos = scanPos = pos + 2;
+            if (readPos == writePos) readPos = writePos = scanPos = 0;
+            return true;
+        }
+        from = pos + 1;
+    }
+
+    // Remember how far we scanned; a trailing '\r' may still be followed by '\n'.
+    scanPos = (writePos > readPos) ? writePos - 1 : writePos;
+    return false;
+}
+
+LineBuffer::FrameStatus LineBuffer::nextFrame(std::string_view &frame) {
+    if (writePos - readPos < 4) return FrameStatus::Incomplete;
+
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(data.data() + readPos);
+    size_t length = size_t(p[0]) | size_t(p[1]) << 8 | size_t(p[2]) << 16 | size_t(p[3]) << 24;
+    if (length == 0 || length > MAX_SIZE - 4) return FrameStatus::Invalid;
+    if (writePos - readPos < 4 + length) return FrameStatus::Incomplete;
+
+    frame = std::string_view(data.data() + readPos + 4, length);
+    readPos = scanPos = readPos + 4 + length;
+    if (readPos == writePos) readPos = writePos = scanPos = 0;
+    return FrameStatus::Complete;
+}
+
+bool LineBuffer::full() const {
+    return readPos == 0 && writePos == MAX_SIZE;
+}
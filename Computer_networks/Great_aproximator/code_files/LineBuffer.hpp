@@ -0,0 +1,112 @@
+#ifndef LINE_BUFFER_HPP
+#define LINE_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Per-connection input buffer that frames the byte stream into "\r\n" lines.
+ *
+ * Bytes live in one contiguous array between a read and a write offset. Lines are
+ * returned as string_views into that array, without copying. The unconsumed tail is
+ * moved to the front only when the free space runs out, so the cost is amortised
+ * O(1) per byte, unlike erasing the consumed prefix after every line.
+ *
+ * After a binary HELLO the same buffer frames the stream into length-prefixed binary
+ * frames instead (see binary_protocol.hpp); the two modes share the storage and the
+ * read path, only the framing differs.
+ *
+ * A returned line or frame stays valid until the next call to fill() or append().
+ */
+class LineBuffer {
+public:
+    /// Outcome of draining the socket into the buffer.
+    enum class FillStatus {
+        Drained, ///< The socket has no more data for now (EAGAIN or short read).
+        Full,    ///< The buffer reached its size limit; consume lines and fill again.
+        Closed   ///< The peer closed the connection or a read error occurred.
+    };
+
+    /// Outcome of extracting a binary frame.
+    enum class FrameStatus {
+        Complete,   ///< A frame was extracted.
+        Incomplete, ///< The next frame has not been fully received yet.
+        Invalid     ///< The length prefix is zero or larger than the buffer can ever hold.
+    };
+
+    /// Upper bound on buffered bytes; a longer unterminated line is treated as an error.
+    static constexpr size_t MAX_SIZE = 1 << 20;
+
+    /**
+     * @brief Creates an empty buffer.
+     *
+     * @param initialCapacity Initial size of the array (grows on demand up to MAX_SIZE).
+     */
+    explicit LineBuffer(size_t initialCapacity = 512);
+
+    /**
+     * @brief Reads from the socket in large chunks until it is drained or the buffer is full.
+     *
+     * Each read() also targets a 64 KB per-thread scratch area, so a single syscall can take
+     * many pipelined messages even when the buffer itself is small.
+     *
+     * A short read normally ends the call without the read() that would return EAGAIN.
+     * Once the peer has shut down its side, no further edge-triggered event will come,
+     * so untilEof makes it read on until EAGAIN or the end of the stream is seen.
+     *
+     * @param fd Non-blocking socket descriptor.
+     * @param syscalls If not null, incremented by the number of read calls made.
+     * @param untilEof Whether to keep reading after a short read.
+     * @return FillStatus describing why reading stopped.
+     */
+    FillStatus fill(int fd, uint64_t *syscalls = nullptr, bool untilEof = false);
+
+    /**
+     * @brief Copies bytes received elsewhere (e.g. by io_uring) into the buffer.
+     *
+     * @param bytes Received bytes.
+     * @return Number of bytes copied; fewer than given only if the buffer became full.
+     */
+    size_t append(std::string_view bytes);
+
+    /**
+     * @brief Extracts the next complete line.
+     *
+     * @param line Output: the line without "\r\n", pointing into the buffer.
+     * @return true if a line was extracted, false if no complete line is buffered.
+     */
+    bool nextLine(std::string_view &line);
+
+    /**
+     * @brief Extracts the next complete length-prefixed binary frame.
+     *
+     * @param frame Output: the frame without its 4-byte length (type byte and payload),
+     *              pointing into the buffer.
+     * @return FrameStatus; the connection cannot continue after Invalid.
+     */
+    FrameStatus nextFrame(std::string_view &frame);
+
+    /**
+     * @brief Returns true if the buffer holds MAX_SIZE bytes and cannot accept more.
+     */
+    bool full() const;
+
+    /**
+     * @brief Returns the number of bytes read from the socket so far.
+     */
+    uint64_t bytesRead() const { return totalRead; }
+
+private:
+    /// Makes room for at least `needed` bytes after the write offset.
+    bool reserve(size_t needed);
+
+    std::vector<char> data;
+    size_t readPos = 0;  ///< Start of the unconsumed bytes.
+    size_t writePos = 0; ///< End of the received bytes.
+    size_t scanPos = 0;  ///< Bytes before this offset are known not to start "\r\n".
+    uint64_t totalRead = 0; ///< Bytes read from the socket so far.
+};
+
+#endif // LINE_BUFFER_HPP
@@ -0,0 +1,220 @@
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+std::atomic<LogLevel> Logger::currentLevel{LogLevel::Debug};
+std::atomic<uint64_t> Logger::droppedCount{0};
+
+/// Number of records the ring holds (a power of two).
+static const size_t RING_SIZE = 1 << 14;
+
+/// How long the writer sleeps when the ring is empty.
+static const auto IDLE_SLEEP = std::chrono::milliseconds(1);
+
+/**
+ * @brief One log call, as stored in the ring.
+ */
+struct LogRecord {
+    LogEvent event;
+    uint32_t count;
+    int32_t fd;
+    char name[Logger::NAME_SIZE];
+    char room[Logger::NAME_SIZE];
+};
+
+/**
+ * @brief Ring slot. `sequence` says whose turn the slot is: it equals the position a
+ *        producer may claim it for, or that position + 1 once the record is written.
+ */
+struct alignas(64) Slot {
+    std::atomic<uint64_t> sequence;
+    LogRecord record;
+};
+
+static std::unique_ptr<Slot[]> makeRing() {
+    std::unique_ptr<Slot[]> ring(new Slot[RING_SIZE]);
+    for (size_t i = 0; i < RING_SIZE; ++i) ring[i].sequence.store(i, std::memory_order_relaxed);
+    return ring;
+}
+
+static std::unique_ptr<Slot[]> ring = makeRing();
+
+/// Next position producers claim (shared by all of them).
+alignas(64) static std::atomic<uint64_t> enqueuePos{0};
+
+/// Next position the writer reads (the writer thread only).
+alignas(64) static uint64_t dequeuePos = 0;
+
+static void copyName(char (&out)[Logger::NAME_SIZE], std::string_view name) {
+    size_t len = std::min(name.size(), Logger::NAME_SIZE - 1);
+    std::memcpy(out, name.data(), len);
+    out[len] = '\0';
+}
+
+LogLevel Logger::levelOf(LogEvent event) {
+    switch (event) {
+        case LogEvent::PenaltySent:
+        case LogEvent::BadPutSent:
+        case LogEvent::StateSent:
+            return LogLevel::Debug;
+        case LogEvent::HelloTimeout:
+        case LogEvent::ClientRefused:
+        case LogEvent::ClientThrottled:
+        case LogEvent::LingerTimeout:
+            return LogLevel::Warning;
+        default:
+            return LogLevel::Info;
+    }
+}
+
+void Logger::push(LogEvent event, int fd, std::string_view name, std::string_view room,
+                  uint32_t count)
+{
+    // Bounded multi-producer queue: a producer claims a position with one CAS and
+    // publishes the record by advancing the slot's sequence.
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+        slot = &ring[pos & (RING_SIZE - 1)];
+        uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // The writer has not consumed this slot's previous record yet: the ring is full.
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord &r = slot->record;
+    r.event = event;
+    r.count = count;
+    r.fd = fd;
+    copyName(r.name, name);
+    copyName(r.room, room);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Appends the message of a record, worded like the server always logged it.
+ */
+static void format(const LogRecord &r, std::string &out) {
+    switch (r.event) {
+        case LogEvent::ClientConnected:
+            out.append("New client (fd=").append(std::to_string(r.fd)).append(") connected.\n");
+            break;
+        case LogEvent::ClientDisconnected:
+            out.append("Client (fd=").append(std::to_string(r.fd)).append(") disconnected.\n");
+            break;
+        case LogEvent::CoeffSent:
+            out.append(r.name).append(" received COEFF");
+            if (r.room[0] != '\0') out.append(" in room ").append(r.room);
+            out.append(".\n");
+            break;
+        case LogEvent::PlayerReattached:
+            out.append(r.name).append(" reattached with ").append(std::to_string(r.count))
+               .append(" correct PUTs");
+            if (r.room[0] != '\0') out.append(" in room ").append(r.room);
+            out.append(".\n");
+            break;
+        case LogEvent::PenaltySent:
+            out.append("Sent PENALTY to ").append(r.name).append("\n");
+            break;
+        case LogEvent::BadPutSent:
+            out.append("Sent BAD_PUT to ").append(r.name).append("\n");
+            break;
+        case LogEvent::StateSent:
+            out.append("Sent STATE to ").append(r.name).append("\n");
+            break;
+        case LogEvent::HelloTimeout:
+            out.append("Client (fd=").append(std::to_string(r.fd))
+               .append(") did not send HELLO in time. Disconnecting.\n");
+            break;
+        case LogEvent::ClientRefused:
+            out.append("Client (fd=").append(std::to_string(r.fd))
+               .append(") refused: too many connections awaiting HELLO.\n");
+            break;
+        case LogEvent::ClientThrottled:
+            out.append("Client (fd=").append(std::to_string(r.fd))
+               .append(") exceeded its rate limit. Reads paused.\n");
+            break;
+        case LogEvent::LingerTimeout:
+            out.append("Client (fd=").append(std::to_string(r.fd))
+               .append(") did not read SCORING in time. Closing.\n");
+            break;
+        case LogEvent::RoomEnded:
+            out.append("Game in room ").append(r.name).append(" ended. Sent SCORING to ")
+               .append(std::to_string(r.count)).append(" players.\n");
+            break;
+        case LogEvent::GameEnded:
+            out.append("Game ended. Sent SCORING to all clients.\n");
+            break;
+    }
+}
+
+/**
+ * @brief Writer thread: drains the ring, formats the records and writes them in batches.
+ */
+static void writeLoop() {
+    std::string batch;
+    uint64_t reportedDrops = 0;
+    while (true) {
+        batch.clear();
+        while (batch.size() < 64 * 1024) {
+            Slot &slot = ring[dequeuePos & (RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;
+            format(slot.record, batch);
+            // Hand the slot back to producers for the position one lap later.
+            slot.sequence.store(dequeuePos + RING_SIZE, std::memory_order_release);
+            ++dequeuePos;
+        }
+
+        uint64_t drops = Logger::dropped();
+        if (drops != reportedDrops) {
+            batch.append("Log overflow: ").append(std::to_string(drops - reportedDrops))
+                 .append(" messages dropped.\n");
+            reportedDrops = drops;
+        }
+
+        if (batch.empty()) {
+            std::this_thread::sleep_for(IDLE_SLEEP);
+            continue;
+        }
+        std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        std::cout.flush();
+    }
+}
+
+void Logger::start(LogLevel level) {
+    setLevel(level);
+    std::thread(writeLoop).detach();
+}
+
+bool Logger::parseLevel(std::string_view name, LogLevel &out) {
+    for (LogLevel l : {LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Off}) {
+        if (name == levelName(l)) {
+            out = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug:   return "debug";
+        case LogLevel::Info:    return "info";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Off:     return "off";
+    }
+    return "?";
+}
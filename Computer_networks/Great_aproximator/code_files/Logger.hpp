@@ -0,0 +1,107 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Verbosity of the server log, from the most to the least verbose.
+ */
+enum class LogLevel : uint8_t {
+    Debug,   ///< Every response sent for a PUT (STATE, PENALTY, BAD_PUT).
+    Info,    ///< Connections, COEFF and game ends.
+    Warning, ///< Clients dropped for timing out.
+    Off      ///< Nothing (errors still go to stderr).
+};
+
+/**
+ * @brief Events the event loops log; each one has a fixed level and message.
+ */
+enum class LogEvent : uint8_t {
+    ClientConnected,    ///< fd
+    ClientDisconnected, ///< fd
+    CoeffSent,          ///< player (and room, if any)
+    PlayerReattached,   ///< player (and room, if any), count = correct PUTs
+    PenaltySent,        ///< player
+    BadPutSent,         ///< player
+    StateSent,          ///< player
+    HelloTimeout,       ///< fd
+    ClientRefused,      ///< fd
+    ClientThrottled,    ///< fd
+    LingerTimeout,      ///< fd
+    RoomEnded,          ///< room, count = players
+    GameEnded           ///< (no arguments)
+};
+
+/**
+ * @brief Asynchronous logger of the server's event loops.
+ *
+ * A log call copies a compact binary record (event, descriptor, count and up to two
+ * short names) into a lock-free ring buffer and returns; it never formats, locks or
+ * waits for the terminal. A background thread formats the records and writes them to
+ * stdout in batches. If the ring is full the record is dropped and counted, so a slow
+ * terminal can never stall a shard.
+ *
+ * Names (player and room IDs) longer than NAME_SIZE - 1 characters are cut short in
+ * the log. Errors are not logged here: they are rare and go to stderr synchronously.
+ */
+class Logger {
+public:
+    /// Bytes stored per name, terminating zero included.
+    static constexpr size_t NAME_SIZE = 32;
+
+    /**
+     * @brief Starts the writer thread; records logged before are kept until then.
+     *
+     * @param level Initial level.
+     */
+    static void start(LogLevel level);
+
+    /**
+     * @brief Changes the level; takes effect for the next log call of every thread.
+     */
+    static void setLevel(LogLevel level) { currentLevel.store(level, std::memory_order_relaxed); }
+
+    /// Current level.
+    static LogLevel level() { return currentLevel.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Parses a level name (debug, info, warning or off).
+     *
+     * @return false if the name is unknown.
+     */
+    static bool parseLevel(std::string_view name, LogLevel &out);
+
+    /// Name of a level, as accepted by parseLevel().
+    static const char *levelName(LogLevel level);
+
+    /// Number of records dropped because the ring was full.
+    static uint64_t dropped() { return droppedCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Logs an event if its level is enabled.
+     *
+     * @param event What happened.
+     * @param fd Client socket, for events about a connection.
+     * @param name Player ID or room ID (see LogEvent).
+     * @param room Room ID of CoeffSent and PlayerReattached, empty for the global game.
+     * @param count Number of players of RoomEnded, correct PUTs of PlayerReattached.
+     */
+    static void log(LogEvent event, int fd = -1, std::string_view name = {},
+                    std::string_view room = {}, uint32_t count = 0)
+    {
+        if (levelOf(event) < level()) return;
+        push(event, fd, name, room, count);
+    }
+
+private:
+    static LogLevel levelOf(LogEvent event);
+    static void push(LogEvent event, int fd, std::string_view name, std::string_view room,
+                     uint32_t count);
+
+    static std::atomic<LogLevel> currentLevel;
+    static std::atomic<uint64_t> droppedCount;
+};
+
+#endif // LOGGER_HPP
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <string_view>
 
 #include "ManualInput.hpp"
 #include "protocol.hpp"
@@ -60,6 +61,69 @@ std::string readStdinLine(bool &success) {
 }
 
 
+/**
+ * @brief Prints one message received from the server.
+ *
+ * @param msg The line without "\r\n".
+ * @param tokens Scratch vector for the tokens (reused between calls).
+ * @param playerId The current player's ID (for error reporting).
+ * @param resolvedIP Server's IP address (for error reporting).
+ * @param port Server's TCP port (for error reporting).
+ * @return true if the message was SCORING and manual mode should end.
+ */
+static bool handleServerLine(std::string_view msg,
+                             std::vector<std::string_view> &tokens,
+                             const std::string &playerId,
+                             const std::string &resolvedIP,
+                             int port)
+{
+    splitBySpace(msg, tokens);
+    if (tokens.empty()) {
+        return false;
+    }
+    if (tokens[0] == "STATE") {
+        // Print the entire state: "Received state r0 r1 ... rK."
+        std::cout << "Received state";
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            std::cout << " " << tokens[i];
+        }
+        std::cout << ".\n";
+    }
+    else if (tokens[0] == "BAD_PUT") {
+        // Format: BAD_PUT <point> <value>
+        if (tokens.size() >= 3) {
+            std::cout << "Received bad put " << tokens[1]
+                      << " " << tokens[2] << ".\n";
+        } else {
+            std::cout << "Received bad put.\n";
+        }
+    }
+    else if (tokens[0] == "PENALTY") {
+        // Format: PENALTY <point> <value>
+        if (tokens.size() >= 3) {
+            std::cout << "Received penalty " << tokens[1]
+                      << " " << tokens[2] << ".\n";
+        } else {
+            std::cout << "Received penalty.\n";
+        }
+    }
+    else if (tokens[0] == "SCORING") {
+        // Print final scoring and exit manual mode
+        std::cout << "Game end, scoring:";
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            std::cout << " " << tokens[i];
+        }
+        std::cout << ".\n";
+        return true;
+    }
+    else {
+        // Unexpected message: log error but keep running
+        std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
+                  << ", " << playerId << ": " << msg << "\n";
+    }
+    return false;
+}
+
 /**
  * @brief Runs the interactive manual mode for approx-client.
  *
@@ -75,11 +139,13 @@ std::string readStdinLine(bool &success) {
  * The function exits when a SCORING message is received or the server disconnects.
  *
  * @param sockfd Active socket connected to the server.
+ * @param input Line buffer of the socket (may already hold lines received after COEFF).
  * @param playerId The current player's ID (for error reporting).
  * @param resolvedIP Server's IP address (for error reporting).
  * @param port Server's TCP port (for error reporting).
  */
 void runManualMode(int sockfd,
+                   LineBuffer &input,
                    const std::string &playerId,
                    const std::string &resolvedIP,
                    int port)
@@ -91,6 +157,15 @@ void runManualMode(int sockfd,
         exit(1);
     }
 
+    std::vector<std::string_view> tokens; // Reused, so tokenizing does not allocate.
+
+    // Lines that arrived together with COEFF are already buffered.
+    std::string_view msg;
+    while (input.nextLine(msg)) {
+        if (handleServerLine(msg, tokens, playerId, resolvedIP, port))
+            return;
+    }
+
     while (true) {
         // Build the fd_set for select(): stdin + socket
         fd_set readFds;
@@ -117,7 +192,7 @@ void runManualMode(int sockfd,
                     continue;
                 }
                 // Split the line by spaces into two tokens
-                auto tokens = splitBySpace(line);
+                splitBySpace(line, tokens);
                 if (tokens.size() != 2) {
                     std::cerr << "ERROR: invalid input line " << line << "\n";
                     continue;
@@ -143,58 +218,18 @@ void runManualMode(int sockfd,
 
         // Handle available data on the socket
         if (FD_ISSET(sockfd, &readFds)) {
-            bool success;
-            std::string msg = readLine(sockfd, success);
-            if (!success) {
+            bool closed = input.fill(sockfd) == LineBuffer::FillStatus::Closed;
+            std::string_view msg;
+            while (input.nextLine(msg)) {
+                if (handleServerLine(msg, tokens, playerId, resolvedIP, port))
+                    return;
+            }
+            if (closed || input.full()) {
                 // Peer closed connection or error occurred
                 std::cerr << "ERROR: unexpected server disconnect\n";
                 close(sockfd);
                 exit(1);
             }
-            auto tokens = splitBySpace(msg);
-            if (tokens.empty()) {
-                continue;
-            }
-            if (tokens[0] == "STATE") {
-                // Print the entire state: "Received state r0 r1 ... rK."
-                std::cout << "Received state";
-                for (size_t i = 1; i < tokens.size(); ++i) {
-                    std::cout << " " << tokens[i];
-                }
-                std::cout << ".\n";
-            }
-            else if (tokens[0] == "BAD_PUT") {
-                // Format: BAD_PUT <point> <value>
-                if (tokens.size() >= 3) {
-                    std::cout << "Received bad put " << tokens[1]
-                              << " " << tokens[2] << ".\n";
-                } else {
-                    std::cout << "Received bad put.\n";
-                }
-            }
-            else if (tokens[0] == "PENALTY") {
-                // Format: PENALTY <point> <value>
-                if (tokens.size() >= 3) {
-                    std::cout << "Received penalty " << tokens[1]
-                              << " " << tokens[2] << ".\n";
-                } else {
-                    std::cout << "Received penalty.\n";
-                }
-            }
-            else if (tokens[0] == "SCORING") {
-                // Print final scoring and exit manual mode
-                std::cout << "Game end, scoring:";
-                for (size_t i = 1; i < tokens.size(); ++i) {
-                    std::cout << " " << tokens[i];
-                }
-                std::cout << ".\n";
-                return;
-            }
-            else {
-                // Unexpected message: log error but keep running
-                std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
-                          << ", " << playerId << ": " << msg << "\n";
-            }
         }
     }
-}
\ No newline at end of file
+}
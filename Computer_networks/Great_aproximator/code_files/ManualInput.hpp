@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "LineBuffer.hpp"
+
 /**
  * @brief Sets stdin to non-blocking mode.
  *
@@ -30,11 +32,13 @@ std::string readStdinLine(bool &success);
  * Loop ends upon receiving SCORING or on unexpected disconnect.
  *
  * @param sockfd Connected socket descriptor.
+ * @param input Line buffer of the socket (may already hold lines received after COEFF).
  * @param playerId Identifier of the player.
  * @param resolvedIP Server IP address string.
  * @param port Server port number.
  */
 void runManualMode(int sockfd,
+                   LineBuffer &input,
                    const std::string &playerId,
                    const std::string &resolvedIP,
                    int port);
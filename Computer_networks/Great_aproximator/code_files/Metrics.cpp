@@ -0,0 +1,107 @@
+#include "Metrics.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+SharedHistogram::SharedHistogram()
+    : counts(new std::atomic<uint64_t>[LatencyHistogram::bucketCount()]())
+{}
+
+void SharedHistogram::record(std::chrono::nanoseconds latency) {
+    uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+    std::atomic<uint64_t> &bucket = counts[LatencyHistogram::bucketOf(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (value > maxValue.get()) maxValue.set(value);
+}
+
+void SharedHistogram::snapshotInto(LatencyHistogram &out) const {
+    // The total is summed from the buckets, so it always matches them.
+    for (size_t i = 0; i < out.counts.size(); ++i) {
+        uint64_t n = counts[i].load(std::memory_order_relaxed);
+        out.counts[i] += n;
+        out.total += n;
+    }
+    out.maxValue = std::max(out.maxValue, maxValue.get());
+}
+
+Metrics::Metrics(int shardCount) {
+    for (int i = 0; i < shardCount; ++i) shards.push_back(std::make_unique<ShardMetrics>());
+}
+
+/// Quantiles reported for every histogram.
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+/**
+ * @brief Appends the lines of one metric: the total and, with several shards, per shard.
+ *
+ * @param field Member of ShardMetrics to report.
+ */
+static void renderCounter(std::ostringstream &out, const char *name,
+                          const std::vector<std::unique_ptr<ShardMetrics>> &shards,
+                          Counter ShardMetrics::*field)
+{
+    uint64_t total = 0;
+    for (auto &shard : shards) total += ((*shard).*field).get();
+    out << name << " " << total << "\n";
+    if (shards.size() < 2) return;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        out << name << "{shard=\"" << i << "\"} " << ((*shards[i]).*field).get() << "\n";
+    }
+}
+
+static void renderHistogram(std::ostringstream &out, const char *name,
+                            const std::string &labels, const LatencyHistogram &h)
+{
+    const std::string plain = labels.empty() ? "" : "{" + labels + "}";
+    const std::string open = labels.empty() ? "{" : "{" + labels + ",";
+    out << name << "_count" << plain << " " << h.count() << "\n";
+    for (double q : QUANTILES) {
+        out << name << open << "quantile=\"" << q << "\"} " << h.percentile(q) << "\n";
+    }
+    out << name << "_max" << plain << " " << h.max() << "\n";
+}
+
+static void renderHistograms(std::ostringstream &out, const char *name,
+                             const std::vector<std::unique_ptr<ShardMetrics>> &shards,
+                             SharedHistogram ShardMetrics::*field)
+{
+    std::vector<LatencyHistogram> perShard(shards.size());
+    LatencyHistogram total;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        ((*shards[i]).*field).snapshotInto(perShard[i]);
+        total.merge(perShard[i]);
+    }
+    renderHistogram(out, name, "", total);
+    if (shards.size() < 2) return;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        renderHistogram(out, name, "shard=\"" + std::to_string(i) + "\"", perShard[i]);
+    }
+}
+
+std::string Metrics::render() const {
+    std::ostringstream out;
+    renderCounter(out, "approx_connections_total", shards, &ShardMetrics::connections);
+    renderCounter(out, "approx_clients", shards, &ShardMetrics::clients);
+    renderCounter(out, "approx_timers_pending", shards, &ShardMetrics::timers);
+    renderCounter(out, "approx_puts_total", shards, &ShardMetrics::puts);
+    renderCounter(out, "approx_bad_puts_total", shards, &ShardMetrics::badPuts);
+    renderCounter(out, "approx_penalties_total", shards, &ShardMetrics::penalties);
+    renderCounter(out, "approx_states_sent_total", shards, &ShardMetrics::statesSent);
+    renderCounter(out, "approx_games_scored_total", shards, &ShardMetrics::gamesScored);
+    renderCounter(out, "approx_bytes_in_total", shards, &ShardMetrics::bytesIn);
+    renderCounter(out, "approx_bytes_out_total", shards, &ShardMetrics::bytesOut);
+    renderCounter(out, "approx_loop_iterations_total", shards, &ShardMetrics::loops);
+    renderCounter(out, "approx_io_syscalls_total", shards, &ShardMetrics::syscalls);
+    renderCounter(out, "approx_refused_connections_total", shards, &ShardMetrics::refused);
+    renderCounter(out, "approx_throttled_total", shards, &ShardMetrics::throttled);
+    renderCounter(out, "approx_flood_drops_total", shards, &ShardMetrics::floods);
+    renderCounter(out, "approx_reattached_total", shards, &ShardMetrics::reattached);
+    renderHistograms(out, "approx_loop_time_ns", shards, &ShardMetrics::loopTime);
+    renderHistograms(out, "approx_put_time_ns", shards, &ShardMetrics::putTime);
+    renderHistograms(out, "approx_state_lateness_ns", shards, &ShardMetrics::stateLateness);
+    renderHistograms(out, "approx_scoring_time_ns", shards, &ShardMetrics::scoringTime);
+    renderHistograms(out, "approx_snapshot_time_ns", shards, &ShardMetrics::snapshotTime);
+    out << "approx_log_dropped_total " << Logger::dropped() << "\n";
+    return out.str();
+}
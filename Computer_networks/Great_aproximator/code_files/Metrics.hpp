@@ -0,0 +1,135 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+
+/**
+ * @brief Counter or gauge written by one thread and read by any thread.
+ *
+ * Only the owning shard writes it, so an update is a plain load and store (no locked
+ * read-modify-write instruction); readers may see a value a few events old.
+ */
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t n) { value.store(n, std::memory_order_relaxed); }
+
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+/**
+ * @brief LatencyHistogram written by one thread and read by any thread.
+ *
+ * Recording is one bucket lookup and one counter update. A snapshot may miss the
+ * samples recorded while it is taken, but it is never torn.
+ */
+class SharedHistogram {
+public:
+    SharedHistogram();
+
+    /**
+     * @brief Records one sample (owner thread only).
+     */
+    void record(std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Adds the samples recorded so far to a plain histogram.
+     */
+    void snapshotInto(LatencyHistogram &out) const;
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    Counter maxValue;
+};
+
+/**
+ * @brief Metrics of one shard, updated only by the shard's thread.
+ *
+ * Aligned to a cache line, so that shards updating their own metrics do not slow
+ * each other down.
+ */
+struct alignas(64) ShardMetrics {
+    Counter connections;   ///< Accepted connections.
+    Counter clients;       ///< Current clients (gauge).
+    Counter timers;        ///< Timers in the queue, including stale ones (gauge).
+    Counter puts;          ///< Accepted PUTs.
+    Counter badPuts;       ///< Rejected PUTs (BAD_PUT).
+    Counter penalties;     ///< PUTs penalised for arriving before STATE.
+    Counter statesSent;    ///< Delayed STATE messages sent.
+    Counter gamesScored;   ///< Rooms and global games this shard sent SCORING for.
+    Counter bytesIn;       ///< Bytes read from clients.
+    Counter bytesOut;      ///< Bytes written to clients.
+    Counter loops;         ///< Event loop iterations.
+    Counter syscalls;      ///< System calls made by the I/O engine (waits, reads, writes, accepts).
+    Counter refused;       ///< Connections closed at once: too many were awaiting HELLO.
+    Counter throttled;     ///< Times a client exceeded a rate limit and its reads were paused.
+    Counter floods;        ///< Throttled clients dropped because their input buffer filled up.
+    Counter reattached;    ///< Players restored from the snapshot of a previous run.
+
+    SharedHistogram loopTime;      ///< Work done per event loop iteration (excluding the wait).
+    SharedHistogram putTime;       ///< Handling one PUT, parsing included.
+    SharedHistogram stateLateness; ///< Wall-clock delay between a STATE's deadline and its sending.
+    SharedHistogram scoringTime;   ///< Computing the scores of one game's players in the shard.
+    SharedHistogram snapshotTime;  ///< Encoding the shard's players for a snapshot.
+};
+
+/**
+ * @brief Metrics of all shards, rendered as plain text on request.
+ */
+class Metrics {
+public:
+    /**
+     * @param shards Number of shards.
+     */
+    explicit Metrics(int shards);
+
+    /**
+     * @brief Returns the metrics of the given shard (for its thread to update).
+     */
+    ShardMetrics &shard(int index) { return *shards[index]; }
+
+    /**
+     * @brief Renders every metric as "name{labels} value" lines.
+     *
+     * Totals over all shards come first; with more than one shard each metric is
+     * repeated per shard with a shard="i" label. Histograms are reported as the count,
+     * selected quantiles and maximum, in nanoseconds.
+     */
+    std::string render() const;
+
+private:
+    std::vector<std::unique_ptr<ShardMetrics>> shards;
+};
+
+/**
+ * @brief Records the lifetime of the scope into a histogram.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(SharedHistogram &histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() { histogram.record(std::chrono::steady_clock::now() - start); }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    SharedHistogram &histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif // METRICS_HPP
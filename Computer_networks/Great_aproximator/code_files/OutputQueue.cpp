@@ -0,0 +1,68 @@
+#include "OutputQueue.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/uio.h>
+
+bool OutputQueue::push(std::string msg) {
+    if (bytes + msg.size() > MAX_BYTES) return false;
+    return push(std::make_shared<const std::string>(std::move(msg)));
+}
+
+bool OutputQueue::push(Message msg) {
+    if (bytes + msg->size() > MAX_BYTES) return false;
+    bytes += msg->size();
+    messages.push_back(std::move(msg));
+    return true;
+}
+
+OutputQueue::FlushStatus OutputQueue::flush(int fd, uint64_t *syscalls) {
+    while (!messages.empty()) {
+        struct iovec iov[MAX_IOV];
+        size_t count = prepare(iov, MAX_IOV);
+
+        ssize_t n = writev(fd, iov, static_cast<int>(count));
+        if (syscalls) ++*syscalls;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushStatus::Blocked;
+            return FlushStatus::Error;
+        }
+        consume(static_cast<size_t>(n));
+    }
+    return FlushStatus::Done;
+}
+
+size_t OutputQueue::prepare(struct iovec *iov, size_t maxCount, std::vector<Message> *hold) const {
+    size_t count = std::min(messages.size(), maxCount);
+    for (size_t i = 0; i < count; ++i) {
+        size_t skip = (i == 0) ? frontOffset : 0;
+        iov[i].iov_base = const_cast<char*>(messages[i]->data()) + skip;
+        iov[i].iov_len  = messages[i]->size() - skip;
+        if (hold) hold->push_back(messages[i]);
+    }
+    return count;
+}
+
+void OutputQueue::consume(size_t done) {
+    bytes -= done;
+    written += done;
+    while (done > 0) {
+        size_t left = messages.front()->size() - frontOffset;
+        if (done < left) {
+            frontOffset += done;
+            break;
+        }
+        done -= left;
+        messages.pop_front();
+        frontOffset = 0;
+    }
+}
+
+bool OutputQueue::empty() const {
+    return messages.empty();
+}
+
+size_t OutputQueue::size() const {
+    return bytes;
+}
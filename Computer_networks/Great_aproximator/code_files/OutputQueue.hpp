@@ -0,0 +1,111 @@
+#ifndef OUTPUT_QUEUE_HPP
+#define OUTPUT_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct iovec;
+
+/**
+ * @brief Per-connection queue of outgoing messages for a non-blocking socket.
+ *
+ * Messages are appended whole and written with writev(), so several queued
+ * COEFF/STATE/PENALTY messages leave in a single syscall. When the socket buffer
+ * is full, flushing stops and resumes once epoll reports the socket writable.
+ *
+ * Messages are immutable shared buffers, so a cached encoding (e.g. STATE) can be
+ * queued without copying it.
+ *
+ * For completion-based I/O (io_uring), prepare() describes the front of the queue and
+ * consume() drops what the kernel reports written; flush() is the two combined around
+ * a synchronous writev().
+ */
+class OutputQueue {
+public:
+    /// Outcome of a flush attempt.
+    enum class FlushStatus {
+        Done,    ///< Everything queued has been written.
+        Blocked, ///< The socket buffer is full; wait for EPOLLOUT.
+        Error    ///< The connection is broken.
+    };
+
+    /// Immutable message shared with its producer.
+    using Message = std::shared_ptr<const std::string>;
+
+    /// Maximum number of queued bytes; a client exceeding it is too slow and gets dropped.
+    static constexpr size_t MAX_BYTES = 8 << 20;
+
+    /// Maximum number of messages passed to a single write.
+    static constexpr size_t MAX_IOV = 64;
+
+    /**
+     * @brief Appends a message to the queue.
+     *
+     * @param msg Complete message (with "\r\n").
+     * @return false if the message would exceed MAX_BYTES (it is not queued).
+     */
+    bool push(std::string msg);
+
+    /**
+     * @brief Appends a shared message to the queue without copying it.
+     *
+     * @param msg Complete message (with "\r\n"); must not be modified afterwards.
+     * @return false if the message would exceed MAX_BYTES (it is not queued).
+     */
+    bool push(Message msg);
+
+    /**
+     * @brief Writes as much of the queue as the socket accepts without blocking.
+     *
+     * @param fd Non-blocking socket descriptor.
+     * @param syscalls If not null, incremented by the number of write calls made.
+     * @return FlushStatus describing why writing stopped.
+     */
+    FlushStatus flush(int fd, uint64_t *syscalls = nullptr);
+
+    /**
+     * @brief Describes the front of the queue for a write done elsewhere.
+     *
+     * @param iov Output: up to maxCount entries, the first one starting after the bytes
+     *            of the first message already written.
+     * @param maxCount Capacity of iov.
+     * @param hold If not null, receives the messages described, so that they outlive
+     *             an asynchronous write even if the queue is destroyed.
+     * @return Number of entries filled (0 if the queue is empty).
+     */
+    size_t prepare(struct iovec *iov, size_t maxCount, std::vector<Message> *hold = nullptr) const;
+
+    /**
+     * @brief Drops bytes from the front of the queue after they have been written.
+     *
+     * @param done Bytes written (at most size()).
+     */
+    void consume(size_t done);
+
+    /**
+     * @brief Returns true if nothing is waiting to be written.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns the number of bytes waiting to be written.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the number of bytes written to the socket so far.
+     */
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    std::deque<Message> messages;
+    size_t frontOffset = 0; ///< Bytes of the first message already written.
+    size_t bytes = 0;       ///< Total bytes not yet written.
+    uint64_t written = 0;   ///< Total bytes written so far.
+};
+
+#endif // OUTPUT_QUEUE_HPP
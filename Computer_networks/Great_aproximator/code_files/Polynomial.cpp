@@ -0,0 +1,32 @@
+#include "Polynomial.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+void evaluatePolynomial(const std::vector<double> &coeffs, int K, double *out) {
+    const int n = K + 1;
+    if (coeffs.empty()) {
+        std::fill(out, out + n, 0.0);
+        return;
+    }
+    const size_t degree = coeffs.size() - 1;
+    // Four points at a time: their Horner steps are independent, stay in registers for
+    // the whole polynomial and pair up into SIMD instructions.
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        double point[4], value[4];
+        for (int j = 0; j < 4; ++j) {
+            point[j] = x + j;
+            value[j] = coeffs[degree];
+        }
+        for (size_t i = degree; i-- > 0;) {
+            for (int j = 0; j < 4; ++j) value[j] = value[j] * point[j] + coeffs[i];
+        }
+        for (int j = 0; j < 4; ++j) out[x + j] = value[j];
+    }
+    for (; x < n; ++x) {
+        double value = coeffs[degree];
+        for (size_t i = degree; i-- > 0;) value = value * x + coeffs[i];
+        out[x] = value;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef POLYNOMIAL_HPP
+#define POLYNOMIAL_HPP
+
+#include <vector>
+
+/**
+ * @brief Evaluates a polynomial at x = 0..K with Horner's rule.
+ *
+ * Points are evaluated four at a time, side by side, so the compiler turns the
+ * Horner steps into SIMD instructions.
+ *
+ * @param coeffs Coefficients a0 ... aN (may be empty: f = 0).
+ * @param K Maximum point index.
+ * @param out Output: f(0) ... f(K).
+ */
+void evaluatePolynomial(const std::vector<double> &coeffs, int K, double *out);
+
+#endif // POLYNOMIAL_HPP
@@ -0,0 +1,34 @@
+#include "RoomTable.hpp"
+
+RoomTable::RoomTable(int M) : m(M) {}
+
+Room *RoomTable::join(const std::string &name, int fd) {
+    Room &room = rooms[name];
+    room.name = name;
+    room.members.insert(fd);
+    return &room;
+}
+
+bool RoomTable::addCorrectPut(Room *room, int count) {
+    if ((room->correctPutCount += count) < m || room->ended) return false;
+    room->ended = true;
+    ended.push_back(room);
+    return true;
+}
+
+void RoomTable::leave(Room *room, int fd, int correctPuts) {
+    room->members.erase(fd);
+    room->correctPutCount -= correctPuts;
+    if (room->members.empty() && !room->ended) erase(room);
+}
+
+std::vector<Room*> RoomTable::takeEnded() {
+    std::vector<Room*> result;
+    result.swap(ended);
+    return result;
+}
+
+void RoomTable::erase(Room *room) {
+    std::string name = room->name; // The key must outlive the erased node.
+    rooms.erase(name);
+}
@@ -0,0 +1,86 @@
+#ifndef ROOM_TABLE_HPP
+#define ROOM_TABLE_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief An independent game: its players, its count of correct PUTs and its own end.
+ */
+struct Room {
+    /// Room ID sent in HELLO, or "#<n>" for a room filled by matchmaking.
+    std::string name;
+
+    /// Sockets of the players in the room.
+    std::set<int> members;
+
+    /// Correct PUTs of the room's players; the game ends when it reaches M.
+    int correctPutCount = 0;
+
+    /// The room reached M and waits for finishRooms() to score it.
+    bool ended = false;
+};
+
+/**
+ * @brief Rooms owned by one shard.
+ *
+ * A room lives in exactly one shard, the one its ID hashes to (see
+ * GameCoordinator::roomShard()), so its players, counter and timers are only ever
+ * touched by that shard's thread and a room's end never stalls other rooms or shards.
+ * A room is created by its first player and erased when it is scored or left empty.
+ *
+ * Returned Room pointers stay valid until the room is erased.
+ */
+class RoomTable {
+public:
+    /**
+     * @brief Creates an empty table.
+     *
+     * @param M Number of correct PUTs that ends the game in a room.
+     */
+    explicit RoomTable(int M);
+
+    /**
+     * @brief Adds a player to the room with the given ID, creating it if needed.
+     */
+    Room *join(const std::string &name, int fd);
+
+    /**
+     * @brief Counts correct PUTs in the room (one, or a restored player's).
+     *
+     * @return true if the room has just reached M (it is queued for takeEnded()).
+     */
+    bool addCorrectPut(Room *room, int count = 1);
+
+    /**
+     * @brief Removes a disconnected player; an empty room that has not ended is erased.
+     *
+     * @param room The player's room.
+     * @param fd The player's socket.
+     * @param correctPuts The player's correct PUTs, which no longer count towards M.
+     */
+    void leave(Room *room, int fd, int correctPuts);
+
+    /**
+     * @brief Returns the rooms that reached M since the last call.
+     */
+    std::vector<Room*> takeEnded();
+
+    /**
+     * @brief Erases a room (after its SCORING has been sent).
+     */
+    void erase(Room *room);
+
+    /// Number of rooms currently open.
+    size_t count() const { return rooms.size(); }
+
+private:
+    const int m;
+
+    std::map<std::string, Room> rooms;
+    std::vector<Room*> ended;
+};
+
+#endif // ROOM_TABLE_HPP
@@ -0,0 +1,102 @@
+#include "Scoring.hpp"
+#include "Polynomial.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+
+/// Most players in one work item; the item evaluates f once for all of them.
+static const size_t PLAYERS_PER_ITEM = 256;
+
+/// Rounds with less work (values compared) than this are scored on the calling thread.
+static const size_t PARALLEL_THRESHOLD = 1 << 18;
+
+double squaredError(const double *approx, const double *f, int n) {
+    // Four independent partial sums: the additions do not wait for each other and
+    // pair up into SIMD instructions.
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    int x = 0;
+    for (; x + 4 <= n; x += 4) {
+        for (int j = 0; j < 4; ++j) {
+            double diff = approx[x + j] - f[x + j];
+            sum[j] += diff * diff;
+        }
+    }
+    for (; x < n; ++x) {
+        double diff = approx[x] - f[x];
+        sum[0] += diff * diff;
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+namespace {
+
+/// Players of one group (same coefficients) scored together.
+struct WorkItem {
+    const std::vector<double> *coeffs;
+    size_t begin; ///< Range in the grouped player order.
+    size_t end;
+};
+
+} // namespace
+
+std::vector<double> computeScores(const std::vector<ScoringInput> &players, int K,
+                                  ThreadPool &pool)
+{
+    std::vector<double> scores(players.size());
+    if (players.empty()) return scores;
+
+    // Group the players by coefficient set (counting sort on the group index).
+    std::unordered_map<const std::vector<double> *, size_t> groupOf;
+    std::vector<size_t> playerGroup(players.size());
+    std::vector<const std::vector<double> *> groupCoeffs;
+    std::vector<size_t> groupStart;
+    for (size_t p = 0; p < players.size(); ++p) {
+        auto inserted = groupOf.emplace(players[p].coeffs, groupCoeffs.size());
+        if (inserted.second) {
+            groupCoeffs.push_back(players[p].coeffs);
+            groupStart.push_back(0);
+        }
+        playerGroup[p] = inserted.first->second;
+        ++groupStart[playerGroup[p]];
+    }
+    size_t offset = 0;
+    for (size_t &start : groupStart) {
+        size_t count = start;
+        start = offset;
+        offset += count;
+    }
+    std::vector<size_t> order(players.size());
+    std::vector<size_t> next = groupStart;
+    for (size_t p = 0; p < players.size(); ++p) order[next[playerGroup[p]]++] = p;
+
+    std::vector<WorkItem> items;
+    for (size_t g = 0; g < groupCoeffs.size(); ++g) {
+        size_t end = g + 1 < groupStart.size() ? groupStart[g + 1] : players.size();
+        for (size_t begin = groupStart[g]; begin < end; begin += PLAYERS_PER_ITEM) {
+            items.push_back({groupCoeffs[g], begin, std::min(begin + PLAYERS_PER_ITEM, end)});
+        }
+    }
+
+    static const std::vector<double> none;
+    const int n = K + 1;
+    auto scoreItem = [&](size_t i) {
+        thread_local std::vector<double> f;
+        f.resize(n);
+        const WorkItem &item = items[i];
+        evaluatePolynomial(item.coeffs ? *item.coeffs : none, K, f.data());
+        for (size_t j = item.begin; j < item.end; ++j) {
+            const ScoringInput &player = players[order[j]];
+            scores[order[j]] = squaredError(player.approx, f.data(), n) + player.penalty;
+        }
+    };
+
+    size_t work = (players.size() + groupCoeffs.size()) * static_cast<size_t>(n);
+    if (work < PARALLEL_THRESHOLD) {
+        for (size_t i = 0; i < items.size(); ++i) scoreItem(i);
+    } else {
+        pool.parallelFor(items.size(), scoreItem);
+    }
+    return scores;
+}
@@ -0,0 +1,43 @@
+#ifndef SCORING_HPP
+#define SCORING_HPP
+
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+/**
+ * @brief What is needed to score one player.
+ */
+struct ScoringInput {
+    /// Coefficients of the player's polynomial, or nullptr if it has none (f = 0).
+    const std::vector<double> *coeffs;
+
+    /// The player's approximation f̂(0..K).
+    const double *approx;
+
+    /// Penalty points.
+    int penalty;
+};
+
+/**
+ * @brief Returns the sum of (approx[x] - f[x])^2 over x = 0..n-1.
+ */
+double squaredError(const double *approx, const double *f, int n);
+
+/**
+ * @brief Computes every player's score: squared error over 0..K plus penalties.
+ *
+ * Players are grouped by coefficient set (players given the same COEFF line share
+ * it), so f(0..K) is evaluated once per group rather than once per player. Large
+ * rounds are split into work items of a group's players and spread over the pool;
+ * small ones are scored on the calling thread.
+ *
+ * @param players The players.
+ * @param K Maximum point index.
+ * @param pool Threads to score on.
+ * @return The scores, in the order of players.
+ */
+std::vector<double> computeScores(const std::vector<ScoringInput> &players, int K,
+                                  ThreadPool &pool);
+
+#endif // SCORING_HPP
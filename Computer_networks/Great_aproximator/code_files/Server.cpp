@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstring>
 #include <map>
+#include <memory>
 #include <unistd.h>
 #include <netdb.h>
 #include <thread>
@@ -10,19 +11,29 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/time.h>
-#include <fstream>
+#include <sys/stat.h>
+#include <sys/un.h>
 
 #include "utils.hpp"
+#include "binary_protocol.hpp"
 #include "protocol.hpp"
 #include "Server.hpp"
 #include "ClientState.hpp"
+#include "GameCoordinator.hpp"
+#include "RoomTable.hpp"
+#include "GameClock.hpp"
+#include "Logger.hpp"
+#include "Scoring.hpp"
+#include "SnapshotStore.hpp"
+#include "TraceRecorder.hpp"
 
 
 /**
  * @brief Returns a string representation of the client's IP and port.
  *
  * @param fd Socket descriptor.
- * @return Formatted string "[ip]:port" or "[UNKNOWN]:0" on error.
+ * @return Formatted string "[ip]:port", "[local]:0" for a Unix-domain socket, or
+ *         "[UNKNOWN]:0" on error.
  */
 std::string peerAddressPort(int fd) {
     sockaddr_storage addr{};
@@ -30,6 +41,9 @@ std::string peerAddressPort(int fd) {
     if (getpeername(fd, (sockaddr*)&addr, &len) < 0) {
         return "[UNKNOWN]:0";
     }
+    if (addr.ss_family == AF_UNIX) {
+        return "[local]:0";
+    }
     char ipbuf[INET6_ADDRSTRLEN];
     uint16_t port = 0;
 
@@ -48,10 +62,14 @@ std::string peerAddressPort(int fd) {
 /**
  * @brief Sets up a listening socket that accepts both IPv4 and IPv6 connections.
  *
+ * With reusePort, several sockets (one per shard) can be bound to the same port and
+ * the kernel spreads incoming connections between them.
+ *
  * @param port Port number to bind to (0 means any available port).
+ * @param reusePort Whether to set SO_REUSEPORT.
  * @return Listening socket descriptor or -1 on error.
  */
-int setupListeningSocket(int port) {
+int setupListeningSocket(int port, bool reusePort) {
     int listenFd = socket(AF_INET6, SOCK_STREAM, 0);
     if (listenFd < 0) {
         std::cerr << "ERROR: socket(): " << strerror(errno) << "\n";
@@ -64,8 +82,14 @@ int setupListeningSocket(int port) {
         close(listenFd);
         return -1;
     }
+    if (reusePort && setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) < 0) {
+        std::cerr << "ERROR: setsockopt(SO_REUSEPORT): " << strerror(errno) << "\n";
+        close(listenFd);
+        return -1;
+    }
     // Disable IPV6_V6ONLY to support IPv4-mapped addresses
-    if (setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &yes, sizeof(yes)) < 0) {
+    int no = 0;
+    if (setsockopt(listenFd, IPPROTO_IPV6, IPV6_V6ONLY, &no, sizeof(no)) < 0) {
         std::cerr << "ERROR: setsockopt(IPV6_V6ONLY): " << strerror(errno) << "\n";
         close(listenFd);
         return -1;
@@ -89,7 +113,13 @@ int setupListeningSocket(int port) {
         }
     }
 
-    if (listen(listenFd, 10) < 0) {
+    if (!setNonBlocking(listenFd)) {
+        std::cerr << "ERROR: fcntl(O_NONBLOCK): " << strerror(errno) << "\n";
+        close(listenFd);
+        return -1;
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) {
         std::cerr << "ERROR: listen(): " << strerror(errno) << "\n";
         close(listenFd);
         return -1;
@@ -100,146 +130,378 @@ int setupListeningSocket(int port) {
 }
 
 /**
- * @brief Accepts a new client connection and adds it to the clients map.
+ * @brief Sets up a listening Unix-domain socket for clients on the same host.
+ *
+ * Local clients skip the TCP/IP stack (no checksums, segmentation or loopback routing)
+ * and speak the same protocol. A stale socket file left at the path (one that refuses
+ * connections) is replaced; if a server still listens on it, this fails instead.
  *
- * @param listenFd Listening socket descriptor.
- * @param clients Map of active clients.
- * @param K Upper bound of the function domain.
+ * @param path Filesystem path to bind to.
+ * @return Listening socket descriptor or -1 on error.
  */
-void acceptNewClient(int listenFd,
-                     std::map<int, ClientState> &clients,
-                     int K) {
-    struct sockaddr_storage clientAddr{};
-    socklen_t addrLen = sizeof(clientAddr);
-    int clientFd = accept(listenFd, (struct sockaddr*)&clientAddr, &addrLen);
-    if (clientFd < 0) {
-        std::cerr << "ERROR: accept(): " << strerror(errno) << "\n";
-    } else {
-        clients.emplace(clientFd, ClientState(clientFd, K));
-        auto &state = clients.find(clientFd)->second;
-        state.helloDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
-        std::cout << "New client (fd=" << clientFd << ") connected.\n";
+int setupLocalSocket(const std::string &path) {
+    struct sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "ERROR: invalid Unix socket path: " << path << "\n";
+        return -1;
     }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listenFd < 0) {
+        std::cerr << "ERROR: socket(AF_UNIX): " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        // The file is stale only if nobody accepts connections on it any more; a socket
+        // of a running server is left alone, like a TCP port that is in use.
+        int probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool stale = probeFd >= 0
+                  && connect(probeFd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+                  && errno == ECONNREFUSED;
+        if (probeFd >= 0) close(probeFd);
+        if (!stale) {
+            std::cerr << "ERROR: bind(" << path << "): " << strerror(EADDRINUSE) << "\n";
+            close(listenFd);
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::cerr << "ERROR: bind(" << path << "): " << strerror(errno) << "\n";
+        close(listenFd);
+        return -1;
+    }
+
+    if (listen(listenFd, SOMAXCONN) < 0) {
+        std::cerr << "ERROR: listen(): " << strerror(errno) << "\n";
+        close(listenFd);
+        return -1;
+    }
+
+    std::cout << "Server listening on unix:" << path << "\n";
+    return listenFd;
+}
+
+/// How long a client may take to read SCORING before it is closed anyway.
+static const auto LINGER_TIMEOUT = std::chrono::seconds(5);
+
+/// Pause between the end of the global game and the start of the next one.
+static const auto ROUND_PAUSE = std::chrono::seconds(1);
+
+/**
+ * @brief Records a message queued for the client in the traffic trace.
+ */
+static void recordReply(const ClientState &state, const std::string &msg) {
+    TraceRecorder::recordReply(state.traceId, msg);
+}
+
+static void recordReply(const ClientState &state, const OutputQueue::Message &msg) {
+    TraceRecorder::recordReply(state.traceId, *msg);
 }
 
 /**
- * @brief Processes a single message from the client.
+ * @brief Queues a message for the client; it is written on the next flush.
  *
- * Handles the HELLO, PUT, or invalid messages. Updates the client state, enqueues
- * BAD_PUT or STATE responses, and manages penalties. If the client disconnects or
- * sends an invalid first message, the socket is closed and true is returned.
+ * @param state State of the client.
+ * @param msg Complete message (with "\r\n") or binary frame.
+ * @return false if the client's output queue is over its limit (the client is too slow).
+ */
+template <typename Message>
+static bool queueMessage(ClientState &state, Message &&msg) {
+    if (state.traceId) recordReply(state, msg);
+    if (state.output.push(std::forward<Message>(msg))) return true;
+    std::cerr << "ERROR: output queue of client (fd=" << state.sockfd
+              << ") exceeded " << OutputQueue::MAX_BYTES << " bytes. Disconnecting.\n";
+    return false;
+}
+
+/**
+ * @brief Writes the client's queued messages without blocking.
+ *
+ * If the socket buffer fills up (or the write is queued by io_uring), the rest is
+ * written on the client's next Writable event. A closing client is closed once its
+ * queue is empty.
  *
  * @param fd Socket descriptor of the client.
- * @param clients Map of connected clients.
- * @param correctPutCount Reference to the global count of correct PUTs.
- * @param K Max value of x in f(x).
- * @param coeffFile File stream containing COEFF lines.
- * @return true if the client should be removed; false otherwise.
+ * @param state State of the client.
+ * @param shard The shard the client belongs to.
+ * @return true if the socket was closed and the client should be removed; false otherwise.
  */
-bool handleClientMessage(int fd,
-                         std::map<int, ClientState> &clients,
-                         int &correctPutCount,
-                         int K,
-                         std::ifstream &coeffFile)
-{
-    auto it = clients.find(fd);
-    if (it == clients.end()) return false;
+bool flushClientOutput(int fd, ClientState &state, ShardState &shard) {
+    uint64_t before = state.output.bytesWritten();
+    OutputQueue::FlushStatus status = shard.io.send(fd, state.output);
+    shard.metrics.bytesOut.add(state.output.bytesWritten() - before);
+    if (status == OutputQueue::FlushStatus::Error) {
+        Logger::log(LogEvent::ClientDisconnected, fd);
+        close(fd);
+        return true;
+    }
+    if (status == OutputQueue::FlushStatus::Done && state.closing) {
+        close(fd);
+        return true;
+    }
+    return false;
+}
 
-    ClientState &state = it->second;
+/**
+ * @brief Adds a newly accepted client to the clients map and starts its HELLO timeout.
+ *
+ * If too many connections are awaiting HELLO already (server option -q), the new one
+ * is closed at once.
+ *
+ * @param clientFd Socket descriptor of the client, registered with the I/O engine.
+ * @param shard The shard the new client is added to.
+ */
+void acceptClient(int clientFd, ShardState &shard) {
+    if (!shard.game.admitConnection()) {
+        shard.metrics.refused.add();
+        Logger::log(LogEvent::ClientRefused, clientFd);
+        // The engine lets go of the socket (cancelling its recv) before the number is free.
+        shard.io.removeClient(clientFd);
+        close(clientFd);
+        return;
+    }
+    ClientState &state = shard.clients.insert(ClientState(clientFd, shard.game.K()));
+    state.awaitingHello = shard.game.limits().maxAwaitingHello > 0;
+    if (TraceRecorder::enabled()) {
+        state.traceId = TraceRecorder::newConnection();
+        TraceRecorder::record(state.traceId, TraceKind::Open);
+    }
+    state.helloTimer = shard.timers.schedule(GameClock::now() + std::chrono::seconds(3),
+                                       clientFd, TimerKind::Hello);
+    shard.metrics.connections.add();
+    Logger::log(LogEvent::ClientConnected, clientFd);
+}
 
-    bool success;
-    std::string msg = readLine(fd, success);
-    if (!success) {
-        std::cout << "Client (fd=" << fd << ") disconnected.\n";
+/**
+ * @brief Sends COEFF to a client whose HELLO was accepted and puts it into its room.
+ *
+ * A client with a room ID (sent in HELLO or assigned by matchmaking) joins that room;
+ * otherwise it plays the global game. A player restored from a snapshot gets its old
+ * COEFF, f̂ and penalty back, and its correct PUTs count towards M again.
+ *
+ * @param fd Socket descriptor of the client.
+ * @param state State of the client (playerId and roomName already set).
+ * @param shard The shard that owns the client's room.
+ * @return true if the client was closed and should be removed; false otherwise.
+ */
+static bool joinGame(int fd, ClientState &state, ShardState &shard) {
+    std::unique_ptr<SnapshotPlayer> restored = std::move(state.profile->restored);
+    // Parsed and encoded when the file was loaded; nothing is read or formatted here.
+    std::shared_ptr<const CoeffStore::Entry> coeff =
+        restored ? CoeffStore::makeEntry(std::move(restored->coeffs)) : shard.game.coeffs().next();
+    if (!coeff) {
+        std::cerr << "ERROR: missing COEFF line in file\n";
         close(fd);
         return true;
     }
 
-    auto tokens = splitBySpace(msg);
-    if (!state.hasSentCoeff) {
-        if (tokens.size() != 2 || tokens[0] != "HELLO") {
-            std::string addrPort = peerAddressPort(fd);
-            std::cerr << "ERROR: bad message from "
-                      << addrPort << ", UNKNOWN: " << msg << "\n";
-            close(fd);
-            return true;
-        }
-        state.playerId = tokens[1];
-        for (char c : state.playerId)
-            if (islower(c)) state.lowercase++;
+    // Shares the coefficients with the store entry instead of copying them.
+    state.profile->coeffs = std::shared_ptr<const std::vector<double>>(coeff, &coeff->coeffs);
+    state.hasSentCoeff = true;
+    if (!queueMessage(state, state.binary ? coeff->binaryMessage : coeff->message)) {
+        close(fd);
+        return true;
+    }
 
-        std::string coeffLine;
-        if (!std::getline(coeffFile, coeffLine)) {
-            std::cerr << "ERROR: missing COEFF line in file\n";
-            close(fd);
-            return true;
+    if (!state.profile->roomName.empty()) {
+        state.room = shard.rooms.join(state.profile->roomName, fd);
+    }
+
+    if (restored) {
+        double *approx = shard.clients.approx(state);
+        for (const auto &[point, value] : restored->approx) {
+            approx[point] = value;
+            state.touchedPoints.push_back(point);
+            state.stateMsg.update(approx, static_cast<int>(point));
         }
+        state.penalty = restored->penalty;
+        state.correctPutCountForThisClient = restored->correctPuts;
+        if (state.room) shard.rooms.addCorrectPut(state.room, restored->correctPuts);
+        else shard.game.addCorrectPut(restored->correctPuts);
+        shard.metrics.reattached.add();
+        Logger::log(LogEvent::PlayerReattached, fd, state.profile->playerId,
+                    state.room ? std::string_view(state.room->name) : std::string_view(),
+                    static_cast<uint32_t>(restored->correctPuts));
+    }
+
+    Logger::log(LogEvent::CoeffSent, fd, state.profile->playerId,
+                state.room ? std::string_view(state.room->name) : std::string_view());
+    return false;
+}
 
-        coeffLine = trimCRLF(coeffLine);
-        auto tokens2 = splitBySpace(coeffLine);
-        if (!parseCOEFF(tokens2, state.coeffs)) {
-            std::cerr << "ERROR: invalid COEFF line in file: " << coeffLine << "\n";
+/**
+ * @brief Rejects a PUT: BAD_PUT is sent after 1 second and the client is penalised.
+ *
+ * @param fd Socket descriptor of the client.
+ * @param state State of the client.
+ * @param badPutMsg BAD_PUT echoing the PUT, in the client's encoding.
+ * @param shard The shard the client belongs to.
+ */
+static void rejectPut(int fd, ClientState &state, std::string &&badPutMsg, ShardState &shard) {
+    state.pendingBadPut = true;
+    state.profile->badPutMsg = std::move(badPutMsg);
+    // A newer BAD_PUT replaces the pending one; the old timer becomes stale.
+    state.badPutTimer = shard.timers.schedule(GameClock::now()
+                                        + std::chrono::seconds(1), fd, TimerKind::BadPut);
+    state.penalty += 10;
+    state.snapshotRecord.clear();
+    shard.metrics.badPuts.add();
+}
+
+/**
+ * @brief Handles a valid PUT: it is penalised if the previous STATE is still pending,
+ *        otherwise it is added to the approximation and STATE is scheduled.
+ *
+ * @param fd Socket descriptor of the client.
+ * @param state State of the client.
+ * @param point Point of the PUT (0..K).
+ * @param val Value of the PUT ([-5, 5]).
+ * @param makePenalty Builds PENALTY echoing the PUT in the client's encoding; called
+ *                    only if the PUT is penalised.
+ * @param shard The shard the client belongs to.
+ * @return true if the client should be removed; false otherwise.
+ */
+template <typename MakePenalty>
+static bool acceptPut(int fd, ClientState &state, int point, double val,
+                      MakePenalty &&makePenalty, ShardState &shard)
+{
+    state.snapshotRecord.clear();
+    if (state.pendingState) {
+        state.penalty += 20;
+        shard.metrics.penalties.add();
+        if (!queueMessage(state, makePenalty())) {
             close(fd);
             return true;
         }
+        Logger::log(LogEvent::PenaltySent, fd, state.profile->playerId);
+        return false;
+    }
 
-        state.hasSentCoeff = true;
-        std::string outMsg = "COEFF";
-        for (double v : state.coeffs) outMsg += " " + std::to_string(v);
-        outMsg += CRLF;
+    double *approx = shard.clients.approx(state);
+    if (approx[point] == 0.0) state.touchedPoints.push_back(static_cast<uint32_t>(point));
+    approx[point] += val;
+    state.pendingState = true;
+    state.correctPutCountForThisClient++;
+    shard.metrics.puts.add();
+    if (state.room) shard.rooms.addCorrectPut(state.room);
+    else shard.game.addCorrectPut();
+
+    state.stateMsg.update(approx, point);
+    state.stateTimer = shard.timers.schedule(GameClock::now()
+                                       + std::chrono::seconds(state.lowercase),
+                                       fd, TimerKind::State);
+    return false;
+}
 
-        if (!writeAll(fd, outMsg)) {
-            std::cerr << "ERROR: failed to send COEFF to client (fd=" << fd << ")\n";
+/**
+ * @brief Processes a single message from the client.
+ *
+ * Handles the HELLO (or HELLO_BIN), PUT, or invalid messages. Updates the client state,
+ * enqueues BAD_PUT or STATE responses, and manages penalties. If the client sends an invalid
+ * first message, the socket is closed and true is returned. If HELLO names a room
+ * owned by another shard, the client is handed off to it and true is returned too.
+ *
+ * @param fd Socket descriptor of the client.
+ * @param state State of the client.
+ * @param msg The message without "\r\n" (a view into the client's input buffer).
+ * @param shard The shard the client belongs to.
+ * @return true if the client should be removed; false otherwise.
+ */
+static bool handleClientLine(int fd,
+                             ClientState &state,
+                             std::string_view msg,
+                             ShardState &shard)
+{
+    // Reused across calls, so tokenizing a message does not allocate.
+    static thread_local std::vector<std::string_view> tokens;
+    splitBySpace(msg, tokens);
+    if (!state.hasSentCoeff) {
+        if ((tokens.size() != 2 && tokens.size() != 3) ||
+            (tokens[0] != "HELLO" && tokens[0] != HELLO_BINARY)) {
+            std::string addrPort = peerAddressPort(fd);
+            std::cerr << "ERROR: bad message from "
+                      << addrPort << ", UNKNOWN: " << msg << "\n";
             close(fd);
             return true;
-        } else {
-            std::cout << state.playerId << " received COEFF.\n";
         }
-        return false;
+        if (state.awaitingHello) {
+            state.awaitingHello = false;
+            shard.game.helloDone();
+        }
+        if (tokens[0] == HELLO_BINARY) {
+            state.binary = true;
+            state.stateMsg = StateEncoder(shard.game.K(), true);
+        }
+        ClientProfile &profile = *state.profile;
+        profile.playerId = std::string(tokens[1]);
+        for (char c : profile.playerId)
+            if (islower(c)) state.lowercase++;
+        if (tokens.size() == 3) profile.roomName = std::string(tokens[2]);
+        // A player of the previous run keeps its room, matchmade ones included.
+        if (SnapshotStore::claim(profile.playerId, profile.roomName, profile.restored)) {
+            profile.roomName = profile.restored->roomName;
+        } else if (profile.roomName.empty() && shard.game.roomSize() > 0) {
+            profile.roomName = shard.game.nextMatchmadeRoom();
+        }
+
+        // A room lives in one shard; the client moves there with its buffered input.
+        if (!profile.roomName.empty()) {
+            int owner = shard.game.roomShard(profile.roomName);
+            if (owner != shard.index) {
+                if (!shard.io.releaseClient(fd, state.input, state.output)) {
+                    close(fd);
+                    return true;
+                }
+                // Reads resume in the owner, which does not know the pause.
+                state.throttled = false;
+                state.resumeTimer = 0;
+                shard.game.handOff(owner, std::move(state));
+                state.traceId = 0; // the connection lives on in the owner's trace records
+                return true;
+            }
+        } else if (shard.roundPaused) {
+            // The input that follows HELLO is left alone until the next game starts.
+            state.waitingForRound = true;
+            state.helloTimer = 0;
+            shard.io.pauseClient(fd);
+            shard.roundWaiters.push_back(fd);
+            return false;
+        }
+        return joinGame(fd, state, shard);
     }
 
     if (tokens.empty()) return false;
 
     if (tokens[0] == "PUT") {
+        ScopedTimer timer(shard.metrics.putTime);
         int point;
         double val;
 
         if (tokens.size() != 3 ||
-            !parseInteger(tokens[1], point) || point < 0 || point > K ||
+            !parseInteger(tokens[1], point) || point < 0 || point > shard.game.K() ||
             !parseReal(tokens[2], val) || val < -5.0 || val > 5.0) {
-            state.pendingBadPut = true;
-            state.badPutMsg = "BAD_PUT";
-            if (tokens.size() > 1) state.badPutMsg += " " + tokens[1];
-            if (tokens.size() > 2) state.badPutMsg += " " + tokens[2];
-            state.badPutMsg += CRLF;
-            state.badPutAt = std::chrono::steady_clock::now() + std::chrono::seconds(1);
-            state.penalty += 10;
+            std::string badPutMsg = "BAD_PUT";
+            if (tokens.size() > 1) badPutMsg.append(" ").append(tokens[1]);
+            if (tokens.size() > 2) badPutMsg.append(" ").append(tokens[2]);
+            badPutMsg += CRLF;
+            rejectPut(fd, state, std::move(badPutMsg), shard);
             return false;
         }
 
-        if (state.pendingState) {
-            std::string out = "PENALTY " + tokens[1] + " " + tokens[2] + CRLF;
-            writeAll(fd, out);
-            std::cout << "Sent PENALTY to " << state.playerId << "\n";
-            state.penalty += 20;
-            return false;
-        }
-
-        state.approx[point] += val;
-        state.pendingState = true;
-        state.correctPutCountForThisClient++;
-        correctPutCount++;
-
-        state.stateMsg = "STATE";
-        for (int x = 0; x <= K; ++x) {
-            state.stateMsg += " " + std::to_string(state.approx[x]);
-        }
-        state.stateMsg += CRLF;
-        state.stateAt = std::chrono::steady_clock::now()
-                      + std::chrono::seconds(state.lowercase);
+        return acceptPut(fd, state, point, val, [&]{
+            std::string penaltyMsg = "PENALTY ";
+            penaltyMsg.append(tokens[1]).append(" ").append(tokens[2]).append(CRLF);
+            return penaltyMsg;
+        }, shard);
     } else {
         std::string addrPort = peerAddressPort(fd);
-        std::string player = state.playerId.empty() ? "UNKNOWN" : state.playerId;
+        const std::string &id = state.profile->playerId;
+        std::string player = id.empty() ? "UNKNOWN" : id;
         std::cerr << "ERROR: bad message from "
                   << addrPort << ", " << player << ": " << msg << "\n";
     }
@@ -248,76 +510,503 @@ bool handleClientMessage(int fd,
 }
 
 /**
- * @brief Sends delayed responses (BAD_PUT or STATE) when the delay has passed.
+ * @brief Processes a single binary frame from a client that sent HELLO_BIN.
  *
- * Iterates through all clients and sends the pending message if the corresponding
- * delay deadline has passed. Resets flags accordingly.
+ * The only frame a client may send is PUT; it is validated like its text form, and
+ * BAD_PUT / PENALTY echo its payload. Other frames are reported and ignored.
  *
- * @param clients Map of connected clients.
+ * @param fd Socket descriptor of the client.
+ * @param state State of the client.
+ * @param frame The frame without its length (a view into the client's input buffer).
+ * @param shard The shard the client belongs to.
+ * @return true if the client should be removed; false otherwise.
  */
-void checkTimers(std::map<int, ClientState> &clients)
+static bool handleClientFrame(int fd,
+                              ClientState &state,
+                              std::string_view frame,
+                              ShardState &shard)
 {
-    auto now = std::chrono::steady_clock::now();
-    for (auto & [fd, state] : clients) {
-        if (state.pendingBadPut && now >= state.badPutAt) {
-            writeAll(fd, state.badPutMsg);
-            state.pendingBadPut = false;
-            std::cout << "Sent BAD_PUT to " << state.playerId << "\n";
+    FrameType type;
+    std::string_view payload;
+    if (splitFrame(frame, type, payload) && type == FrameType::PUT) {
+        ScopedTimer timer(shard.metrics.putTime);
+        uint32_t point;
+        double val;
+        // The negated range test also rejects NaN.
+        if (!parseBinaryPUT(payload, point, val) ||
+            point > static_cast<uint32_t>(shard.game.K()) || !(val >= -5.0 && val <= 5.0)) {
+            rejectPut(fd, state, makeFrame(FrameType::BAD_PUT, payload), shard);
+            return false;
         }
-        if (state.pendingState && now >= state.stateAt) {
-            writeAll(fd, state.stateMsg);
-            state.pendingState = false;
-            std::cout << "Sent STATE to " << state.playerId << "\n";
+        return acceptPut(fd, state, static_cast<int>(point), val,
+                         [&]{ return makeFrame(FrameType::PENALTY, payload); }, shard);
+    }
+
+    std::cerr << "ERROR: bad message from " << peerAddressPort(fd) << ", " << state.profile->playerId
+              << ": binary frame of type " << static_cast<int>(frame[0]) << "\n";
+    return false;
+}
+
+/**
+ * @brief Processes all messages currently available from the client.
+ *
+ * Takes everything the I/O engine has for the client into its input buffer in large
+ * chunks and handles every complete line in one pass, so pipelined messages cost one
+ * wakeup. Responses produced meanwhile are flushed together at the end. If the client
+ * disconnects or has to be dropped, the socket is closed and true is returned.
+ *
+ * With rate limits (server options -l and -b), every message takes a line token before
+ * it is parsed and every byte received takes a byte token. A client that runs out stops
+ * being read until it has tokens again (a Resume timer); one that fills its whole input
+ * buffer meanwhile is dropped as a flood.
+ *
+ * @param event Readable event of the client.
+ * @param shard The shard the client belongs to.
+ * @return true if the client should be removed; false otherwise.
+ */
+bool handleClientMessage(IoEvent &event, ShardState &shard)
+{
+    int fd = event.fd;
+    ClientState *client = shard.clients.find(fd);
+    if (!client) return false;
+
+    ClientState &state = *client;
+    const ClientLimits &limits = shard.game.limits();
+    const bool lineLimit = limits.linesPerSecond > 0;
+    const bool byteLimit = limits.bytesPerSecond > 0;
+    GameClock::time_point now{};
+    if (lineLimit || byteLimit) {
+        now = GameClock::now();
+        if (lineLimit) state.lineTokens.refill(limits.linesPerSecond, now);
+        if (byteLimit) state.byteTokens.refill(limits.bytesPerSecond, now);
+    }
+
+    while (true) {
+        uint64_t before = state.input.bytesRead();
+        LineBuffer::FillStatus status = shard.io.receive(event, state.input);
+        uint64_t received = state.input.bytesRead() - before;
+        shard.metrics.bytesIn.add(received);
+        if (byteLimit) state.byteTokens.take(static_cast<double>(received));
+
+        // Messages received before a disconnect are still handled. A closing client's game
+        // is over, so its input is discarded. HELLO_BIN switches the framing of everything
+        // after it, so the mode is checked again for every message.
+        std::string_view msg;
+        while (!(lineLimit && state.lineTokens.empty()) && !state.waitingForRound) {
+            if (state.binary) {
+                LineBuffer::FrameStatus frameStatus = state.input.nextFrame(msg);
+                if (frameStatus == LineBuffer::FrameStatus::Incomplete) break;
+                if (frameStatus == LineBuffer::FrameStatus::Invalid) {
+                    std::cerr << "ERROR: invalid frame length from " << peerAddressPort(fd) << "\n";
+                    close(fd);
+                    return true;
+                }
+                if (lineLimit) state.lineTokens.take(1);
+                if (state.closing) continue;
+                if (state.traceId) TraceRecorder::record(state.traceId, TraceKind::Frame, msg);
+                if (handleClientFrame(fd, state, msg, shard)) return true;
+            } else {
+                if (!state.input.nextLine(msg)) break;
+                if (lineLimit) state.lineTokens.take(1);
+                if (state.closing) continue;
+                if (state.traceId) TraceRecorder::record(state.traceId, TraceKind::Line, msg);
+                if (handleClientLine(fd, state, msg, shard)) return true;
+            }
+        }
+
+        // Its reads are paused; startGlobalRound() handles the rest of the input.
+        if (state.waitingForRound) return flushClientOutput(fd, state, shard);
+
+        // Out of tokens: the engine stops reading, and the bytes it holds already are
+        // still taken, so the loop goes on until the input is drained or full.
+        const bool outOfTokens = (lineLimit && state.lineTokens.empty()) ||
+                                 (byteLimit && state.byteTokens.empty());
+        if (outOfTokens) {
+            shard.io.pauseClient(fd);
+            if (!state.throttled) {
+                state.throttled = true;
+                shard.metrics.throttled.add();
+                Logger::log(LogEvent::ClientThrottled, fd);
+            }
+        }
+
+        if (status == LineBuffer::FillStatus::Drained) {
+            // A client that kept within its limits since it was resumed counts as new.
+            if (!outOfTokens) state.throttled = false;
+            if (outOfTokens && !state.resumeTimer) {
+                GameClock::duration wait = GameClock::duration::zero();
+                if (lineLimit) wait = std::max(wait, state.lineTokens.untilReady(limits.linesPerSecond));
+                if (byteLimit) wait = std::max(wait, state.byteTokens.untilReady(limits.bytesPerSecond));
+                state.resumeTimer = shard.timers.schedule(now + wait, fd, TimerKind::Resume);
+            }
+            return flushClientOutput(fd, state, shard);
+        }
+        if (status == LineBuffer::FillStatus::Closed) {
+            Logger::log(LogEvent::ClientDisconnected, fd);
+            close(fd);
+            return true;
+        }
+        if (state.input.full() && outOfTokens) {
+            std::cerr << "ERROR: input flood from " << peerAddressPort(fd) << "\n";
+            shard.metrics.floods.add();
+            close(fd);
+            return true;
+        }
+        if (state.input.full()) {
+            std::cerr << "ERROR: line too long from " << peerAddressPort(fd) << "\n";
+            close(fd);
+            return true;
         }
     }
 }
 
 /**
- * @brief Sends the SCORING message to all clients and resets server state.
+ * @brief Dispatches a client event: input is handled, a completed or possible write
+ *        lets the rest of the output go.
  *
- * Computes squared error + penalties for each client, sends SCORING message,
- * closes connections, clears client map, and resets PUT counter.
+ * @param event The event.
+ * @param shard The shard the client belongs to.
+ * @return true if the client should be removed; false otherwise.
+ */
+bool handleClientEvent(IoEvent &event, ShardState &shard)
+{
+    if (event.kind == IoEventKind::Readable) return handleClientMessage(event, shard);
+
+    ClientState *client = shard.clients.find(event.fd);
+    if (!client) return false;
+    uint64_t before = client->output.bytesWritten();
+    bool ok = shard.io.sent(event, client->output);
+    shard.metrics.bytesOut.add(client->output.bytesWritten() - before);
+    if (!ok) {
+        Logger::log(LogEvent::ClientDisconnected, event.fd);
+        close(event.fd);
+        return true;
+    }
+    return flushClientOutput(event.fd, *client, shard);
+}
+
+/**
+ * @brief Starts the next global game after the pause: the clients that sent HELLO
+ *        meanwhile get COEFF, and the input they sent after it is handled.
  *
- * @param clients Map of connected clients.
- * @param correctPutCount Reference to global count of correct PUTs.
- * @param K Upper bound for domain values.
+ * @param shard The shard.
  */
-void sendScoringAndReset(std::map<int, ClientState> &clients,
-                         int &correctPutCount,
-                         int K)
+static void startGlobalRound(ShardState &shard) {
+    shard.roundPaused = false;
+    std::vector<int> waiters;
+    waiters.swap(shard.roundWaiters);
+    for (int fd : waiters) {
+        ClientState *client = shard.clients.find(fd);
+        // The descriptor may belong to a later client by now.
+        if (!client || !client->waitingForRound) continue;
+        client->waitingForRound = false;
+        if (joinGame(fd, *client, shard)) {
+            removeClient(shard, fd);
+            continue;
+        }
+        // A throttled client stays paused until its Resume timer.
+        if (!client->resumeTimer) shard.io.resumeClient(fd);
+        IoEvent buffered{IoEventKind::Readable, fd};
+        if (handleClientMessage(buffered, shard)) removeClient(shard, fd);
+    }
+}
+
+/**
+ * @brief Handles expired timers: sends delayed responses (BAD_PUT or STATE),
+ *        resumes throttled clients, disconnects clients that did not send HELLO in time
+ *        and starts the next global game.
+ *
+ * Pops only the expired timers from the queue. A timer whose id no longer matches
+ * the one stored in the client state was replaced or belongs to a closed client,
+ * and is skipped. Clients that received messages are flushed once, at the end.
+ *
+ * @param shard The shard whose timers are processed.
+ */
+void checkTimers(ShardState &shard)
 {
-    std::vector<std::pair<std::string, double>> results;
-    for (auto & [fd, state] : clients) {
-        double errorSum = 0.0;
-        for (int x = 0; x <= K; ++x) {
-            double fx = 0.0;
-            double xi = 1.0;
-            for (size_t i = 0; i < state.coeffs.size(); ++i) {
-                fx += state.coeffs[i] * xi;
-                xi *= x;
+    auto now = GameClock::now();
+    std::vector<int> toFlush;
+    TimerEvent timer;
+    while (shard.timers.popExpired(now, timer)) {
+        if (timer.kind == TimerKind::Round) {
+            startGlobalRound(shard);
+            continue;
+        }
+        ClientState *client = shard.clients.find(timer.fd);
+        if (!client) continue;
+        ClientState &state = *client;
+
+        switch (timer.kind) {
+            case TimerKind::Hello:
+                if (state.hasSentCoeff || state.helloTimer != timer.id) break;
+                Logger::log(LogEvent::HelloTimeout, timer.fd);
+                close(timer.fd);
+                removeClient(shard, timer.fd);
+                break;
+            case TimerKind::BadPut:
+                if (!state.pendingBadPut || state.badPutTimer != timer.id) break;
+                state.pendingBadPut = false;
+                if (!queueMessage(state, std::move(state.profile->badPutMsg))) {
+                    close(timer.fd);
+                    removeClient(shard, timer.fd);
+                    break;
+                }
+                toFlush.push_back(timer.fd);
+                Logger::log(LogEvent::BadPutSent, timer.fd, state.profile->playerId);
+                break;
+            case TimerKind::State:
+                if (!state.pendingState || state.stateTimer != timer.id) break;
+                state.pendingState = false;
+                if (!queueMessage(state, state.stateMsg.message())) {
+                    close(timer.fd);
+                    removeClient(shard, timer.fd);
+                    break;
+                }
+                toFlush.push_back(timer.fd);
+                shard.metrics.statesSent.add();
+                shard.metrics.stateLateness.record(GameClock::toReal(now - timer.at));
+                Logger::log(LogEvent::StateSent, timer.fd, state.profile->playerId);
+                break;
+            case TimerKind::Linger:
+                if (!state.closing || state.lingerTimer != timer.id) break;
+                Logger::log(LogEvent::LingerTimeout, timer.fd);
+                close(timer.fd);
+                removeClient(shard, timer.fd);
+                break;
+            case TimerKind::Resume: {
+                if (state.resumeTimer != timer.id) break;
+                state.resumeTimer = 0;
+                if (!state.waitingForRound) shard.io.resumeClient(timer.fd);
+                // Handles the lines held back meanwhile; new input arrives as events.
+                IoEvent resumed{IoEventKind::Readable, timer.fd};
+                if (handleClientMessage(resumed, shard)) removeClient(shard, timer.fd);
+                break;
             }
-            double diff = state.approx[x] - fx;
-            errorSum += diff * diff;
+            case TimerKind::Round:
+                break; // Handled above: it belongs to no client.
         }
-        errorSum += state.penalty;
-        results.emplace_back(state.playerId, errorSum);
     }
 
-    std::sort(results.begin(), results.end(),
-              [](auto &a, auto &b){ return a.first < b.first; });
+    for (int fd : toFlush) {
+        ClientState *client = shard.clients.find(fd);
+        if (client && flushClientOutput(fd, *client, shard)) {
+            removeClient(shard, fd);
+        }
+    }
+}
 
-    std::string scoringMsg = "SCORING";
-    for (auto &p : results) {
-        scoringMsg += " " + p.first + " " + std::to_string(p.second);
+/**
+ * @brief Computes the scores (squared error over 0..K plus penalties) of the given clients.
+ */
+static std::vector<double> scoreClients(ShardState &shard,
+                                        const std::vector<const ClientState *> &clients)
+{
+    ScopedTimer timer(shard.metrics.scoringTime);
+    std::vector<ScoringInput> players;
+    players.reserve(clients.size());
+    for (const ClientState *client : clients) {
+        // A client that never sent HELLO has no coefficients (f = 0).
+        players.push_back({client->profile->coeffs.get(), shard.clients.approx(*client),
+                           client->penalty});
     }
-    scoringMsg += CRLF;
+    return computeScores(players, shard.game.K(), shard.game.scoringPool());
+}
 
-    for (auto & [fd, state] : clients) {
-        writeAll(fd, scoringMsg);
-        close(fd);
+/**
+ * @brief Pairs the clients' player IDs with their scores.
+ */
+static GameCoordinator::Results scoreResults(ShardState &shard,
+                                             const std::vector<const ClientState *> &clients)
+{
+    std::vector<double> scores = scoreClients(shard, clients);
+    GameCoordinator::Results results;
+    results.reserve(clients.size());
+    for (size_t i = 0; i < clients.size(); ++i) {
+        results.emplace_back(clients[i]->profile->playerId, scores[i]);
     }
+    return results;
+}
 
-    std::cout << "Game ended. Sent SCORING and closed all connections.\n";
-    clients.clear();
-    correctPutCount = 0;
-}
\ No newline at end of file
+/**
+ * @brief Queues SCORING for the given clients and closes them once it is written.
+ *
+ * Clients that take it at once are closed; the others are kept as closing until their
+ * queue drains (or LINGER_TIMEOUT passes), so a slow reader delays nobody. Their
+ * pending responses and timers are dropped, and they leave their room.
+ *
+ * @param shard The shard the clients belong to.
+ * @param fds Sockets of the clients.
+ * @param scoring The SCORING message (shared by all of them, in both encodings).
+ */
+static void broadcastScoring(ShardState &shard, const std::vector<int> &fds,
+                             const GameCoordinator::Scoring &scoring)
+{
+    auto lingerUntil = GameClock::now() + LINGER_TIMEOUT;
+    shard.metrics.gamesScored.add();
+    for (int fd : fds) {
+        ClientState *client = shard.clients.find(fd);
+        if (!client) continue;
+        ClientState &state = *client;
+        state.room = nullptr;
+        if (!state.closing) {
+            state.closing = true;
+            state.pendingBadPut = false;
+            state.pendingState = false;
+            state.helloTimer = 0;
+            state.correctPutCountForThisClient = 0;
+            const OutputQueue::Message &msg = state.binary ? scoring.binary : scoring.text;
+            if (state.traceId) recordReply(state, msg);
+            if (!state.output.push(msg)) {
+                close(fd);
+                removeClient(shard, fd);
+                continue;
+            }
+        }
+        if (flushClientOutput(fd, state, shard)) {
+            removeClient(shard, fd);
+            continue;
+        }
+        if (!state.lingerTimer) {
+            state.lingerTimer = shard.timers.schedule(lingerUntil, fd, TimerKind::Linger);
+        }
+    }
+}
+
+/**
+ * @brief Takes over the clients handed off by other shards.
+ *
+ * Their HELLO was read by the sending shard; the lines that followed it were moved
+ * along with the input buffer and are handled here, right after COEFF is queued.
+ *
+ * @param shard The receiving shard.
+ */
+void adoptHandOffs(ShardState &shard) {
+    for (ClientState &moved : shard.game.takeHandOffs(shard.index)) {
+        int fd = moved.sockfd;
+        if (!shard.io.addClient(fd)) {
+            close(fd);
+            continue;
+        }
+
+        ClientState &state = shard.clients.insert(std::move(moved));
+        bool removed = joinGame(fd, state, shard);
+        // Handles the lines that came with the client; new input arrives as events.
+        IoEvent buffered{IoEventKind::Readable, fd};
+        if (!removed) removed = handleClientMessage(buffered, shard);
+        if (removed) removeClient(shard, fd);
+    }
+}
+
+/**
+ * @brief Removes a client from the shard. Its correct PUTs stop counting towards M
+ *        of its room (or of the global game).
+ *
+ * @param shard The shard.
+ * @param fd The client's socket.
+ */
+void removeClient(ShardState &shard, int fd) {
+    ClientState &state = *shard.clients.find(fd);
+    if (state.traceId) TraceRecorder::record(state.traceId, TraceKind::Close);
+    if (state.awaitingHello) shard.game.helloDone();
+    if (state.room) {
+        shard.rooms.leave(state.room, fd, state.correctPutCountForThisClient);
+    } else {
+        shard.game.removeCorrectPuts(state.correctPutCountForThisClient);
+    }
+    shard.clients.erase(fd);
+    shard.io.removeClient(fd);
+}
+
+/**
+ * @brief Scores the rooms that reached M and sends SCORING to their players.
+ *
+ * Each room is scored on its own players only, and the room is erased right away,
+ * so the end of one game never stalls the others.
+ *
+ * @param shard The shard owning the rooms.
+ */
+void finishRooms(ShardState &shard) {
+    for (Room *room : shard.rooms.takeEnded()) {
+        std::vector<int> fds(room->members.begin(), room->members.end());
+        std::vector<const ClientState *> players;
+        for (int fd : fds) {
+            ClientState *client = shard.clients.find(fd);
+            if (!client || client->closing) continue;
+            players.push_back(client);
+        }
+        GameCoordinator::Results results = scoreResults(shard, players);
+        std::sort(results.begin(), results.end(),
+                  [](auto &a, auto &b){ return a.first < b.first; });
+
+        Logger::log(LogEvent::RoomEnded, -1, room->name, {},
+                    static_cast<uint32_t>(results.size()));
+        SnapshotStore::forgetRoom(room->name);
+        shard.rooms.erase(room);
+        broadcastScoring(shard, fds, GameCoordinator::encodeScoring(results));
+    }
+}
+
+/**
+ * @brief Sends the SCORING message of the global game and resets it.
+ *
+ * Computes squared error + penalties for each player of the global game in this shard
+ * and hands the results to the coordinator, which waits for the other shards and returns
+ * the SCORING message for all players. Players in rooms are not affected.
+ *
+ * @param shard The shard.
+ */
+void sendScoringAndReset(ShardState &shard)
+{
+    std::vector<const ClientState *> players;
+    std::vector<int> fds;
+    shard.clients.forEach([&](ClientState &state) {
+        if (state.room) return;
+        fds.push_back(state.sockfd);
+        if (state.closing) return;
+        players.push_back(&state);
+    });
+
+    GameCoordinator::Scoring scoring = shard.game.finishRound(scoreResults(shard, players));
+    SnapshotStore::forgetRoom("");
+    broadcastScoring(shard, fds, scoring);
+
+    // A timer rather than a sleep, so the rooms of the shard are not held up.
+    shard.roundPaused = true;
+    shard.timers.schedule(GameClock::now() + ROUND_PAUSE, -1, TimerKind::Round);
+
+    Logger::log(LogEvent::GameEnded);
+}
+
+/**
+ * @brief Hands the records of the shard's players to the snapshot writer.
+ *
+ * Clients that have not sent HELLO yet, or whose game is over, are left out. Only the
+ * clients that changed since the last snapshot are encoded, reading just the points
+ * they touched; the others contribute their record from then as it is.
+ *
+ * @param shard The shard.
+ */
+void snapshotShard(ShardState &shard)
+{
+    ScopedTimer timer(shard.metrics.snapshotTime);
+    std::string records;
+    shard.clients.forEach([&](ClientState &state) {
+        if (!state.hasSentCoeff || state.closing) return;
+        if (state.snapshotRecord.empty()) {
+            const double *approx = shard.clients.approx(state);
+            std::vector<uint32_t> &points = state.touchedPoints;
+            // A point that went back to zero and was changed again is listed twice.
+            std::sort(points.begin(), points.end());
+            points.erase(std::unique(points.begin(), points.end()), points.end());
+            points.erase(std::remove_if(points.begin(), points.end(),
+                                        [&](uint32_t point) { return approx[point] == 0.0; }),
+                         points.end());
+            const ClientProfile &profile = *state.profile;
+            appendSnapshotPlayer(state.snapshotRecord, profile.playerId, profile.roomName,
+                                 state.penalty, state.correctPutCountForThisClient,
+                                 *profile.coeffs, approx, points);
+        }
+        records.append(state.snapshotRecord);
+    });
+    SnapshotStore::submit(shard.index, std::move(records));
+}
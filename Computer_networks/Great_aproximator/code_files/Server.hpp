@@ -1,11 +1,15 @@
 #ifndef SERVER_HPP
 #define SERVER_HPP
 
-#include <map>
 #include <string>
-#include <fstream>
 
 #include "ClientState.hpp"
+#include "ClientTable.hpp"
+#include "GameCoordinator.hpp"
+#include "IoEngine.hpp"
+#include "Metrics.hpp"
+#include "RoomTable.hpp"
+#include "TimerQueue.hpp"
 
 /**
  * @brief Returns the client's address and port in the format "[ip]:port".
@@ -19,54 +23,139 @@ std::string peerAddressPort(int fd);
  * @brief Creates a listening IPv6 socket (with IPv4 support), binds it, and starts listening.
  *
  * @param port Port number (0 to let the system choose any available port).
+ * @param reusePort Set SO_REUSEPORT, so that every shard can bind its own socket to the port.
  * @return int Listening socket descriptor, or -1 on failure.
  */
-int setupListeningSocket(int port);
+int setupListeningSocket(int port, bool reusePort = false);
 
 /**
- * @brief Accepts a new client connection and adds it to the clients map.
+ * @brief Sets up a listening Unix-domain socket for clients on the same host.
  *
- * @param listenFd Listening socket descriptor.
- * @param clients Map of active clients [fd → ClientState].
- * @param K Maximum index for points (range of the approximated function).
+ * @param path Filesystem path to bind to (a stale socket there is replaced, a live one
+ *             is not).
+ * @return Listening socket descriptor or -1 on error.
  */
-void acceptNewClient(int listenFd,
-                     std::map<int, ClientState> &clients,
-                     int K);
+int setupLocalSocket(const std::string &path);
 
 /**
- * @brief Processes a message from a client (HELLO or PUT).
+ * @brief Everything one shard (event loop) owns: its clients, timers and rooms.
+ *
+ * Only the shard's own thread touches it; the state shared between shards is
+ * reached through `game`.
+ */
+struct ShardState {
+    int index;                           ///< Index of the shard (0-based).
+    IoEngine &io;                        ///< The shard's socket I/O (epoll or io_uring).
+    ClientTable clients;                 ///< Clients of the shard, by socket.
+    TimerQueue timers;                   ///< HELLO timeouts, delayed responses, lingering,
+                                         ///< the pause between global games.
+    RoomTable rooms;                     ///< Rooms owned by the shard.
+    GameCoordinator &game;               ///< State shared by all shards.
+    ShardMetrics &metrics;               ///< Counters of the shard, readable by other threads.
+    bool roundPaused = false;            ///< The next global game has not started yet.
+    std::vector<int> roundWaiters;       ///< Clients waiting for it (waitingForRound).
+
+    ShardState(int index, IoEngine &io, GameCoordinator &game, ShardMetrics &metrics)
+        : index(index), io(io), clients(game.K()), rooms(game.M()), game(game),
+          metrics(metrics) {}
+};
+
+/**
+ * @brief Adds a client the I/O engine accepted to the shard.
+ *
+ * @param clientFd The new socket (non-blocking, already registered with shard.io).
+ * @param shard The shard (the HELLO timeout is scheduled in its timer queue).
+ */
+void acceptClient(int clientFd, ShardState &shard);
+
+/**
+ * @brief Takes over the clients other shards handed off to this one (their room is
+ *        owned by this shard), sends them COEFF and handles their buffered input.
+ *
+ * @param shard The receiving shard.
+ */
+void adoptHandOffs(ShardState &shard);
+
+/**
+ * @brief Handles a Readable or Writable event of a client.
+ *
+ * @param event The event (from shard.io.events()).
+ * @param shard The shard the client belongs to.
+ * @return true If the client has disconnected or moved to another shard and should be
+ *              removed with removeClient().
+ * @return false If the client is still active (or unknown).
+ */
+bool handleClientEvent(IoEvent &event, ShardState &shard);
+
+/**
+ * @brief Processes all messages available from a client (HELLO or PUT).
+ *
+ * Takes everything the I/O engine has for the client, as required by edge-triggered
+ * epoll (and by the completions of io_uring, which are reported once).
+ *
+ * @param event Readable event of the client.
+ * @param shard The shard the client belongs to.
+ * @return true If the client has disconnected or moved to another shard and should be
+ *              removed with removeClient().
+ * @return false If the client is still active.
+ */
+bool handleClientMessage(IoEvent &event, ShardState &shard);
+
+/**
+ * @brief Writes the client's queued messages without blocking (or queues the write).
  *
  * @param fd Client socket descriptor.
- * @param clients Map of clients [fd → ClientState].
- * @param correctPutCount Global counter of valid PUT messages.
- * @param K Maximum allowed point index.
- * @param coeffFile Input stream with COEFF lines.
- * @return true If the client has disconnected and should be removed.
+ * @param state State of the client.
+ * @param shard The shard the client belongs to (counts the bytes written).
+ * @return true If the socket was closed and the client should be removed.
  * @return false If the client is still active.
  */
-bool handleClientMessage(int fd,
-                         std::map<int, ClientState> &clients,
-                         int &correctPutCount,
-                         int K,
-                         std::ifstream &coeffFile);
+bool flushClientOutput(int fd, ClientState &state, ShardState &shard);
+
+/**
+ * @brief Removes a client from the shard, its room and the PUT count (does not close it).
+ *
+ * @param shard The shard.
+ * @param fd The client's socket (it must be in shard.clients).
+ */
+void removeClient(ShardState &shard, int fd);
 
 /**
- * @brief Checks timers for all clients and sends scheduled messages (BAD_PUT, STATE).
+ * @brief Processes expired timers: sends scheduled messages (BAD_PUT, STATE)
+ *        and disconnects clients that did not send HELLO in time.
+ *
+ * Only expired timers are visited, so the cost does not depend on the number of clients.
+ *
+ * @param shard The shard.
+ */
+void checkTimers(ShardState &shard);
+
+/**
+ * @brief Scores every room of the shard that reached M and sends SCORING to its players.
+ *
+ * Other rooms and the global game go on undisturbed.
+ *
+ * @param shard The shard.
+ */
+void finishRooms(ShardState &shard);
+
+/**
+ * @brief Sends the SCORING message of the global game to its players, closes their
+ *        sockets once it is written, and resets the game.
+ *
+ * Blocks until every shard has contributed its players' results. The next global game
+ * starts one second (game time) later: players who send HELLO meanwhile wait for it,
+ * while the shard's rooms go on undisturbed.
  *
- * @param clients Map of clients [fd → ClientState].
+ * @param shard The shard.
  */
-void checkTimers(std::map<int, ClientState> &clients);
+void sendScoringAndReset(ShardState &shard);
 
 /**
- * @brief Sends the SCORING message to all clients, closes sockets, and resets the server state.
+ * @brief Encodes the state of the shard's players for the next snapshot (server option -s).
  *
- * @param clients Map of clients [fd → ClientState].
- * @param correctPutCount Global PUT counter (will be reset).
- * @param K Maximum point index.
+ * @param shard The shard.
  */
-void sendScoringAndReset(std::map<int, ClientState> &clients,
-                         int &correctPutCount,
-                         int K);
+void snapshotShard(ShardState &shard);
 
 #endif // SERVER_HPP
@@ -0,0 +1,115 @@
+#include <cstring>
+
+#include "Snapshot.hpp"
+#include "binary_protocol.hpp"
+
+void appendSnapshotHeader(std::string &out, int K) {
+    out.append(SNAPSHOT_MAGIC);
+    appendLE(out, static_cast<uint32_t>(K), 4);
+}
+
+static void appendDouble(std::string &out, double value) {
+    char bytes[8];
+    writeBinaryDouble(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Appends everything of a record up to the values of f̂.
+ */
+static void appendPlayerHead(std::string &out, std::string_view playerId,
+                             std::string_view roomName, int penalty, int correctPuts,
+                             const std::vector<double> &coeffs)
+{
+    appendLE(out, playerId.size(), 2);
+    out.append(playerId);
+    appendLE(out, roomName.size(), 2);
+    out.append(roomName);
+    appendLE(out, static_cast<uint32_t>(penalty), 4);
+    appendLE(out, static_cast<uint32_t>(correctPuts), 4);
+    appendLE(out, coeffs.size() * 8, 4);
+    for (double a : coeffs) appendDouble(out, a);
+}
+
+void appendSnapshotPlayer(std::string &out, std::string_view playerId, std::string_view roomName,
+                          int penalty, int correctPuts, const std::vector<double> &coeffs,
+                          const double *approx, const std::vector<uint32_t> &points)
+{
+    appendPlayerHead(out, playerId, roomName, penalty, correctPuts, coeffs);
+    appendLE(out, points.size(), 4);
+    for (uint32_t point : points) {
+        appendLE(out, point, 4);
+        appendDouble(out, approx[point]);
+    }
+}
+
+void appendSnapshotPlayer(std::string &out, const SnapshotPlayer &player) {
+    appendPlayerHead(out, player.playerId, player.roomName, player.penalty, player.correctPuts,
+                     player.coeffs);
+    appendLE(out, player.approx.size(), 4);
+    for (const auto &[point, value] : player.approx) {
+        appendLE(out, point, 4);
+        appendDouble(out, value);
+    }
+}
+
+/**
+ * @brief Takes the next `size` bytes of the data, if there are that many.
+ */
+static bool take(std::string_view &data, size_t size, std::string_view &out) {
+    if (data.size() < size) return false;
+    out = data.substr(0, size);
+    data.remove_prefix(size);
+    return true;
+}
+
+/**
+ * @brief Reads a little-endian integer of `bytes` bytes, if the data holds it.
+ */
+static bool takeLE(std::string_view &data, int bytes, uint64_t &out) {
+    std::string_view field;
+    if (!take(data, bytes, field)) return false;
+    out = readLE(field.data(), bytes);
+    return true;
+}
+
+bool parseSnapshot(std::string_view data, int K, std::vector<SnapshotPlayer> &out) {
+    uint64_t fileK;
+    if (data.substr(0, SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC) return false;
+    data.remove_prefix(SNAPSHOT_MAGIC.size());
+    if (!takeLE(data, 4, fileK) || fileK != static_cast<uint64_t>(K)) return false;
+
+    out.clear();
+    while (!data.empty()) {
+        SnapshotPlayer player;
+        uint64_t length, value, count;
+        std::string_view field;
+        if (!takeLE(data, 2, length) || !take(data, length, field)) return false;
+        player.playerId = std::string(field);
+        if (!takeLE(data, 2, length) || !take(data, length, field)) return false;
+        player.roomName = std::string(field);
+        if (!takeLE(data, 4, value)) return false;
+        player.penalty = static_cast<int32_t>(value);
+        if (!takeLE(data, 4, value)) return false;
+        player.correctPuts = static_cast<int32_t>(value);
+        if (!takeLE(data, 4, length) || !take(data, length, field) ||
+            !parseBinaryDoubles(field, player.coeffs)) {
+            return false;
+        }
+
+        if (!takeLE(data, 4, count) || count > static_cast<uint64_t>(K) + 1) return false;
+        player.approx.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t point;
+            if (!takeLE(data, 4, point) || point > static_cast<uint64_t>(K) ||
+                !takeLE(data, 8, value)) {
+                return false;
+            }
+            double v;
+            std::memcpy(&v, &value, sizeof(v));
+            player.approx.emplace_back(static_cast<uint32_t>(point), v);
+        }
+        out.push_back(std::move(player));
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Snapshot of the games in flight, written by `approx-server -s` and read back when
+ * the server restarts, so players can reattach by player ID.
+ *
+ * The file starts with SNAPSHOT_MAGIC and K (uint32), followed by one record per player:
+ *
+ *   uint16 length, player ID
+ *   uint16 length, room ID     empty for the global game
+ *   uint32 penalty
+ *   uint32 correct PUTs
+ *   uint32 length, a0 ... aN   the coefficients of the player's COEFF (doubles)
+ *   uint32 count, then count × (uint32 point, double value): the non-zero values of f̂
+ *
+ * Integers and doubles are little-endian, like binary frames. Only the points a player
+ * has changed are stored, so a record is a few dozen bytes however large K is.
+ */
+
+/// First bytes of a snapshot file (includes the format version).
+constexpr std::string_view SNAPSHOT_MAGIC = "APXSNP1\n";
+
+/**
+ * @brief The saved state of one player.
+ */
+struct SnapshotPlayer {
+    std::string playerId;
+    std::string roomName;                            ///< Empty for the global game.
+    int penalty = 0;
+    int correctPuts = 0;
+    std::vector<double> coeffs;                      ///< a0..aN of the player's COEFF.
+    std::vector<std::pair<uint32_t, double>> approx; ///< Non-zero values of f̂ (point, value).
+};
+
+/**
+ * @brief Appends the magic and K that start a snapshot.
+ */
+void appendSnapshotHeader(std::string &out, int K);
+
+/**
+ * @brief Appends the record of a connected player.
+ *
+ * @param approx The player's f̂(0..K).
+ * @param points The points whose values are written: every non-zero point of f̂, each
+ *               once, in increasing order.
+ */
+void appendSnapshotPlayer(std::string &out, std::string_view playerId, std::string_view roomName,
+                          int penalty, int correctPuts, const std::vector<double> &coeffs,
+                          const double *approx, const std::vector<uint32_t> &points);
+
+/**
+ * @brief Appends the record of a player read from an earlier snapshot.
+ */
+void appendSnapshotPlayer(std::string &out, const SnapshotPlayer &player);
+
+/**
+ * @brief Decodes a snapshot.
+ *
+ * @param data The whole file.
+ * @param K Maximum point index of the server; a snapshot taken with another K is refused.
+ * @param out Output: the players.
+ * @return false if the data is not a snapshot for this K, or is truncated or invalid.
+ */
+bool parseSnapshot(std::string_view data, int K, std::vector<SnapshotPlayer> &out);
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,189 @@
+#include "SnapshotStore.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "utils.hpp"
+
+int SnapshotStore::shardCount = 0;
+std::chrono::milliseconds SnapshotStore::period{1000};
+
+static std::string snapshotPath;
+static int snapshotK = 0;
+
+/// Guards everything below.
+static std::mutex mutex;
+
+/// Latest records of every shard.
+static std::vector<std::shared_ptr<const std::string>> parts;
+
+/// Something changed since the last snapshot was written.
+static bool dirty = false;
+
+/// Restored players not claimed yet, by player ID.
+static std::unordered_multimap<std::string, SnapshotPlayer> restored;
+
+/// Number of unclaimed players per room ID, so the end of other games costs a lookup.
+static std::unordered_map<std::string, size_t> restoredPerRoom;
+
+/// Records of the unclaimed players, rebuilt by the writer when `restoredChanged`.
+static std::string restoredRecords;
+static bool restoredChanged = false;
+
+/// Size of `restored`, read without the lock so that HELLO does not take it in vain.
+static std::atomic<size_t> unclaimed{0};
+
+static size_t restoredTotal = 0;
+static uint64_t restoredRooms = 0;
+
+bool SnapshotStore::start(const std::string &path, int K, int shards,
+                          std::chrono::milliseconds interval)
+{
+    snapshotPath = path;
+    snapshotK = K;
+    period = interval;
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno != ENOENT) {
+        std::cerr << "ERROR: open(" << path << "): " << strerror(errno) << "\n";
+        return false;
+    }
+    if (fd >= 0) {
+        struct stat st;
+        std::string data;
+        if (fstat(fd, &st) == 0) data.resize(st.st_size);
+        size_t got = 0;
+        while (got < data.size()) {
+            ssize_t n = read(fd, &data[got], data.size() - got);
+            if (n <= 0) break;
+            got += n;
+        }
+        close(fd);
+
+        std::vector<SnapshotPlayer> players;
+        if (got != data.size() || !parseSnapshot(data, K, players)) {
+            std::cerr << "ERROR: " << path << " is not a snapshot of a game with K=" << K
+                      << "; move it away to start without it\n";
+            return false;
+        }
+        restored.reserve(players.size());
+        for (SnapshotPlayer &player : players) {
+            const std::string &room = player.roomName;
+            if (room.size() > 1 && room[0] == '#') {
+                uint64_t number = std::strtoull(room.c_str() + 1, nullptr, 10);
+                restoredRooms = std::max(restoredRooms, number + 1);
+            }
+            ++restoredPerRoom[room];
+            std::string id = player.playerId;
+            restored.emplace(std::move(id), std::move(player));
+        }
+        restoredTotal = restored.size();
+        unclaimed.store(restored.size());
+        restoredChanged = true;
+    }
+
+    parts.resize(shards);
+    shardCount = shards;
+    std::thread(writeLoop).detach();
+    return true;
+}
+
+size_t SnapshotStore::restoredCount() {
+    return restoredTotal;
+}
+
+uint64_t SnapshotStore::matchmadeRooms() {
+    return restoredRooms;
+}
+
+bool SnapshotStore::claim(const std::string &playerId, const std::string &roomName,
+                          std::unique_ptr<SnapshotPlayer> &out)
+{
+    if (unclaimed.load(std::memory_order_relaxed) == 0) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [begin, end] = restored.equal_range(playerId);
+    for (auto it = begin; it != end; ++it) {
+        const std::string &room = it->second.roomName;
+        if (roomName.empty() ? !(room.empty() || room[0] == '#') : room != roomName) continue;
+
+        if (--restoredPerRoom[room] == 0) restoredPerRoom.erase(room);
+        out = std::make_unique<SnapshotPlayer>(std::move(it->second));
+        restored.erase(it);
+        unclaimed.store(restored.size(), std::memory_order_relaxed);
+        restoredChanged = true;
+        dirty = true;
+        return true;
+    }
+    return false;
+}
+
+void SnapshotStore::forgetRoom(const std::string &roomName) {
+    if (unclaimed.load(std::memory_order_relaxed) == 0) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (restoredPerRoom.erase(roomName) == 0) return;
+    for (auto it = restored.begin(); it != restored.end();) {
+        it = it->second.roomName == roomName ? restored.erase(it) : std::next(it);
+    }
+    unclaimed.store(restored.size(), std::memory_order_relaxed);
+    restoredChanged = true;
+    dirty = true;
+}
+
+void SnapshotStore::submit(int shard, std::string &&records) {
+    auto part = std::make_shared<const std::string>(std::move(records));
+    std::lock_guard<std::mutex> lock(mutex);
+    parts[shard] = std::move(part);
+    dirty = true;
+}
+
+/**
+ * @brief Writer thread: once per interval, writes the latest records of all shards
+ *        to a temporary file and renames it over the snapshot.
+ */
+void SnapshotStore::writeLoop() {
+    const std::string tmpPath = snapshotPath + ".tmp";
+    std::vector<std::shared_ptr<const std::string>> latest;
+    std::string data;
+    while (true) {
+        std::this_thread::sleep_for(period);
+        data.clear();
+        appendSnapshotHeader(data, snapshotK);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!dirty) continue;
+            dirty = false;
+            latest = parts;
+            if (restoredChanged) {
+                restoredRecords.clear();
+                for (const auto &entry : restored) appendSnapshotPlayer(restoredRecords, entry.second);
+                restoredChanged = false;
+            }
+            data.append(restoredRecords);
+        }
+        for (const auto &part : latest) {
+            if (part) data.append(*part);
+        }
+
+        int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "ERROR: open(" << tmpPath << "): " << strerror(errno) << "\n";
+            continue;
+        }
+        bool written = writeAll(fd, data);
+        close(fd);
+        if (!written || rename(tmpPath.c_str(), snapshotPath.c_str()) < 0) {
+            std::cerr << "ERROR: writing the snapshot failed: " << strerror(errno) << "\n";
+        }
+    }
+}
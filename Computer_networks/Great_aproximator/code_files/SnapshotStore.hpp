@@ -0,0 +1,89 @@
+#ifndef SNAPSHOT_STORE_HPP
+#define SNAPSHOT_STORE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "Snapshot.hpp"
+
+/**
+ * @brief Keeps a snapshot of the games in flight on disk (see Snapshot.hpp) and lets
+ *        players of a restarted server reattach by player ID.
+ *
+ * Every interval each shard encodes the records of its players between two loop
+ * iterations, so they are consistent within the shard (a room lives in one shard), and
+ * hands them over with submit(). Players unchanged since the previous interval reuse
+ * their record from then, so the event loop pays only for the recent PUTs. A background thread writes the latest records of all
+ * shards to a temporary file and renames it over the snapshot, so the file is always
+ * complete and the event loops never touch the disk.
+ *
+ * start() reads the previous snapshot, if any. A restored player is claimed by the
+ * first HELLO with its player ID (and its room, if the HELLO names one) and gets back
+ * its COEFF, f̂, penalty and correct PUTs. Players not claimed yet stay in later
+ * snapshots until their game ends without them.
+ */
+class SnapshotStore {
+public:
+    /**
+     * @brief Restores the snapshot at path, if there is one, and starts writing it.
+     *
+     * @param path Snapshot file.
+     * @param K Maximum point index of the server.
+     * @param shards Number of shards.
+     * @param interval Time between two snapshots (wall-clock).
+     * @return false if the snapshot exists but cannot be read or was taken with another
+     *         K (the error is reported); it is left untouched.
+     */
+    static bool start(const std::string &path, int K, int shards,
+                      std::chrono::milliseconds interval);
+
+    /// Whether snapshots are being written.
+    static bool enabled() { return shardCount > 0; }
+
+    /// Time between two snapshots of a shard.
+    static std::chrono::milliseconds interval() { return period; }
+
+    /// Number of players restored by start().
+    static size_t restoredCount();
+
+    /**
+     * @brief Returns the number of matchmade rooms ("#<n>") the restored players were in.
+     */
+    static uint64_t matchmadeRooms();
+
+    /**
+     * @brief Hands out the restored player with the given ID, once.
+     *
+     * @param playerId Player ID from HELLO.
+     * @param roomName Room ID from HELLO; empty matches the global game and matchmade rooms.
+     * @param out Output: the player, if one matched.
+     * @return true if the player was restored.
+     */
+    static bool claim(const std::string &playerId, const std::string &roomName,
+                      std::unique_ptr<SnapshotPlayer> &out);
+
+    /**
+     * @brief Drops the restored players of a game that ended without them.
+     *
+     * @param roomName Room ID; empty for the global game.
+     */
+    static void forgetRoom(const std::string &roomName);
+
+    /**
+     * @brief Replaces a shard's records in the next snapshot.
+     *
+     * @param shard Index of the shard.
+     * @param records Records of the shard's players (appendSnapshotPlayer()).
+     */
+    static void submit(int shard, std::string &&records);
+
+private:
+    static void writeLoop();
+
+    static int shardCount;
+    static std::chrono::milliseconds period;
+};
+
+#endif // SNAPSHOT_STORE_HPP
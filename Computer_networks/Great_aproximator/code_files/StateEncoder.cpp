@@ -0,0 +1,92 @@
+#include "StateEncoder.hpp"
+#include "binary_protocol.hpp"
+
+#include <charconv>
+#include <cstring>
+
+/// Length of "STATE" at the start of the message.
+static const size_t HEADER_LEN = 5;
+
+/// Initial slot width: "-5.000000", the longest value a single PUT can set.
+static const size_t INITIAL_WIDTH = 9;
+
+/// Enough for any finite double in fixed notation with 6 decimals (up to 309 integer digits).
+static const size_t MAX_VALUE_LEN = 384;
+
+/**
+ * @brief Formats a value like std::to_string(double) ("%f") would.
+ *
+ * @return Number of characters written.
+ */
+static size_t formatValue(double value, char *out) {
+    auto res = std::to_chars(out, out + MAX_VALUE_LEN, value, std::chars_format::fixed, 6);
+    return static_cast<size_t>(res.ptr - out);
+}
+
+StateEncoder::StateEncoder(int K, bool binary)
+    : K(K), width(INITIAL_WIDTH), binary(binary)
+{
+    // Every client starts from the same all-zero state, so its encoding is built once and
+    // shared; the first update() copies it.
+    static thread_local std::shared_ptr<std::string> zeroState[2];
+    static thread_local int zeroStateK[2] = {-1, -1};
+    if (zeroStateK[binary] != K) {
+        std::vector<double> zeros(K + 1, 0.0);
+        if (binary) {
+            buffer = std::make_shared<std::string>(makeDoublesFrame(FrameType::STATE, zeros));
+        } else {
+            rebuild(zeros.data(), width);
+        }
+        zeroState[binary] = buffer;
+        zeroStateK[binary] = K;
+    }
+    buffer = zeroState[binary];
+}
+
+void StateEncoder::writeSlot(int point, const char *text, size_t len) {
+    char *slot = buffer->data() + HEADER_LEN + point * (width + 1) + 1;
+    std::memset(slot, ' ', width - len);
+    std::memcpy(slot + width - len, text, len);
+}
+
+void StateEncoder::rebuild(const double *approx, size_t newWidth) {
+    const size_t count = static_cast<size_t>(K) + 1;
+    width = newWidth;
+    auto fresh = std::make_shared<std::string>(HEADER_LEN + count * (width + 1) + 2, ' ');
+    std::memcpy(fresh->data(), "STATE", HEADER_LEN);
+    (*fresh)[fresh->size() - 2] = '\r';
+    (*fresh)[fresh->size() - 1] = '\n';
+    buffer = std::move(fresh);
+
+    char text[MAX_VALUE_LEN];
+    for (size_t x = 0; x < count; ++x) {
+        writeSlot(static_cast<int>(x), text, formatValue(approx[x], text));
+    }
+}
+
+void StateEncoder::update(const double *approx, int point) {
+    char text[MAX_VALUE_LEN];
+    size_t len = 0;
+    if (!binary) {
+        len = formatValue(approx[point], text);
+        if (len > width) {
+            rebuild(approx, len);
+            return;
+        }
+    }
+
+    // The previous STATE may still be queued for sending; never modify it in place.
+    if (buffer.use_count() > 1) {
+        buffer = std::make_shared<std::string>(*buffer);
+    }
+    if (binary) {
+        writeBinaryDouble(buffer->data() + FRAME_HEADER_SIZE + point * sizeof(double),
+                          approx[point]);
+    } else {
+        writeSlot(point, text, len);
+    }
+}
+
+std::shared_ptr<const std::string> StateEncoder::message() const {
+    return buffer;
+}
@@ -0,0 +1,64 @@
+#ifndef STATE_ENCODER_HPP
+#define STATE_ENCODER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cached wire encoding of a client's STATE message.
+ *
+ * The message "STATE r0 r1 ... rK\r\n" is kept encoded, with every value in a slot
+ * of the same width, right-aligned and padded with spaces, so values are separated by
+ * one or more spaces (receivers split on runs of spaces). A PUT changes one value, so only its slot is rewritten. The whole message
+ * is re-encoded only when a value no longer fits the slot width; the width only grows,
+ * so this happens a bounded number of times and a PUT costs O(1) amortised.
+ *
+ * Values are formatted with std::to_chars as fixed-point with 6 decimals, the same text
+ * std::to_string produces. Slots start 9 characters wide, enough for any value a single
+ * PUT can set (-5.000000 to 5.000000), so the first negative PUT does not re-encode the
+ * message; only sums outside (-10, 100) widen it.
+ *
+ * For a binary client the cached message is the STATE frame instead; every value has a
+ * fixed 8-byte slot there, so a PUT always rewrites exactly one slot.
+ *
+ * message() shares the buffer with the output queue; update() copies it only if a
+ * previous STATE is still waiting to be written.
+ */
+class StateEncoder {
+public:
+    /**
+     * @brief Encodes the state of K + 1 zero values.
+     *
+     * @param K Maximum point index.
+     * @param binary Whether to encode a binary STATE frame instead of a text line.
+     */
+    explicit StateEncoder(int K, bool binary = false);
+
+    /**
+     * @brief Re-encodes the value at one point after it changed.
+     *
+     * @param approx All K + 1 current values (needed if the slot width has to grow).
+     * @param point Index of the changed value.
+     */
+    void update(const double *approx, int point);
+
+    /**
+     * @brief Returns the encoded message, including "\r\n" (or the complete frame).
+     */
+    std::shared_ptr<const std::string> message() const;
+
+private:
+    /// Writes the value right-aligned into its slot (the width must be sufficient).
+    void writeSlot(int point, const char *text, size_t len);
+
+    /// Rebuilds the whole message with the given slot width.
+    void rebuild(const double *approx, size_t newWidth);
+
+    std::shared_ptr<std::string> buffer;
+    int K;        ///< Maximum point index.
+    size_t width; ///< Characters per value, without the separating space.
+    bool binary;  ///< The message is a binary STATE frame.
+};
+
+#endif // STATE_ENCODER_HPP
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -6,19 +7,13 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string_view>
 
 #include "utils.hpp"
+#include "binary_protocol.hpp"
 #include "protocol.hpp"
 #include "Strategy.hpp"
-
-// -----------------------------------------------------------------------------
-// Internal state used by the automatic strategy
-
-static std::vector<double> g_coeffs;     ///< Polynomial coefficients a₀...aₙ
-static int g_nextX = 0;                  ///< Next x value to process
-static int g_N = 0;                      ///< Degree of the polynomial (N)
-static int g_K = 0;                      ///< Max x seen from STATE (updated during run)
-static double g_remaining = 0.0;         ///< Remaining value to send for current x
+#include "Polynomial.hpp"
 
 static const double MAX_PUT = 5.0;
 static const double MIN_PUT = -5.0;
@@ -33,173 +28,257 @@ static double clampPut(double val) {
 }
 
 /**
- * @brief Initializes the strategy with given polynomial coefficients.
+ * @brief Returns how much a PUT towards the given residual lowers the squared error.
  */
-void strategyInitialize(const std::vector<double> &coeffs) {
-    g_coeffs = coeffs;
-    g_N = static_cast<int>(coeffs.size()) - 1;
-    g_nextX = 0;
-    g_remaining = coeffs[0]; // Initial value, will be overwritten in strategyNextPut()
+static double putGain(double residual) {
+    double after = residual - clampPut(residual);
+    return residual * residual - after * after;
 }
 
-/**
- * @brief Computes the next PUT (point, value) based on internal strategy state.
- */
-std::pair<int, double> strategyNextPut() {
-    // If all points have been handled, we stop
-    if (g_nextX > g_K) {
+AutoStrategy::AutoStrategy(const std::vector<double> &coeffs, long budget)
+    : coeffs(coeffs),
+      budget(budget)
+{
+    plan();
+}
+
+void AutoStrategy::setK(int maxPoint) {
+    if (maxPoint < 0) return;
+    knowsK = true;
+    if (maxPoint == K) return;
+    K = maxPoint;
+    plan();
+}
+
+void AutoStrategy::plan() {
+    // Points already planned keep what was sent for them; new points start from f(x).
+    size_t known = std::min(residual.size(), static_cast<size_t>(K) + 1);
+    std::vector<double> f(static_cast<size_t>(K) + 1);
+    evaluatePolynomial(coeffs, K, f.data());
+    for (size_t x = 0; x < known; ++x) f[x] = residual[x];
+    residual.swap(f);
+
+    heap.clear();
+    for (int x = 0; x <= K; ++x) {
+        if (residual[x] != 0.0) heap.push_back({putGain(residual[x]), x});
+    }
+    std::make_heap(heap.begin(), heap.end(), LessGain());
+}
+
+std::pair<int, double> AutoStrategy::nextPut() {
+    if (budget == 0) {
         return { -1, 0.0 };
     }
+    if (heap.empty()) {
+        // f(0) = 0 and no STATE yet: an empty PUT brings the STATE that tells K.
+        if (knowsK) return { -1, 0.0 };
+        knowsK = true;
+        if (budget > 0) --budget;
+        return { 0, 0.0 };
+    }
+    if (budget > 0) --budget;
 
-    if (g_remaining != 0.0) {
-        double v = clampPut(g_remaining);
-        g_remaining -= v;
-        return { g_nextX, v };
+    std::pop_heap(heap.begin(), heap.end(), LessGain());
+    Candidate &best = heap.back();
+    int x = best.x;
+    double v = clampPut(residual[x]);
+    residual[x] -= v;
+    if (residual[x] != 0.0) {
+        best.gain = putGain(residual[x]);
+        std::push_heap(heap.begin(), heap.end(), LessGain());
+    } else {
+        heap.pop_back();
     }
+    return { x, v };
+}
+
+/**
+ * @brief Blocks until the next complete message from the server is available.
+ *
+ * Messages already buffered are returned without touching the socket, so a read that
+ * brought several messages at once does not leave the rest waiting for more data.
+ *
+ * @param sockfd Non-blocking socket connected to the server.
+ * @param input Input buffer of the socket.
+ * @param binary Whether the connection uses binary frames instead of lines.
+ * @param msg Output: the line without "\r\n" or the frame without its length, valid until
+ *            the next call.
+ * @return false if the server disconnected before a full message arrived.
+ */
+static bool waitServerMessage(int sockfd, LineBuffer &input, bool binary, std::string_view &msg) {
+    bool closed = false;
+    while (true) {
+        if (binary) {
+            LineBuffer::FrameStatus status = input.nextFrame(msg);
+            if (status == LineBuffer::FrameStatus::Complete) return true;
+            if (status == LineBuffer::FrameStatus::Invalid) return false;
+        } else if (input.nextLine(msg)) {
+            return true;
+        }
+        if (closed || input.full()) return false;
 
-    // We calculate f(x) for the next x
-    ++g_nextX;
-    double fx = 0.0;
-    double xi = 1.0;
-    for (int i = 0; i <= g_N; ++i) {
-        fx += g_coeffs[i] * xi;
-        xi *= g_nextX;
+        fd_set readFds;
+        FD_ZERO(&readFds);
+        FD_SET(sockfd, &readFds);
+        int ready = select(sockfd + 1, &readFds, nullptr, nullptr, nullptr);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: select(): " << strerror(errno) << "\n";
+            return false;
+        }
+        if (FD_ISSET(sockfd, &readFds))
+            closed = input.fill(sockfd) == LineBuffer::FillStatus::Closed;
     }
+}
+
+/// Kind of a server message, as far as the game loop is concerned.
+enum class ServerMessage { State, Scoring, Other };
+
+/**
+ * @brief Prints a text message from the server and classifies it.
+ */
+static ServerMessage handleTextMessage(std::string_view msg,
+                                       std::vector<std::string_view> &tokens,
+                                       AutoStrategy &strategy,
+                                       const std::string &playerId,
+                                       const std::string &resolvedIP,
+                                       int port)
+{
+    splitBySpace(msg, tokens);
+    if (tokens.empty()) return ServerMessage::Other;
 
-    g_remaining = fx;
-    if (g_remaining == 0.0 || g_nextX > g_K) {
-        return strategyNextPut();
+    if (tokens[0] == "STATE") {
+        strategy.setK(static_cast<int>(tokens.size()) - 2);
+        std::cout << "Received state";
+        for (size_t i = 1; i < tokens.size(); ++i)
+            std::cout << " " << tokens[i];
+        std::cout << ".\n";
+        return ServerMessage::State;
+    } else if (tokens[0] == "BAD_PUT") {
+        if (tokens.size() >= 3)
+            std::cout << "Received bad put " << tokens[1] << " " << tokens[2] << ".\n";
+        else
+            std::cout << "Received bad put.\n";
+    } else if (tokens[0] == "PENALTY") {
+        if (tokens.size() >= 3)
+            std::cout << "Received penalty " << tokens[1] << " " << tokens[2] << ".\n";
+        else
+            std::cout << "Received penalty.\n";
+    } else if (tokens[0] == "SCORING") {
+        std::cout << "Game end, scoring:";
+        for (size_t i = 1; i < tokens.size(); ++i)
+            std::cout << " " << tokens[i];
+        std::cout << ".\n";
+        return ServerMessage::Scoring;
+    } else {
+        std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
+                  << ", " << playerId << ": " << msg << "\n";
     }
+    return ServerMessage::Other;
+}
+
+/**
+ * @brief Prints a binary frame from the server and classifies it.
+ */
+static ServerMessage handleBinaryFrame(std::string_view frame,
+                                       AutoStrategy &strategy,
+                                       const std::string &playerId,
+                                       const std::string &resolvedIP,
+                                       int port)
+{
+    static std::vector<double> state; // Reused, so parsing STATE does not allocate.
+    FrameType type;
+    std::string_view payload;
+    uint32_t point;
+    double value;
+    splitFrame(frame, type, payload);
 
-    double v = clampPut(g_remaining);
-    g_remaining -= v;
-    return { g_nextX, v };
+    if (type == FrameType::STATE && parseBinaryDoubles(payload, state)) {
+        strategy.setK(static_cast<int>(state.size()) - 1);
+        std::cout << "Received state";
+        for (double v : state)
+            std::cout << " " << v;
+        std::cout << ".\n";
+        return ServerMessage::State;
+    } else if (type == FrameType::BAD_PUT) {
+        if (parseBinaryPUT(payload, point, value))
+            std::cout << "Received bad put " << point << " " << value << ".\n";
+        else
+            std::cout << "Received bad put.\n";
+    } else if (type == FrameType::PENALTY) {
+        if (parseBinaryPUT(payload, point, value))
+            std::cout << "Received penalty " << point << " " << value << ".\n";
+        else
+            std::cout << "Received penalty.\n";
+    } else if (type == FrameType::SCORING) {
+        std::vector<std::pair<std::string, double>> scores;
+        parseBinarySCORING(payload, scores);
+        std::cout << "Game end, scoring:";
+        for (auto &[id, score] : scores)
+            std::cout << " " << id << " " << score;
+        std::cout << ".\n";
+        return ServerMessage::Scoring;
+    } else {
+        std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
+                  << ", " << playerId << ": binary frame of type "
+                  << static_cast<int>(frame[0]) << " with " << payload.size()
+                  << " payload bytes\n";
+    }
+    return ServerMessage::Other;
 }
 
 /**
  * @brief Executes automatic strategy gameplay, handling PUT/STATE/SCORING.
  */
 void runAutoMode(int sockfd,
+                 LineBuffer &input,
                  const std::string &playerId,
                  const std::string &resolvedIP,
                  int port,
-                 const std::vector<double> &coeffs)
+                 const std::vector<double> &coeffs,
+                 bool binary,
+                 long budget)
 {
-    strategyInitialize(coeffs);
+    AutoStrategy strategy(coeffs, budget);
 
-    while (true) {
-        auto [point, value] = strategyNextPut();
-        if (point < 0) break;
+    std::string_view msg;
+    std::vector<std::string_view> tokens; // Reused, so tokenizing does not allocate.
 
-        std::string putMsg = makePUT(point, value);
-        if (!writeAll(sockfd, putMsg)) {
-            std::cerr << "ERROR: failed to send PUT\n";
+    // Waits for the next server message and prints it; exits if the server disconnects.
+    auto receive = [&]() {
+        if (!waitServerMessage(sockfd, input, binary, msg)) {
+            std::cerr << "ERROR: unexpected server disconnect\n";
             close(sockfd);
             exit(1);
         }
-        std::cout << "Putting " << value << " in " << point << ".\n";
-
-        while (true) {
-            fd_set readFds;
-            FD_ZERO(&readFds);
-            FD_SET(sockfd, &readFds);
-            int ready = select(sockfd + 1, &readFds, nullptr, nullptr, nullptr);
-            if (ready < 0) {
-                if (errno == EINTR) continue;
-                std::cerr << "ERROR: select(): " << strerror(errno) << "\n";
-                close(sockfd);
-                exit(1);
-            }
-            if (FD_ISSET(sockfd, &readFds)) {
-                bool success;
-                std::string msg = readLine(sockfd, success);
-                if (!success) {
-                    std::cerr << "ERROR: unexpected server disconnect\n";
-                    close(sockfd);
-                    exit(1);
-                }
+        return binary ? handleBinaryFrame(msg, strategy, playerId, resolvedIP, port)
+                      : handleTextMessage(msg, tokens, strategy, playerId, resolvedIP, port);
+    };
 
-                auto tokens = splitBySpace(msg);
-                if (tokens.empty()) continue;
-
-                if (tokens[0] == "STATE") {
-                    g_K = static_cast<int>(tokens.size()) - 2;
-                    std::cout << "Received state";
-                    for (size_t i = 1; i < tokens.size(); ++i)
-                        std::cout << " " << tokens[i];
-                    std::cout << ".\n";
-                    break;
-                } else if (tokens[0] == "BAD_PUT") {
-                    if (tokens.size() >= 3)
-                        std::cout << "Received bad put " << tokens[1] << " " << tokens[2] << ".\n";
-                    else
-                        std::cout << "Received bad put.\n";
-                } else if (tokens[0] == "PENALTY") {
-                    if (tokens.size() >= 3)
-                        std::cout << "Received penalty " << tokens[1] << " " << tokens[2] << ".\n";
-                    else
-                        std::cout << "Received penalty.\n";
-                } else if (tokens[0] == "SCORING") {
-                    std::cout << "Game end, scoring:";
-                    for (size_t i = 1; i < tokens.size(); ++i)
-                        std::cout << " " << tokens[i];
-                    std::cout << ".\n";
+    // The server penalises a PUT sent while the STATE of the previous one is pending, so
+    // one PUT is in flight at a time: the next one goes out as soon as its STATE arrives.
+    bool statePending = false;
+    bool finished = false;
+    while (true) {
+        if (!statePending && !finished) {
+            auto [point, value] = strategy.nextPut();
+            if (point < 0) {
+                finished = true; // Wait for SCORING after all PUTs
+            } else {
+                std::string putMsg = binary ? makeBinaryPUT(point, value) : makePUT(point, value);
+                if (!writeAll(sockfd, putMsg)) {
+                    std::cerr << "ERROR: failed to send PUT\n";
                     close(sockfd);
-                    return;
-                } else {
-                    std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
-                              << ", " << playerId << ": " << msg << "\n";
+                    exit(1);
                 }
+                std::cout << "Putting " << value << " in " << point << ".\n";
+                statePending = true;
             }
         }
-    }
 
-    // Wait for SCORING after all PUTs
-    while (true) {
-        fd_set readFds;
-        FD_ZERO(&readFds);
-        FD_SET(sockfd, &readFds);
-        int ready = select(sockfd + 1, &readFds, nullptr, nullptr, nullptr);
-        if (ready < 0) {
-            if (errno == EINTR) continue;
-            std::cerr << "ERROR: select(): " << strerror(errno) << "\n";
-            close(sockfd);
-            exit(1);
-        }
-
-        if (FD_ISSET(sockfd, &readFds)) {
-            bool success;
-            std::string msg = readLine(sockfd, success);
-            if (!success) {
-                std::cerr << "ERROR: unexpected server disconnect\n";
-                close(sockfd);
-                exit(1);
-            }
-
-            auto tokens = splitBySpace(msg);
-            if (tokens.empty()) continue;
-
-            if (tokens[0] == "SCORING") {
-                std::cout << "Game end, scoring:";
-                for (size_t i = 1; i < tokens.size(); ++i)
-                    std::cout << " " << tokens[i];
-                std::cout << ".\n";
-                close(sockfd);
-                return;
-            } else if (tokens[0] == "STATE") {
-                std::cout << "Received state";
-                for (size_t i = 1; i < tokens.size(); ++i)
-                    std::cout << " " << tokens[i];
-                std::cout << ".\n";
-            } else if (tokens[0] == "PENALTY") {
-                if (tokens.size() >= 3)
-                    std::cout << "Received penalty " << tokens[1] << " " << tokens[2] << ".\n";
-                else
-                    std::cout << "Received penalty.\n";
-            } else {
-                std::cerr << "ERROR: bad message from [" << resolvedIP << "]:" << port
-                          << ", " << playerId << ": " << msg << "\n";
-            }
-        }
+        ServerMessage kind = receive();
+        if (kind == ServerMessage::Scoring) break;
+        if (kind == ServerMessage::State) statePending = false;
     }
-}
\ No newline at end of file
+    close(sockfd);
+}
@@ -1,49 +1,97 @@
 #ifndef STRATEGY_HPP
 #define STRATEGY_HPP
 
-#include <vector>
-#include <utility>
-
 #include <vector>
 #include <string>
 #include <utility>
 
-/**
- * @brief Initializes the automatic strategy with the polynomial coefficients.
- *
- * Stores coefficients a₀...aₙ, resets internal state, and prepares to generate PUT actions.
- *
- * @param coeffs Vector of polynomial coefficients.
- */
-void strategyInitialize(const std::vector<double> &coeffs);
+#include "LineBuffer.hpp"
 
 /**
- * @brief Returns the next (point, value) pair to send in a PUT command.
+ * @brief The automatic strategy of one player.
  *
- * The strategy attempts to approximate f(x) by summing PUT values.
- * Values are clamped to [-5.0, 5.0]. When all PUTs are done, returns {-1, 0.0}.
+ * Plans PUTs to lower the squared error sum (f̂(x) - f(x))² as fast as possible: f(0..K)
+ * is evaluated once with Horner's rule, and every PUT goes to the point where it removes
+ * the most error, a value clamped to [-5.0, 5.0] towards f(x). The candidates sit in a
+ * max-heap keyed by that error reduction; a PUT on a point only ever lowers its next
+ * reduction, so the greedy choice is optimal for any number of PUTs and a limited PUT
+ * budget is spent on the points that matter most.
  *
- * @return std::pair<int, double> containing the point and value.
- *         If point == -1, the strategy has finished.
+ * K is not known in advance; it is learned from STATE (setK()), so until the first
+ * STATE arrives only point 0 is played. Planning for K = 10000 takes well under a
+ * millisecond (O(K) to build the heap, O(log K) per PUT).
+ *
+ * Every instance is independent, so one process can run many players.
  */
-std::pair<int, double> strategyNextPut();
+class AutoStrategy {
+public:
+    /**
+     * @brief Starts the strategy for the given polynomial.
+     *
+     * @param coeffs Polynomial coefficients a₀...aₙ (at least one).
+     * @param budget Maximum number of PUTs to send (negative: unlimited).
+     */
+    explicit AutoStrategy(const std::vector<double> &coeffs, long budget = -1);
+
+    /**
+     * @brief Returns the next (point, value) pair to send in a PUT command.
+     *
+     * @return The point and value. If point == -1, the strategy has finished.
+     */
+    std::pair<int, double> nextPut();
+
+    /**
+     * @brief Sets the maximum point index, as seen in STATE; replans if it changed.
+     */
+    void setK(int maxPoint);
+
+private:
+    /// A point that still differs from f, keyed by the error the next PUT removes.
+    struct Candidate {
+        double gain; ///< Reduction of the squared error by the next PUT.
+        int x;       ///< The point.
+    };
+
+    /// Orders the heap by gain, then by the lower point.
+    struct LessGain {
+        bool operator()(const Candidate &a, const Candidate &b) const {
+            return a.gain < b.gain || (a.gain == b.gain && a.x > b.x);
+        }
+    };
+
+    /// Rebuilds the heap from the residuals of points 0..K.
+    void plan();
+
+    std::vector<double> coeffs;     ///< Polynomial coefficients a₀...aₙ
+    int K = 0;                      ///< Max x seen from STATE
+    bool knowsK = false;            ///< A STATE has been seen (or asked for)
+    long budget;                    ///< PUTs left to send (negative: unlimited)
+    std::vector<double> residual;   ///< f(x) minus the PUTs sent for x, for x = 0..K
+    std::vector<Candidate> heap;    ///< Points with a non-zero residual (std::push_heap order)
+};
 
 /**
  * @brief Executes the automatic gameplay loop.
  *
- * Initializes the strategy and handles communication with the server,
+ * Runs an AutoStrategy and handles communication with the server,
  * sending PUTs, processing STATE/PENALTY/SCORING messages, and handling errors.
  *
  * @param sockfd Connected socket descriptor to the server.
+ * @param input Input buffer of the socket (may already hold messages received after COEFF).
  * @param playerId Player identifier.
  * @param resolvedIP Server IP address as a string.
  * @param port Server port number.
  * @param coeffs Polynomial coefficients received from the server.
+ * @param binary Whether the connection uses binary frames (negotiated with HELLO_BIN).
+ * @param budget Maximum number of PUTs to send (negative: unlimited).
  */
 void runAutoMode(int sockfd,
+                 LineBuffer &input,
                  const std::string &playerId,
                  const std::string &resolvedIP,
                  int port,
-                 const std::vector<double> &coeffs);
+                 const std::vector<double> &coeffs,
+                 bool binary,
+                 long budget);
 
 #endif // STRATEGY_HPP
\ No newline at end of file
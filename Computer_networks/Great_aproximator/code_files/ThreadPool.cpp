@@ -0,0 +1,69 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int helpers) {
+    for (int i = 0; i < helpers; ++i) workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+void ThreadPool::runItems(Loop &loop) {
+    size_t finished = 0;
+    while (true) {
+        size_t i = loop.nextItem.fetch_add(1, std::memory_order_relaxed);
+        if (i >= loop.size) break;
+        (*loop.job)(i);
+        ++finished;
+    }
+    if (finished == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    loop.finishedItems += finished;
+    if (loop.finishedItems == loop.size) done.notify_all();
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    while (true) {
+        std::shared_ptr<Loop> loop;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]{ return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            loop = current;
+        }
+        // Null if the loop ended before this helper woke up.
+        if (loop) runItems(*loop);
+    }
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)> &fn) {
+    if (n == 0) return;
+    if (workers.empty() || n == 1) {
+        for (size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> callerLock(callerMutex);
+    auto loop = std::make_shared<Loop>(&fn, n);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = loop;
+        ++generation;
+    }
+    wake.notify_all();
+
+    runItems(*loop);
+
+    // A helper still holding the loop finds no items left and does not touch fn.
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]{ return loop->finishedItems == loop->size; });
+    current.reset();
+}
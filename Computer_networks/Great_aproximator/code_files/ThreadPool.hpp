@@ -0,0 +1,72 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of helper threads running data-parallel loops.
+ *
+ * parallelFor() splits an index range among the helpers and the calling thread, which
+ * works too and returns once every index is done. Indices are claimed one at a time
+ * from an atomic counter, so uneven items balance themselves. One loop runs at a time;
+ * a second caller waits for the first loop to finish.
+ *
+ * Every loop has its own counters, which a helper takes under the lock when it joins.
+ * A helper that is still claiming indices of a finished loop therefore never runs an
+ * index of the next one.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param helpers Number of helper threads (0: loops run on the calling thread only).
+     */
+    explicit ThreadPool(int helpers);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// Number of threads a loop runs on, the caller included.
+    int concurrency() const { return static_cast<int>(workers.size()) + 1; }
+
+    /**
+     * @brief Calls fn(i) for every i in [0, n), in parallel, and waits for all of them.
+     */
+    void parallelFor(size_t n, const std::function<void(size_t)> &fn);
+
+private:
+    /// One parallelFor() call.
+    struct Loop {
+        const std::function<void(size_t)> *job;
+        size_t size;
+        std::atomic<size_t> nextItem{0};
+        size_t finishedItems = 0; ///< Guarded by the pool's mutex.
+
+        Loop(const std::function<void(size_t)> *job, size_t size) : job(job), size(size) {}
+    };
+
+    /// Claims and runs indices of the loop until none are left.
+    void runItems(Loop &loop);
+
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+
+    std::mutex callerMutex;     ///< Serialises parallelFor() calls.
+    std::mutex mutex;           ///< Guards the fields below.
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::shared_ptr<Loop> current; ///< The loop running now, if any.
+    uint64_t generation = 0;    ///< Incremented for every loop, so helpers join each once.
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,31 @@
+#include "TimerQueue.hpp"
+
+uint64_t TimerQueue::schedule(Clock::time_point at, int fd, TimerKind kind) {
+    uint64_t id = nextId++;
+    heap.push(Entry{at, id, fd, kind});
+    return id;
+}
+
+bool TimerQueue::empty() const {
+    return heap.empty();
+}
+
+size_t TimerQueue::size() const {
+    return heap.size();
+}
+
+TimerQueue::Clock::time_point TimerQueue::nextDeadline() const {
+    return heap.top().at;
+}
+
+bool TimerQueue::popExpired(Clock::time_point now, TimerEvent &out) {
+    if (heap.empty() || heap.top().at > now) return false;
+    const Entry &top = heap.top();
+    out = TimerEvent{top.fd, top.kind, top.id, top.at};
+    heap.pop();
+    return true;
+}
+
+void TimerQueue::clear() {
+    heap = decltype(heap)();
+}
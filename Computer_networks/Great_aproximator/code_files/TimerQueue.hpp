@@ -0,0 +1,106 @@
+#ifndef TIMER_QUEUE_HPP
+#define TIMER_QUEUE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "GameClock.hpp"
+
+/**
+ * @brief Kinds of per-client timers owned by the server.
+ */
+enum class TimerKind {
+    Hello,  ///< Client did not send HELLO within 3 seconds (game time) of connecting.
+    BadPut, ///< Delayed BAD_PUT response is due.
+    State,  ///< Delayed STATE response is due.
+    Linger, ///< Client still has not read SCORING; close it anyway.
+    Resume, ///< A throttled client may be read again.
+    Round   ///< The pause after a global game is over (a shard timer, fd -1).
+};
+
+/**
+ * @brief A timer that has expired.
+ */
+struct TimerEvent {
+    int fd;         ///< Client socket the timer belongs to (-1 for a shard timer).
+    TimerKind kind; ///< What the timer is for.
+    uint64_t id;    ///< Identifier returned by TimerQueue::schedule().
+    GameClock::time_point at; ///< Deadline the timer was scheduled for.
+};
+
+/**
+ * @brief Min-heap of client deadlines with lazy cancellation.
+ *
+ * Scheduling is O(log n). Cancelling is free: the owner remembers the id of its live timer
+ * and ignores expired entries with any other id (replaced, cancelled, or belonging to a
+ * closed client whose descriptor was reused). Finding the next deadline is O(1) and
+ * processing expiries is O(expired * log n), independent of the number of clients.
+ *
+ * Timers with equal deadlines expire in scheduling order. Deadlines are in game time
+ * (GameClock), so a faster time scale shortens every timer alike.
+ */
+class TimerQueue {
+public:
+    using Clock = GameClock;
+
+    /**
+     * @brief Schedules a timer.
+     *
+     * @param at Deadline.
+     * @param fd Client socket the timer belongs to.
+     * @param kind What the timer is for.
+     * @return Unique, non-zero timer identifier.
+     */
+    uint64_t schedule(Clock::time_point at, int fd, TimerKind kind);
+
+    /**
+     * @brief Returns true if no timers are scheduled.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns the number of scheduled timers, including stale ones not yet expired.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the earliest deadline (the queue must not be empty).
+     */
+    Clock::time_point nextDeadline() const;
+
+    /**
+     * @brief Removes the earliest timer if it has expired.
+     *
+     * @param now Current time.
+     * @param out Output: the expired timer.
+     * @return true if a timer was removed, false if none has expired.
+     */
+    bool popExpired(Clock::time_point now, TimerEvent &out);
+
+    /**
+     * @brief Removes all timers.
+     */
+    void clear();
+
+private:
+    struct Entry {
+        Clock::time_point at;
+        uint64_t id;
+        int fd;
+        TimerKind kind;
+    };
+
+    /// Orders the heap by deadline, then by scheduling order.
+    struct Later {
+        bool operator()(const Entry &a, const Entry &b) const {
+            return a.at > b.at || (a.at == b.at && a.id > b.id);
+        }
+    };
+
+    std::priority_queue<Entry, std::vector<Entry>, Later> heap;
+    uint64_t nextId = 1;
+};
+
+#endif // TIMER_QUEUE_HPP
@@ -0,0 +1,20 @@
+#include "TokenBucket.hpp"
+
+#include <algorithm>
+
+void TokenBucket::refill(double rate, GameClock::time_point now) {
+    double capacity = std::max(rate, 1.0);
+    if (last == GameClock::time_point{}) {
+        tokens = capacity;
+    } else {
+        double elapsed = std::chrono::duration<double>(now - last).count();
+        tokens = std::min(capacity, tokens + elapsed * rate);
+    }
+    last = now;
+}
+
+GameClock::duration TokenBucket::untilReady(double rate) const {
+    if (tokens >= 1.0) return GameClock::duration::zero();
+    std::chrono::duration<double> wait((1.0 - tokens) / rate);
+    return std::chrono::ceil<GameClock::duration>(wait);
+}
@@ -0,0 +1,47 @@
+#ifndef TOKEN_BUCKET_HPP
+#define TOKEN_BUCKET_HPP
+
+#include "GameClock.hpp"
+
+/**
+ * @brief Token bucket limiting a client's rate of lines or bytes.
+ *
+ * Tokens accrue at `rate` per second of game time, up to one second's worth, and the
+ * bucket starts full, so a client may burst for a second before it is held to the
+ * rate. The rate is passed in on every call rather than stored, as it is the same for
+ * every client; a bucket is two words in the client's state and every operation is O(1).
+ */
+class TokenBucket {
+public:
+    /**
+     * @brief Adds the tokens earned since the previous refill.
+     *
+     * @param rate Tokens per second of game time (> 0).
+     * @param now Current game time.
+     */
+    void refill(double rate, GameClock::time_point now);
+
+    /**
+     * @brief Returns true if less than one token is left.
+     */
+    bool empty() const { return tokens < 1.0; }
+
+    /**
+     * @brief Takes tokens; the balance may go negative (bytes are charged after they
+     *        were read), which delays the next token accordingly.
+     */
+    void take(double count) { tokens -= count; }
+
+    /**
+     * @brief Returns the game time until one token is available again.
+     *
+     * @param rate Tokens per second of game time (> 0).
+     */
+    GameClock::duration untilReady(double rate) const;
+
+private:
+    double tokens = 0;
+    GameClock::time_point last{}; ///< Time of the last refill (epoch: never, the bucket is full).
+};
+
+#endif // TOKEN_BUCKET_HPP
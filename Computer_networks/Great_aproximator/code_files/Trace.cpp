@@ -0,0 +1,51 @@
+#include "Trace.hpp"
+#include "binary_protocol.hpp"
+
+void appendTraceRecord(std::string &out, uint64_t time, uint32_t connection, TraceKind kind,
+                       std::string_view payload) {
+    appendLE(out, time, 8);
+    appendLE(out, connection, 4);
+    out.push_back(static_cast<char>(kind));
+    appendLE(out, payload.size(), 4);
+    out.append(payload);
+}
+
+bool nextTraceRecord(std::string_view &data, TraceRecord &out) {
+    if (data.size() < TRACE_HEADER_SIZE) return false;
+    uint8_t kind = static_cast<uint8_t>(data[12]);
+    uint64_t length = readLE(data.data() + 13, 4);
+    if (kind < static_cast<uint8_t>(TraceKind::Open) ||
+        kind > static_cast<uint8_t>(TraceKind::Close) ||
+        data.size() - TRACE_HEADER_SIZE < length) {
+        return false;
+    }
+    out.time = readLE(data.data(), 8);
+    out.connection = static_cast<uint32_t>(readLE(data.data() + 8, 4));
+    out.kind = static_cast<TraceKind>(kind);
+    out.payload = data.substr(TRACE_HEADER_SIZE, length);
+    data.remove_prefix(TRACE_HEADER_SIZE + length);
+    return true;
+}
+
+uint64_t traceHash(std::string_view msg) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : msg) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void appendTraceReply(std::string &out, std::string_view msg) {
+    appendLE(out, traceHash(msg), 8);
+    appendLE(out, msg.size(), 4);
+    out.append(msg.substr(0, TRACE_REPLY_PREFIX));
+}
+
+bool parseTraceReply(std::string_view payload, TraceReply &out) {
+    if (payload.size() < 12) return false;
+    out.hash = readLE(payload.data(), 8);
+    out.size = static_cast<uint32_t>(readLE(payload.data() + 8, 4));
+    out.prefix = payload.substr(12);
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Traffic trace written by `approx-server -w` and read by `approx-replay`.
+ *
+ * The file starts with TRACE_MAGIC, followed by records:
+ *
+ *   uint64 time         ns since the recording started
+ *   uint32 connection   unique per accepted connection (kept when a client moves shard)
+ *   uint8  kind         TraceKind
+ *   uint32 length       payload size
+ *   payload             depends on the kind
+ *
+ * Integers are little-endian, like binary frames. Every shard appends its records in
+ * batches, so records of different shards interleave; ordering them by time restores
+ * each connection's history.
+ */
+
+/// First bytes of a trace file (includes the format version).
+constexpr std::string_view TRACE_MAGIC = "APXTRC1\n";
+
+/// Size of a record without its payload.
+constexpr size_t TRACE_HEADER_SIZE = 17;
+
+/// What a trace record describes.
+enum class TraceKind : uint8_t {
+    Open   = 1, ///< The server accepted the connection (no payload).
+    Line   = 2, ///< Text message from the client, without "\r\n".
+    Frame  = 3, ///< Binary frame from the client, without its length field.
+    Reply  = 4, ///< Digest of a message the server queued for the client (see TraceReply).
+    Close  = 5  ///< The server removed the connection (no payload).
+};
+
+/// Bytes of a reply kept verbatim in its record, for reports.
+constexpr size_t TRACE_REPLY_PREFIX = 32;
+
+/**
+ * @brief A reply as recorded: a digest of the message instead of the message itself,
+ *        since STATE lines (K + 1 values) would dominate the trace.
+ *
+ * Payload of a Reply record: uint64 hash (traceHash() of the message as sent, framing
+ * included), uint32 size, then its first TRACE_REPLY_PREFIX bytes (fewer if shorter).
+ */
+struct TraceReply {
+    uint64_t hash;
+    uint32_t size;
+    std::string_view prefix;
+};
+
+/**
+ * @brief Returns the 64-bit FNV-1a hash of a message.
+ */
+uint64_t traceHash(std::string_view msg);
+
+/**
+ * @brief Appends the payload of a Reply record for the given message.
+ */
+void appendTraceReply(std::string &out, std::string_view msg);
+
+/**
+ * @brief Decodes the payload of a Reply record.
+ *
+ * @return false if the payload is too short.
+ */
+bool parseTraceReply(std::string_view payload, TraceReply &out);
+
+/**
+ * @brief One record of a trace.
+ */
+struct TraceRecord {
+    uint64_t time;            ///< ns since the recording started.
+    uint32_t connection;      ///< Connection the record belongs to.
+    TraceKind kind;           ///< What the record describes.
+    std::string_view payload; ///< View into the trace data.
+};
+
+/**
+ * @brief Appends a record to a buffer.
+ */
+void appendTraceRecord(std::string &out, uint64_t time, uint32_t connection, TraceKind kind,
+                       std::string_view payload = {});
+
+/**
+ * @brief Reads the next record and advances past it.
+ *
+ * @param data Remaining trace data (after TRACE_MAGIC); advanced past the record.
+ * @param out Output: the record (its payload is a view into data).
+ * @return false at the end of the data or if the record is truncated or invalid.
+ */
+bool nextTraceRecord(std::string_view &data, TraceRecord &out);
+
+#endif // TRACE_HPP
@@ -0,0 +1,65 @@
+#include "TraceRecorder.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+/// A thread's buffer is written out as soon as it holds this much, even mid-iteration.
+static const size_t FLUSH_BYTES = 1 << 20;
+
+int TraceRecorder::traceFd = -1;
+std::atomic<uint32_t> TraceRecorder::nextConnection{1};
+std::chrono::steady_clock::time_point TraceRecorder::origin;
+
+/// Records of the calling thread not yet written.
+static thread_local std::string buffer;
+
+bool TraceRecorder::start(const std::string &path) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "ERROR: open(" << path << "): " << strerror(errno) << "\n";
+        return false;
+    }
+    if (write(fd, TRACE_MAGIC.data(), TRACE_MAGIC.size()) != static_cast<ssize_t>(TRACE_MAGIC.size())) {
+        std::cerr << "ERROR: write(" << path << "): " << strerror(errno) << "\n";
+        close(fd);
+        return false;
+    }
+    origin = std::chrono::steady_clock::now();
+    traceFd = fd;
+    return true;
+}
+
+/**
+ * @brief Returns the ns elapsed since the recording started.
+ */
+static uint64_t elapsed(std::chrono::steady_clock::time_point origin) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - origin).count());
+}
+
+void TraceRecorder::record(uint32_t connection, TraceKind kind, std::string_view payload) {
+    appendTraceRecord(buffer, elapsed(origin), connection, kind, payload);
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void TraceRecorder::recordReply(uint32_t connection, std::string_view msg) {
+    // Reused, so encoding a digest does not allocate.
+    static thread_local std::string digest;
+    digest.clear();
+    appendTraceReply(digest, msg);
+    record(connection, TraceKind::Reply, digest);
+}
+
+void TraceRecorder::flush() {
+    if (buffer.empty() || traceFd < 0) return;
+    // O_APPEND writes to a regular file are not split, unless the disk is full.
+    ssize_t written = write(traceFd, buffer.data(), buffer.size());
+    if (written != static_cast<ssize_t>(buffer.size())) {
+        std::cerr << "ERROR: writing the trace failed ("
+                  << (written < 0 ? strerror(errno) : "short write") << "); records lost\n";
+    }
+    buffer.clear();
+}
@@ -0,0 +1,71 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Trace.hpp"
+
+/**
+ * @brief Records the server's traffic into a trace file (see Trace.hpp) for approx-replay.
+ *
+ * Each thread appends records to its own buffer, without locks, and flush() writes the
+ * buffer with one write() to the file opened with O_APPEND, so batches of different
+ * shards never tear each other. The event loops flush once per iteration, so a trace is
+ * complete up to the last iteration even if the server is killed.
+ *
+ * Recording is off unless start() succeeded; then the cost on the event loops is a
+ * clock read and a copy of each client message, or a hash of each reply.
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief Creates (or truncates) the trace file and starts recording.
+     *
+     * @param path Trace file.
+     * @return false if the file cannot be written (the error is reported).
+     */
+    static bool start(const std::string &path);
+
+    /// Whether traffic is being recorded.
+    static bool enabled() { return traceFd >= 0; }
+
+    /**
+     * @brief Returns a new connection number, unique for the whole server.
+     */
+    static uint32_t newConnection() {
+        return nextConnection.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Appends a record to the calling thread's buffer (recording must be enabled).
+     *
+     * @param connection Connection number.
+     * @param kind What the record describes.
+     * @param payload Message bytes (empty for Open and Close).
+     */
+    static void record(uint32_t connection, TraceKind kind, std::string_view payload = {});
+
+    /**
+     * @brief Appends a Reply record (a digest of the message) to the calling thread's buffer.
+     *
+     * @param connection Connection number.
+     * @param msg The message as queued, framing included.
+     */
+    static void recordReply(uint32_t connection, std::string_view msg);
+
+    /**
+     * @brief Writes the calling thread's buffered records to the file.
+     */
+    static void flush();
+
+private:
+    static int traceFd;
+    static std::atomic<uint32_t> nextConnection;
+    static std::chrono::steady_clock::time_point origin;
+};
+
+#endif // TRACE_RECORDER_HPP
@@ -0,0 +1,507 @@
+#include "UringEngine.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/// Submission queue entries; the completion queue is larger, as multishot requests
+/// complete many times.
+static const unsigned RING_ENTRIES = 4096;
+static const unsigned CQ_ENTRIES = 4 * RING_ENTRIES;
+
+/// Provided receive buffers: enough for several batches of MAX_EVENTS completions.
+static const unsigned BUFFER_COUNT = 4096;
+static const unsigned BUFFER_SIZE = 1024;
+static const uint16_t BUFFER_GROUP = 0;
+
+/// Generations are kept in 24 bits of user_data.
+static const uint32_t GENERATION_MASK = 0xffffff;
+
+/**
+ * @brief Builds the user_data of a request: its kind, the client's generation and fd.
+ */
+static uint64_t tag(uint8_t op, uint32_t generation, int fd) {
+    return uint64_t(op) << 56 | uint64_t(generation & GENERATION_MASK) << 32 | uint32_t(fd);
+}
+
+/**
+ * @brief Builds the user_data of a send: its kind and the address of its SendOp
+ *        (user-space addresses fit in 56 bits).
+ */
+static uint64_t sendTag(uint8_t op, const void *sendOp) {
+    return uint64_t(op) << 56 | reinterpret_cast<uintptr_t>(sendOp);
+}
+
+UringEngine::~UringEngine() {
+    // Closing the ring cancels every request still in flight.
+    if (ringFd >= 0) close(ringFd);
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (bufRing) munmap(bufRing, BUFFER_COUNT * sizeof(struct io_uring_buf));
+    if (buffers) munmap(buffers, size_t(BUFFER_COUNT) * BUFFER_SIZE);
+    for (Client &c : clients) {
+        if (c.send && c.send->done) delete c.send;
+    }
+    for (SendOp *op : spareSends) delete op;
+}
+
+bool UringEngine::open() {
+    struct io_uring_params params{};
+    // Completions are produced only when the shard asks for them (DEFER_TASKRUN), by
+    // the one thread that submits (SINGLE_ISSUER).
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+                   IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = CQ_ENTRIES;
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+    if (ringFd < 0) {
+        std::cerr << "ERROR: io_uring_setup(): " << strerror(errno)
+                  << " (the uring engine needs Linux 6.1+)\n";
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP)) {
+        std::cerr << "ERROR: io_uring lacks EXT_ARG or NODROP (the uring engine needs Linux 6.1+)\n";
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        std::cerr << "ERROR: mmap(io_uring SQ): " << strerror(errno) << "\n";
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing = sqRing;
+    } else {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            std::cerr << "ERROR: mmap(io_uring CQ): " << strerror(errno) << "\n";
+            return false;
+        }
+    }
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqeMemory = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ringFd, IORING_OFF_SQES);
+    if (sqeMemory == MAP_FAILED) {
+        std::cerr << "ERROR: mmap(io_uring SQEs): " << strerror(errno) << "\n";
+        return false;
+    }
+    sqes = static_cast<struct io_uring_sqe*>(sqeMemory);
+
+    char *sq = static_cast<char*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqeTail = *sqTail;
+    unsigned *array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; ++i) array[i] = i;
+
+    char *cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // The buffer ring and the buffers are touched only as they are used.
+    void *ringMemory = mmap(nullptr, BUFFER_COUNT * sizeof(struct io_uring_buf),
+                            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *bufferMemory = mmap(nullptr, size_t(BUFFER_COUNT) * BUFFER_SIZE,
+                              PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMemory == MAP_FAILED || bufferMemory == MAP_FAILED) {
+        std::cerr << "ERROR: mmap(receive buffers): " << strerror(errno) << "\n";
+        if (ringMemory != MAP_FAILED) munmap(ringMemory, BUFFER_COUNT * sizeof(struct io_uring_buf));
+        if (bufferMemory != MAP_FAILED) munmap(bufferMemory, size_t(BUFFER_COUNT) * BUFFER_SIZE);
+        return false;
+    }
+    bufRing = static_cast<struct io_uring_buf_ring*>(ringMemory);
+    buffers = static_cast<char*>(bufferMemory);
+
+    struct io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        std::cerr << "ERROR: io_uring_register(PBUF_RING): " << strerror(errno)
+                  << " (the uring engine needs Linux 6.1+)\n";
+        return false;
+    }
+    for (unsigned i = 0; i < BUFFER_COUNT; ++i) usedBuffers.push_back(static_cast<uint16_t>(i));
+    return true;
+}
+
+UringEngine::Client &UringEngine::client(int fd) {
+    if (static_cast<size_t>(fd) >= clients.size()) clients.resize(fd + 1);
+    return clients[fd];
+}
+
+struct io_uring_sqe *UringEngine::nextSqe() {
+    if (sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries) {
+        // The queue is full: submit it now, without waiting.
+        if (!enter(0, std::chrono::nanoseconds(-1)) ||
+            sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries) {
+            std::cerr << "ERROR: io_uring submission queue stuck\n";
+            exit(1);
+        }
+    }
+    struct io_uring_sqe *sqe = &sqes[sqeTail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqeTail;
+    return sqe;
+}
+
+/**
+ * @brief Submits the queued requests and waits for completions.
+ *
+ * @param minComplete Completions to wait for (0: only submit and collect).
+ * @param timeout Longest wait; negative waits as long as needed.
+ * @return false on an unrecoverable error (printed).
+ */
+bool UringEngine::enter(unsigned minComplete, std::chrono::nanoseconds timeout) {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    struct io_uring_getevents_arg arg{};
+    struct __kernel_timespec ts{};
+    void *argp = nullptr;
+    size_t argSize = 0;
+    if (minComplete > 0 && timeout >= std::chrono::nanoseconds::zero()) {
+        ts.tv_sec = timeout.count() / 1000000000;
+        ts.tv_nsec = timeout.count() % 1000000000;
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        flags |= IORING_ENTER_EXT_ARG;
+        argp = &arg;
+        argSize = sizeof(arg);
+    }
+
+    syscalls.add();
+    if (syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, argp, argSize) < 0 &&
+        errno != ETIME && errno != EINTR && errno != EBUSY) {
+        std::cerr << "ERROR: io_uring_enter(): " << strerror(errno) << "\n";
+        return false;
+    }
+    return true;
+}
+
+void UringEngine::armAccept(int fd) {
+    struct io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK;
+    sqe->user_data = tag(uint8_t(Op::Accept), 0, fd);
+}
+
+void UringEngine::armRecv(int fd) {
+    Client &c = client(fd);
+    struct io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = tag(uint8_t(Op::Recv), c.generation, fd);
+    c.receiving = true;
+}
+
+void UringEngine::armWake() {
+    struct io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = tag(uint8_t(Op::Wake), 0, wakeFd);
+}
+
+void UringEngine::cancel(uint64_t userData) {
+    struct io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = userData;
+    sqe->user_data = tag(uint8_t(Op::Cancel), 0, 0);
+}
+
+void UringEngine::freeSend(SendOp *op) {
+    op->hold.clear();
+    spareSends.push_back(op);
+}
+
+bool UringEngine::addListener(int fd, bool) {
+    // On a shared socket every shard's accept competes; each connection completes one.
+    listeners.push_back(fd);
+    armAccept(fd);
+    return true;
+}
+
+bool UringEngine::setWakeFd(int fd) {
+    wakeFd = fd;
+    armWake();
+    return true;
+}
+
+bool UringEngine::addClient(int fd) {
+    Client &c = client(fd);
+    c.registered = true;
+    c.paused = false;
+    armRecv(fd);
+    return true;
+}
+
+bool UringEngine::releaseClient(int fd, LineBuffer &input, OutputQueue &output) {
+    Client &c = client(fd);
+    const uint64_t recvTag = tag(uint8_t(Op::Recv), c.generation, fd);
+
+    // Bytes delivered by the last wait() and not handled yet.
+    for (IoEvent &event : batch) {
+        if (event.kind == IoEventKind::Readable && event.fd == fd &&
+            event.generation == c.generation && !event.data.empty()) {
+            event.data.remove_prefix(input.append(event.data));
+        }
+    }
+
+    // Stop the recv and collect what it received meanwhile; the new owner's recv
+    // takes over from there. Other completions are handled by the next wait().
+    if (c.receiving) cancel(recvTag);
+    while (c.receiving || (c.send && !c.send->done)) {
+        if (!enter(1, std::chrono::nanoseconds(-1))) return false;
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const struct io_uring_cqe &cqe = cqes[head & cqMask];
+            if (cqe.user_data == recvTag) {
+                if (cqe.flags & IORING_CQE_F_BUFFER) {
+                    uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                    usedBuffers.push_back(bid);
+                    if (cqe.res > 0) input.append({buffers + size_t(bid) * BUFFER_SIZE, size_t(cqe.res)});
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE)) c.receiving = false;
+            } else if (c.send && cqe.user_data == sendTag(uint8_t(Op::Send), c.send)) {
+                c.send->done = true;
+                c.send->result = cqe.res;
+            } else {
+                deferred.push_back(cqe);
+            }
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    if (c.send) {
+        if (c.send->result > 0) output.consume(static_cast<size_t>(c.send->result));
+        freeSend(c.send);
+        c.send = nullptr;
+    }
+    c.registered = false;
+    c.paused = false;
+    c.generation = (c.generation + 1) & GENERATION_MASK;
+    return true;
+}
+
+void UringEngine::removeClient(int fd) {
+    Client &c = client(fd);
+    if (!c.registered) return; // released to another shard
+    // The socket may be closed already, so the recv is found by its user_data.
+    if (c.receiving) cancel(tag(uint8_t(Op::Recv), c.generation, fd));
+    // A send still in flight is freed when it completes.
+    if (c.send && c.send->done) freeSend(c.send);
+    c.send = nullptr;
+    c.registered = false;
+    c.receiving = false;
+    c.paused = false;
+    c.generation = (c.generation + 1) & GENERATION_MASK;
+}
+
+void UringEngine::pauseClient(int fd) {
+    Client &c = client(fd);
+    if (!c.registered || c.paused) return;
+    c.paused = true;
+    if (c.receiving) cancel(tag(uint8_t(Op::Recv), c.generation, fd));
+}
+
+void UringEngine::resumeClient(int fd) {
+    Client &c = client(fd);
+    if (!c.registered || !c.paused) return;
+    c.paused = false;
+    // While the cancel is still in flight, its completion re-arms the recv.
+    if (!c.receiving) armRecv(fd);
+}
+
+/**
+ * @brief Turns a completion into events (or drops it if its client is gone).
+ */
+void UringEngine::complete(const struct io_uring_cqe &cqe) {
+    const bool more = cqe.flags & IORING_CQE_F_MORE;
+    const int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+
+    switch (static_cast<Op>(cqe.user_data >> 56)) {
+        case Op::Accept:
+            if (cqe.res >= 0) {
+                addClient(cqe.res);
+                batch.push_back({IoEventKind::Accepted, cqe.res});
+            } else if (cqe.res != -EAGAIN && cqe.res != -EINTR && cqe.res != -ECONNABORTED) {
+                std::cerr << "ERROR: accept(): " << strerror(-cqe.res) << "\n";
+            }
+            if (!more) armAccept(fd);
+            break;
+
+        case Op::Recv: {
+            const uint32_t generation = (cqe.user_data >> 32) & GENERATION_MASK;
+            std::string_view data;
+            if (cqe.flags & IORING_CQE_F_BUFFER) {
+                uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+                usedBuffers.push_back(bid);
+                data = std::string_view(buffers + size_t(bid) * BUFFER_SIZE,
+                                        cqe.res > 0 ? size_t(cqe.res) : 0);
+            }
+            Client &c = client(fd);
+            if (!c.registered || c.generation != generation) break;
+            if (!more) c.receiving = false;
+            if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED) {
+                // The buffer ring ran dry (the buffers come back at the next wait()),
+                // or the client was paused, and maybe resumed since.
+                if (!more && !c.paused) rearm.emplace_back(fd, generation);
+                break;
+            }
+            batch.push_back({IoEventKind::Readable, fd, generation, cqe.res, data});
+            if (!more && cqe.res > 0 && !c.paused) rearm.emplace_back(fd, generation);
+            break;
+        }
+
+        case Op::Wake: {
+            // Resets the counter.
+            uint64_t value;
+            ssize_t got = read(wakeFd, &value, sizeof(value));
+            (void)got;
+            syscalls.add();
+            batch.push_back({IoEventKind::Wake, wakeFd});
+            if (!more) armWake();
+            break;
+        }
+
+        case Op::Send: {
+            SendOp *op = reinterpret_cast<SendOp*>(cqe.user_data & ((uint64_t(1) << 56) - 1));
+            if (client(op->fd).send != op) {
+                freeSend(op); // its client was removed meanwhile
+                break;
+            }
+            op->done = true;
+            op->result = cqe.res;
+            batch.push_back({IoEventKind::Writable, op->fd, op->generation, cqe.res});
+            break;
+        }
+
+        case Op::Cancel:
+            break;
+    }
+}
+
+bool UringEngine::wait(std::chrono::nanoseconds timeout) {
+    batch.clear();
+
+    // The previous events have been handled; their buffers go back to the ring.
+    if (!usedBuffers.empty()) {
+        for (uint16_t bid : usedBuffers) {
+            // Indexed from the ring itself: in C++ the header's flexible `bufs` member
+            // sits after an empty struct of size 1, i.e. at the wrong offset.
+            struct io_uring_buf &buf =
+                reinterpret_cast<struct io_uring_buf*>(bufRing)[bufTail & (BUFFER_COUNT - 1)];
+            buf.addr = reinterpret_cast<uint64_t>(buffers + size_t(bid) * BUFFER_SIZE);
+            buf.len = BUFFER_SIZE;
+            buf.bid = bid;
+            ++bufTail;
+        }
+        __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+        usedBuffers.clear();
+    }
+    for (const auto &[fd, generation] : rearm) {
+        Client &c = client(fd);
+        if (c.registered && c.generation == generation && !c.receiving && !c.paused) armRecv(fd);
+    }
+    rearm.clear();
+
+    for (const struct io_uring_cqe &cqe : deferred) complete(cqe);
+    deferred.clear();
+
+    // One call submits the queued sends and collects the completions.
+    bool pending = !batch.empty() || *cqHead != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    if (!enter(pending ? 0 : 1, timeout)) return false;
+
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail && batch.size() < MAX_EVENTS) {
+        complete(cqes[head & cqMask]);
+        ++head;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+LineBuffer::FillStatus UringEngine::receive(IoEvent &event, LineBuffer &input) {
+    // Everything taken already, or no completion attached (input buffered elsewhere).
+    if (event.result > 0 && event.data.empty()) return LineBuffer::FillStatus::Drained;
+    Client &c = client(event.fd);
+    if (!c.registered || c.generation != event.generation) {
+        event.data = {};
+        return LineBuffer::FillStatus::Drained;
+    }
+    if (event.result <= 0) return LineBuffer::FillStatus::Closed;
+    event.data.remove_prefix(input.append(event.data));
+    return event.data.empty() ? LineBuffer::FillStatus::Drained : LineBuffer::FillStatus::Full;
+}
+
+OutputQueue::FlushStatus UringEngine::send(int fd, OutputQueue &output) {
+    Client &c = client(fd);
+    if (c.send) return OutputQueue::FlushStatus::Blocked;
+    if (output.empty()) return OutputQueue::FlushStatus::Done;
+
+    SendOp *op;
+    if (spareSends.empty()) {
+        op = new SendOp;
+    } else {
+        op = spareSends.back();
+        spareSends.pop_back();
+    }
+    op->fd = fd;
+    op->generation = c.generation;
+    op->done = false;
+    op->result = 0;
+    std::memset(&op->msg, 0, sizeof(op->msg));
+    op->msg.msg_iov = op->iov;
+    op->msg.msg_iovlen = output.prepare(op->iov, OutputQueue::MAX_IOV, &op->hold);
+
+    struct io_uring_sqe *sqe = nextSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = sendTag(uint8_t(Op::Send), op);
+    c.send = op;
+    return OutputQueue::FlushStatus::Blocked;
+}
+
+bool UringEngine::sent(const IoEvent &event, OutputQueue &output) {
+    Client &c = client(event.fd);
+    SendOp *op = c.send;
+    if (!op || !op->done || op->generation != event.generation) return true;
+    c.send = nullptr;
+    int result = op->result;
+    freeSend(op);
+    if (result < 0) return false;
+    output.consume(static_cast<size_t>(result));
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef URING_ENGINE_HPP
+#define URING_ENGINE_HPP
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "IoEngine.hpp"
+
+/**
+ * @brief IoEngine on io_uring (Linux 6.1+), driven with raw system calls.
+ *
+ *  - Listening sockets have a multishot accept armed: every connection is one
+ *    completion, with no accept() call.
+ *  - Every client has a multishot recv armed that picks buffers from a ring of
+ *    provided buffers, so idle clients hold no memory and received bytes arrive with
+ *    the completion (copied into the client's LineBuffer by receive()). Buffers are
+ *    returned to the ring at the next wait().
+ *  - send() queues one sendmsg per client with the front of its OutputQueue; the
+ *    queued sends are submitted by the io_uring_enter() of the next wait(), which also
+ *    collects the completions. With IORING_SETUP_DEFER_TASKRUN completions are only
+ *    produced inside that call, so a loop iteration costs one system call however many
+ *    clients it serves.
+ *
+ * Pausing a client cancels its recv; bytes that arrived before the cancel still come as
+ * Readable events.
+ *
+ * Completions carry the client's registration generation, so a late completion for a
+ * closed client is never mistaken for one of a new client reusing its descriptor.
+ */
+class UringEngine : public IoEngine {
+public:
+    explicit UringEngine(Counter &syscalls) : IoEngine(syscalls) {}
+    ~UringEngine() override;
+
+    /**
+     * @brief Sets up the ring and registers the provided buffers.
+     *
+     * @return false if io_uring is unavailable or too old (the error is printed).
+     */
+    bool open();
+
+    bool addListener(int fd, bool shared) override;
+    bool setWakeFd(int fd) override;
+    bool addClient(int fd) override;
+    bool releaseClient(int fd, LineBuffer &input, OutputQueue &output) override;
+    void removeClient(int fd) override;
+    void pauseClient(int fd) override;
+    void resumeClient(int fd) override;
+    bool wait(std::chrono::nanoseconds timeout) override;
+    LineBuffer::FillStatus receive(IoEvent &event, LineBuffer &input) override;
+    OutputQueue::FlushStatus send(int fd, OutputQueue &output) override;
+    bool sent(const IoEvent &event, OutputQueue &output) override;
+
+private:
+    /// Kind of a request, in the top byte of its user_data.
+    enum class Op : uint8_t { Accept = 1, Recv, Wake, Send, Cancel };
+
+    /// A sendmsg in flight; owns what the kernel reads until it completes.
+    struct SendOp {
+        int fd;
+        uint32_t generation;
+        bool done = false;        ///< Completed; waiting for sent().
+        int result = 0;
+        struct msghdr msg;
+        struct iovec iov[OutputQueue::MAX_IOV];
+        std::vector<OutputQueue::Message> hold;
+    };
+
+    /// Registration of one client descriptor.
+    struct Client {
+        uint32_t generation = 0;  ///< Bumped when the client is removed or released.
+        bool registered = false;
+        bool receiving = false;   ///< A multishot recv is armed.
+        bool paused = false;      ///< Not to be read: the recv is cancelled and not re-armed.
+        SendOp *send = nullptr;   ///< Send in flight or completed but not yet accounted.
+    };
+
+    Client &client(int fd);
+    struct io_uring_sqe *nextSqe();
+    bool enter(unsigned minComplete, std::chrono::nanoseconds timeout);
+    void armAccept(int fd);
+    void armRecv(int fd);
+    void armWake();
+    void cancel(uint64_t userData);
+    void complete(const struct io_uring_cqe &cqe);
+    void freeSend(SendOp *op);
+
+    int ringFd = -1;
+
+    // Submission queue; sqes[i] is always at array slot i.
+    void *sqRing = nullptr;
+    size_t sqRingSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+    unsigned sqeTail = 0;      ///< Our tail, published at the next enter().
+    struct io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+
+    // Completion queue.
+    void *cqRing = nullptr;
+    size_t cqRingSize = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    struct io_uring_cqe *cqes = nullptr;
+
+    // Provided buffers for multishot recv.
+    struct io_uring_buf_ring *bufRing = nullptr;
+    char *buffers = nullptr;
+    uint16_t bufTail = 0;
+    std::vector<uint16_t> usedBuffers;   ///< Returned to the ring at the next wait().
+
+    std::vector<Client> clients;         ///< By descriptor.
+    std::vector<int> listeners;
+    std::vector<std::pair<int, uint32_t>> rearm; ///< Recvs stopped for lack of buffers.
+    std::vector<struct io_uring_cqe> deferred;   ///< Collected by releaseClient().
+    std::vector<SendOp*> spareSends;
+    int wakeFd = -1;
+};
+
+#endif // URING_ENGINE_HPP
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "utils.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+#include "StateEncoder.hpp"
+
+/**
+ * approx-parse-bench: measures the throughput of protocol parsing in MB/s.
+ *
+ * Two workloads are parsed repeatedly from memory:
+ *   - STATE lines with K + 1 values, as produced by the server (client side),
+ *   - PUT lines, as received by the server (server side).
+ *
+ * Each workload is parsed by the current code (string_view tokens, std::from_chars)
+ * and by the previous implementation, reproduced below (a std::string per token,
+ * std::stod / strtol / strtod). Heap allocations per message are counted too.
+ *
+ * Finally the protocol work of whole PUT round trips is compared between the text and
+ * the binary encoding (HELLO_BIN): the client encodes a PUT, the server decodes it and
+ * updates its encoded STATE, the client decodes that STATE. It reports CPU time and
+ * bytes on the wire per PUT.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+// -----------------------------------------------------------------------------
+// Allocation counter
+
+static size_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// -----------------------------------------------------------------------------
+// Previous implementation, kept here only as the baseline
+
+/**
+ * @brief Old tokenizer: copies every token into its own std::string.
+ */
+static std::vector<std::string> legacySplitBySpace(std::string_view s) {
+    std::vector<std::string> tokens;
+    size_t i = 0, n = s.size();
+    while (i < n) {
+        while (i < n && s[i] == ' ') ++i;
+        if (i >= n) break;
+        size_t j = i;
+        while (j < n && s[j] != ' ') ++j;
+        tokens.emplace_back(s.substr(i, j - i));
+        i = j;
+    }
+    return tokens;
+}
+
+/**
+ * @brief Old parseSTATE: std::stod with exception handling.
+ */
+static bool legacyParseSTATE(const std::vector<std::string> &tokens, std::vector<double> &outState) {
+    if (tokens.empty() || tokens[0] != "STATE")
+        return false;
+    outState.clear();
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        try {
+            outState.push_back(std::stod(tokens[i]));
+        } catch (...) {
+            return false;
+        }
+    }
+    return !outState.empty();
+}
+
+static bool legacyParseInteger(const std::string &s, int &out) {
+    char* endptr = nullptr;
+    errno = 0;
+    long val = strtol(s.c_str(), &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || val < INT_MIN || val > INT_MAX) return false;
+    out = static_cast<int>(val);
+    return true;
+}
+
+static bool legacyParseReal(const std::string &s, double &out) {
+    char* endptr = nullptr;
+    errno = 0;
+    double val = strtod(s.c_str(), &endptr);
+    if (errno != 0 || *endptr != '\0') return false;
+    out = val;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Workloads
+
+/// Parses every line once; returns a checksum so the work cannot be optimised away.
+using ParseFn = double (*)(const std::vector<std::string> &lines);
+
+static double parseStateLegacy(const std::vector<std::string> &lines) {
+    static std::vector<double> state;
+    double sum = 0.0;
+    for (const std::string &line : lines) {
+        auto tokens = legacySplitBySpace(line);
+        if (!legacyParseSTATE(tokens, state)) return -1.0;
+        sum += state.back();
+    }
+    return sum;
+}
+
+static double parseStateCurrent(const std::vector<std::string> &lines) {
+    static std::vector<std::string_view> tokens;
+    static std::vector<double> state;
+    double sum = 0.0;
+    for (const std::string &line : lines) {
+        splitBySpace(line, tokens);
+        if (!parseSTATE(tokens, state)) return -1.0;
+        sum += state.back();
+    }
+    return sum;
+}
+
+static double parsePutLegacy(const std::vector<std::string> &lines) {
+    double sum = 0.0;
+    for (const std::string &line : lines) {
+        auto tokens = legacySplitBySpace(line);
+        int point;
+        double val;
+        if (tokens.size() != 3 || tokens[0] != "PUT" ||
+            !legacyParseInteger(tokens[1], point) || !legacyParseReal(tokens[2], val))
+            return -1.0;
+        sum += point + val;
+    }
+    return sum;
+}
+
+static double parsePutCurrent(const std::vector<std::string> &lines) {
+    static std::vector<std::string_view> tokens;
+    double sum = 0.0;
+    for (const std::string &line : lines) {
+        splitBySpace(line, tokens);
+        int point;
+        double val;
+        if (tokens.size() != 3 || tokens[0] != "PUT" ||
+            !parseInteger(tokens[1], point) || !parseReal(tokens[2], val))
+            return -1.0;
+        sum += point + val;
+    }
+    return sum;
+}
+
+/**
+ * @brief Builds STATE lines exactly as the server encodes them (without "\r\n").
+ */
+static std::vector<std::string> makeStateLines(int K, int count, std::mt19937_64 &rng) {
+    std::uniform_real_distribution<double> value(-50.0, 50.0);
+    std::vector<double> approx(K + 1, 0.0);
+    StateEncoder encoder(K);
+    for (int i = 0; i <= K; ++i) {
+        approx[i] = value(rng);
+        encoder.update(approx.data(), i);
+    }
+
+    std::vector<std::string> lines;
+    std::uniform_int_distribution<int> point(0, K);
+    for (int i = 0; i < count; ++i) {
+        int p = point(rng);
+        approx[p] = value(rng);
+        encoder.update(approx.data(), p);
+        const std::string &msg = *encoder.message();
+        lines.emplace_back(msg, 0, msg.size() - 2);
+    }
+    return lines;
+}
+
+/**
+ * @brief Builds PUT lines as a client would send them (without "\r\n").
+ */
+static std::vector<std::string> makePutLines(int K, int count, std::mt19937_64 &rng) {
+    std::uniform_int_distribution<int> point(0, K);
+    std::uniform_real_distribution<double> value(-5.0, 5.0);
+    std::vector<std::string> lines;
+    for (int i = 0; i < count; ++i) {
+        std::string msg = makePUT(point(rng), value(rng));
+        lines.push_back(msg.substr(0, msg.size() - 2));
+    }
+    return lines;
+}
+
+// -----------------------------------------------------------------------------
+// PUT round trips, text vs binary
+
+using Puts = std::vector<std::pair<int, double>>;
+
+/// Runs the protocol work of every PUT once; returns a checksum and counts wire bytes.
+using PutCycleFn = double (*)(const Puts &puts, int K, size_t &wireBytes);
+
+static double putCycleText(const Puts &puts, int K, size_t &wireBytes) {
+    static std::vector<std::string_view> tokens;
+    static std::vector<double> state;
+    std::vector<double> approx(K + 1, 0.0);
+    StateEncoder encoder(K);
+    double sum = 0.0;
+    for (auto [p, v] : puts) {
+        std::string put = makePUT(p, v);                          // client
+        splitBySpace(std::string_view(put).substr(0, put.size() - 2), tokens); // server
+        int point;
+        double val;
+        if (tokens.size() != 3 || !parseInteger(tokens[1], point) || !parseReal(tokens[2], val))
+            return -1.0;
+        approx[point] += val;
+        encoder.update(approx.data(), point);
+        std::shared_ptr<const std::string> msg = encoder.message();
+        splitBySpace(std::string_view(*msg).substr(0, msg->size() - 2), tokens); // client
+        if (!parseSTATE(tokens, state)) return -1.0;
+        sum += state[point];
+        wireBytes += put.size() + msg->size();
+    }
+    return sum;
+}
+
+static double putCycleBinary(const Puts &puts, int K, size_t &wireBytes) {
+    static std::vector<double> state;
+    std::vector<double> approx(K + 1, 0.0);
+    StateEncoder encoder(K, true);
+    double sum = 0.0;
+    for (auto [p, v] : puts) {
+        std::string put = makeBinaryPUT(p, v);                    // client
+        FrameType type;
+        std::string_view payload;
+        uint32_t point;
+        double val;
+        if (!splitFrame(std::string_view(put).substr(4), type, payload) || // server
+            !parseBinaryPUT(payload, point, val))
+            return -1.0;
+        approx[point] += val;
+        encoder.update(approx.data(), point);
+        std::shared_ptr<const std::string> msg = encoder.message();
+        if (!splitFrame(std::string_view(*msg).substr(4), type, payload) || // client
+            !parseBinaryDoubles(payload, state))
+            return -1.0;
+        sum += state[point];
+        wireBytes += put.size() + msg->size();
+    }
+    return sum;
+}
+
+/**
+ * @brief Runs the PUT round trips `rounds` times and prints CPU time and bytes per PUT.
+ */
+static void runPutCycle(const char* impl, PutCycleFn fn, const Puts &puts, int K, int rounds) {
+    size_t wireBytes = 0;
+    fn(puts, K, wireBytes); // Warm-up: grows reused buffers.
+    wireBytes = 0;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+        fn(puts, K, wireBytes);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double count = static_cast<double>(puts.size()) * rounds;
+    printf("PUT+STATE %-8s %10.0f ns/PUT %12.1f B/PUT\n",
+           impl, seconds / count * 1e9, wireBytes / count);
+}
+
+/**
+ * @brief Runs one parser over the lines `rounds` times and prints MB/s and allocations.
+ *
+ * @return The checksum of the last round.
+ */
+static double runCase(const char* workload, const char* impl, ParseFn fn,
+                      const std::vector<std::string> &lines, int rounds)
+{
+    size_t bytes = 0;
+    for (const std::string &line : lines) bytes += line.size();
+
+    double checksum = fn(lines); // Warm-up: grows reused buffers.
+    size_t allocsBefore = g_allocations;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r)
+        checksum = fn(lines);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t allocs = g_allocations - allocsBefore;
+
+    double messages = static_cast<double>(lines.size()) * rounds;
+    printf("%-6s %-8s %10.1f MB/s %12.0f msg/s %10.2f allocs/msg\n",
+           workload, impl, bytes * rounds / seconds / 1e6, messages / seconds,
+           allocs / messages);
+    return checksum;
+}
+
+int main(int argc, char* argv[]) {
+    int K = 10000;
+    int rounds = 20;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-k" && i + 1 < argc) {
+            if (!parseInteger(argv[++i], K) || K < 1 || K > 10000) {
+                std::cerr << "ERROR: invalid -k value\n";
+                return 1;
+            }
+        } else if (arg == "-r" && i + 1 < argc) {
+            if (!parseInteger(argv[++i], rounds) || rounds < 1) {
+                std::cerr << "ERROR: invalid -r value\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [-k K] [-r rounds]\n";
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng(2024);
+    auto stateLines = makeStateLines(K, 50, rng);
+    auto putLines = makePutLines(K, 100000, rng);
+
+    printf("K = %d, %d rounds\n", K, rounds);
+    double a = runCase("STATE", "legacy", parseStateLegacy, stateLines, rounds);
+    double b = runCase("STATE", "current", parseStateCurrent, stateLines, rounds);
+    double c = runCase("PUT", "legacy", parsePutLegacy, putLines, rounds);
+    double d = runCase("PUT", "current", parsePutCurrent, putLines, rounds);
+
+    if (a != b || c != d) {
+        std::cerr << "ERROR: implementations disagree\n";
+        return 1;
+    }
+
+    // Enough PUTs per round to take a measurable time whatever K is.
+    Puts puts;
+    std::uniform_int_distribution<int> point(0, K);
+    std::uniform_real_distribution<double> value(-5.0, 5.0);
+    for (int i = std::max(200, 2000000 / (K + 1)); i > 0; --i)
+        puts.emplace_back(point(rng), value(rng));
+    runPutCycle("text", putCycleText, puts, K, rounds);
+    runPutCycle("binary", putCycleBinary, puts, K, rounds);
+    return 0;
+}
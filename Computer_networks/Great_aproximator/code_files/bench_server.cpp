@@ -0,0 +1,451 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "utils.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+#include "LineBuffer.hpp"
+
+/**
+ * approx-bench: measures accept rate and PUT latency of a running approx-server.
+ *
+ * Opens N connections at once (non-blocking connect), sends HELLO on each and waits
+ * for all COEFF replies. Then every client performs R PUT → STATE round trips,
+ * sending the next PUT as soon as the previous STATE arrives.
+ *
+ * By default player IDs contain no lowercase letters, so the server sends STATE without
+ * delay and the measured round trip is the server's processing latency. With -l L the IDs
+ * get L lowercase letters, STATE is delayed by L seconds, and the benchmark also reports
+ * how late the server's timers fired. Against a server started with -x S, pass the same
+ * -x S, so that the expected delay is L/S seconds.
+ *
+ * With -b the players negotiate binary frames (HELLO_BIN) instead of text lines. The
+ * benchmark reports the application bytes exchanged per PUT and its own CPU time per PUT;
+ * given the server's PID with -c, it reports the server's CPU time per PUT too.
+ *
+ * The same binary can be pointed at different server builds (e.g. the select-based
+ * and the epoll-based loop) to compare them on identical load.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/// Per-connection state of a simulated player.
+struct BenchClient {
+    int fd = -1;
+    bool connected = false;
+    bool gotCoeff = false;
+    int putsDone = 0;
+    LineBuffer input;
+    Clock::time_point sentAt;
+};
+
+/// Aggregated results of the benchmark.
+struct BenchStats {
+    std::vector<double> coeffLatencyUs;
+    std::vector<double> putLatencyUs;
+    int failedConnections = 0;
+    int badPuts = 0;
+    int penalties = 0;
+    bool scoring = false;
+    bool timedOut = false;
+    size_t bytesSent = 0;     ///< PUT bytes sent during the PUT phase.
+    size_t bytesReceived = 0; ///< Bytes received during the PUT phase.
+};
+
+/**
+ * @brief Parses command-line arguments of approx-bench.
+ *
+ * Supported options:
+ *   -s <server>   : Server address: host name, IP or unix:<path> (required)
+ *   -p <port>     : Server port (required unless the address is unix:<path>)
+ *   -n <clients>  : Number of concurrent clients, default 100
+ *   -r <puts>     : Number of PUT round trips per client, default 10
+ *   -l <letters>  : Number of lowercase letters in player IDs (STATE delay in seconds), default 0
+ *   -b            : Use binary frames instead of text lines
+ *   -c <pid>      : PID of the server, to report its CPU time per PUT
+ *   -x <scale>    : Time scale the server runs with (its -x option), default 1
+ *
+ * @return true if parsing succeeded, false otherwise.
+ */
+static bool parseBenchArgs(int argc, char* argv[],
+                           std::string &serverAddr, int &port, int &clients, int &rounds,
+                           int &lowercase, bool &binary, int &serverPid, double &timeScale)
+{
+    serverAddr.clear();
+    port = -1;
+    clients = 100;
+    rounds = 10;
+    lowercase = 0;
+    binary = false;
+    serverPid = 0;
+    timeScale = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-b") {
+            binary = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR: missing value after " << arg << "\n";
+            return false;
+        }
+        if (arg == "-s") {
+            serverAddr = argv[++i];
+        } else if (arg == "-p") {
+            if (!parseInteger(argv[++i], port) || port < 1 || port > 65535) {
+                std::cerr << "ERROR: invalid port (1–65535): " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "-n") {
+            if (!parseInteger(argv[++i], clients) || clients < 1) {
+                std::cerr << "ERROR: invalid number of clients: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "-r") {
+            if (!parseInteger(argv[++i], rounds) || rounds < 0) {
+                std::cerr << "ERROR: invalid number of rounds: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "-l") {
+            if (!parseInteger(argv[++i], lowercase) || lowercase < 0 || lowercase > 20) {
+                std::cerr << "ERROR: invalid number of lowercase letters (0–20): " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "-c") {
+            if (!parseInteger(argv[++i], serverPid) || serverPid < 1) {
+                std::cerr << "ERROR: invalid server PID: " << argv[i] << "\n";
+                return false;
+            }
+        } else if (arg == "-x") {
+            if (!parseReal(argv[++i], timeScale) || !(timeScale >= 1.0)) {
+                std::cerr << "ERROR: invalid time scale: " << argv[i] << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "ERROR: unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (serverAddr.empty() || (port < 1 && !isLocalAddress(serverAddr))) {
+        std::cerr << "Usage: " << argv[0] << " -s <server> -p <port> [-n <clients>] [-r <puts>] [-l <letters>] [-b] [-c <server_pid>] [-x <scale>]\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the value at the given percentile of a sorted sample.
+ */
+static double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+/**
+ * @brief Prints count, percentiles and maximum of a latency sample in microseconds.
+ */
+static void printLatency(const char *name, std::vector<double> &samples) {
+    std::sort(samples.begin(), samples.end());
+    std::printf("%-14s n=%-8zu p50=%10.1fus p99=%10.1fus max=%10.1fus\n",
+                name, samples.size(), percentile(samples, 0.50), percentile(samples, 0.99),
+                samples.empty() ? 0.0 : samples.back());
+}
+
+/**
+ * @brief Returns the CPU time (user + system) a process has used so far, in seconds.
+ *
+ * @param pid Process ID, or 0 for the benchmark itself.
+ * @return CPU seconds, or a negative value if /proc/<pid>/stat cannot be read.
+ */
+static double processCpuSeconds(int pid) {
+    if (pid == 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+             + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    }
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t end = stat.rfind(')'); // The command name may contain spaces.
+    if (end == std::string::npos) return -1.0;
+
+    // After the name: state, then 10 fields before utime and stime (fields 14 and 15).
+    std::istringstream fields(stat.substr(end + 2));
+    std::string skip;
+    for (int i = 0; i < 11; ++i) fields >> skip;
+    unsigned long utime = 0, stime = 0;
+    if (!(fields >> utime >> stime)) return -1.0;
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+/**
+ * @brief Sends the next PUT of the client and remembers when it was sent.
+ */
+static bool sendPut(BenchClient &c, bool binary, BenchStats &stats) {
+    c.sentAt = Clock::now();
+    std::string msg = binary ? makeBinaryPUT(0, 0.5) : makePUT(0, 0.5);
+    stats.bytesSent += msg.size();
+    return writeAll(c.fd, msg);
+}
+
+/**
+ * @brief Returns the type of a binary frame as its text message name.
+ */
+static std::string_view frameTypeName(std::string_view frame) {
+    FrameType type;
+    std::string_view payload;
+    if (!splitFrame(frame, type, payload)) return "";
+    switch (type) {
+        case FrameType::COEFF:   return "COEFF";
+        case FrameType::PUT:     return "PUT";
+        case FrameType::STATE:   return "STATE";
+        case FrameType::BAD_PUT: return "BAD_PUT";
+        case FrameType::PENALTY: return "PENALTY";
+        case FrameType::SCORING: return "SCORING";
+    }
+    return "";
+}
+
+/**
+ * @brief Handles a single message received by a client.
+ *
+ * @param type Message type (the first token of a line, or the type of a frame).
+ * @return true if the client finished all of its round trips with this message.
+ */
+static bool handleMessage(BenchClient &c, std::string_view type, int rounds, bool binary,
+                          BenchStats &stats)
+{
+
+    auto elapsedUs = std::chrono::duration<double, std::micro>(Clock::now() - c.sentAt).count();
+
+    if (type == "COEFF" && !c.gotCoeff) {
+        c.gotCoeff = true;
+        stats.coeffLatencyUs.push_back(elapsedUs);
+        return true;
+    }
+    if (type == "STATE") {
+        stats.putLatencyUs.push_back(elapsedUs);
+        ++c.putsDone;
+        if (c.putsDone >= rounds) return true;
+        if (!sendPut(c, binary, stats)) {
+            std::cerr << "ERROR: failed to send PUT\n";
+        }
+        return false;
+    }
+    if (type == "BAD_PUT") {
+        ++stats.badPuts;
+    } else if (type == "PENALTY") {
+        ++stats.penalties;
+    } else if (type == "SCORING") {
+        stats.scoring = true;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    std::string serverAddr;
+    int port, numClients, rounds, lowercase, serverPid;
+    bool binary;
+    double timeScale;
+    if (!parseBenchArgs(argc, argv, serverAddr, port, numClients, rounds, lowercase,
+                        binary, serverPid, timeScale)) {
+        return 1;
+    }
+
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    std::vector<SocketAddress> addresses;
+    if (!resolveServer(serverAddr, port, AF_UNSPEC, addresses)) return 1;
+    const SocketAddress &server = addresses.front();
+
+    int epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        std::cerr << "ERROR: epoll_create1(): " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::vector<BenchClient> clients(numClients);
+    BenchStats stats;
+
+    // Phase 1: open all connections at once, send HELLO and wait for COEFF.
+    auto phaseStart = Clock::now();
+    for (int i = 0; i < numClients; ++i) {
+        BenchClient &c = clients[i];
+        c.fd = socket(server.family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (c.fd < 0) {
+            std::cerr << "ERROR: socket(): " << strerror(errno) << "\n";
+            ++stats.failedConnections;
+            continue;
+        }
+        if (connect(c.fd, (const struct sockaddr*)&server.addr, server.length) < 0 &&
+            errno != EINPROGRESS) {
+            close(c.fd);
+            c.fd = -1;
+            ++stats.failedConnections;
+            continue;
+        }
+        struct epoll_event ev{};
+        ev.events   = EPOLLIN | EPOLLOUT;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    std::vector<struct epoll_event> events(1024);
+    int pending = numClients - stats.failedConnections;
+    bool inPutPhase = false;
+    Clock::time_point putPhaseStart;
+    double connectSeconds = 0.0;
+    double benchCpuStart = 0.0, serverCpuStart = 0.0;
+    const auto phaseTimeout = std::chrono::seconds(60);
+
+    while (pending > 0 && !stats.scoring) {
+        int ready = epoll_wait(epollFd, events.data(), events.size(), 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: epoll_wait(): " << strerror(errno) << "\n";
+            break;
+        }
+        if (Clock::now() - (inPutPhase ? putPhaseStart : phaseStart) > phaseTimeout) {
+            std::cerr << "ERROR: timed out with " << pending << " clients still waiting\n";
+            stats.timedOut = true;
+            break;
+        }
+
+        for (int e = 0; e < ready; ++e) {
+            BenchClient &c = clients[events[e].data.u32];
+            if (c.fd < 0) continue;
+
+            if (!c.connected && (events[e].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0) {
+                    close(c.fd);
+                    c.fd = -1;
+                    ++stats.failedConnections;
+                    --pending;
+                    continue;
+                }
+                c.connected = true;
+                struct epoll_event ev{};
+                ev.events   = EPOLLIN;
+                ev.data.u32 = events[e].data.u32;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+
+                c.sentAt = Clock::now();
+                writeAll(c.fd, makeHELLO("BOT" + std::to_string(events[e].data.u32)
+                                         + std::string(lowercase, 'x'), "", binary));
+            }
+
+            if (!(events[e].events & EPOLLIN)) continue;
+
+            LineBuffer::FillStatus status = c.input.fill(c.fd);
+            std::string_view msg;
+            bool invalid = false;
+            while (true) {
+                // Only the message type matters here, so the (possibly huge) STATE is
+                // neither tokenized nor decoded.
+                std::string_view type;
+                if (binary) {
+                    LineBuffer::FrameStatus frameStatus = c.input.nextFrame(msg);
+                    if (frameStatus != LineBuffer::FrameStatus::Complete) {
+                        invalid = frameStatus == LineBuffer::FrameStatus::Invalid;
+                        break;
+                    }
+                    type = frameTypeName(msg);
+                    if (inPutPhase) stats.bytesReceived += msg.size() + 4;
+                } else {
+                    if (!c.input.nextLine(msg)) break;
+                    type = msg.substr(0, msg.find(' '));
+                    if (inPutPhase) stats.bytesReceived += msg.size() + 2;
+                }
+                if (handleMessage(c, type, inPutPhase ? rounds : 0, binary, stats)) --pending;
+            }
+            if (status == LineBuffer::FillStatus::Closed || c.input.full() || invalid) {
+                close(c.fd);
+                c.fd = -1;
+                if (!(inPutPhase ? c.putsDone >= rounds : c.gotCoeff)) {
+                    ++stats.failedConnections;
+                    --pending;
+                }
+            }
+        }
+
+        // Phase 2: once every client has its COEFF, start the PUT round trips.
+        if (pending == 0 && !inPutPhase && rounds > 0) {
+            connectSeconds = std::chrono::duration<double>(Clock::now() - phaseStart).count();
+            inPutPhase = true;
+            putPhaseStart = Clock::now();
+            benchCpuStart = processCpuSeconds(0);
+            if (serverPid > 0) serverCpuStart = processCpuSeconds(serverPid);
+            for (auto &c : clients) {
+                if (c.fd >= 0 && c.gotCoeff) {
+                    if (sendPut(c, binary, stats)) ++pending;
+                }
+            }
+        }
+    }
+
+    double benchCpu = processCpuSeconds(0) - benchCpuStart;
+    double serverCpu = serverPid > 0 ? processCpuSeconds(serverPid) - serverCpuStart : 0.0;
+    double totalSeconds = std::chrono::duration<double>(Clock::now() - phaseStart).count();
+    if (!inPutPhase) connectSeconds = totalSeconds;
+    double putSeconds = inPutPhase
+        ? std::chrono::duration<double>(Clock::now() - putPhaseStart).count() : 0.0;
+
+    std::printf("clients=%d rounds=%d encoding=%s failed=%d bad_put=%d penalty=%d\n",
+                numClients, rounds, binary ? "binary" : "text",
+                stats.failedConnections, stats.badPuts, stats.penalties);
+    std::printf("accept rate    %.0f clients/s (%zu in %.3fs)\n",
+                connectSeconds > 0 ? stats.coeffLatencyUs.size() / connectSeconds : 0.0,
+                stats.coeffLatencyUs.size(), connectSeconds);
+    printLatency("HELLO->COEFF", stats.coeffLatencyUs);
+    std::printf("PUT throughput %.0f PUTs/s\n",
+                putSeconds > 0 ? stats.putLatencyUs.size() / putSeconds : 0.0);
+    printLatency("PUT->STATE", stats.putLatencyUs);
+    if (!stats.putLatencyUs.empty()) {
+        double puts = static_cast<double>(stats.putLatencyUs.size());
+        std::printf("wire bytes     %.1f B/PUT sent, %.1f B/PUT received\n",
+                    stats.bytesSent / puts, stats.bytesReceived / puts);
+        std::printf("CPU per PUT    bench %.2fus", benchCpu / puts * 1e6);
+        if (serverPid > 0) std::printf(", server %.2fus", serverCpu / puts * 1e6);
+        std::printf("\n");
+    }
+    if (lowercase > 0) {
+        // The server should send STATE exactly `lowercase` game seconds after the PUT.
+        const double expectedUs = lowercase * 1e6 / timeScale;
+        std::vector<double> lateness;
+        lateness.reserve(stats.putLatencyUs.size());
+        for (double us : stats.putLatencyUs) lateness.push_back(us - expectedUs);
+        printLatency("timer late by", lateness);
+    }
+    if (stats.scoring) {
+        std::cerr << "WARNING: the game ended during the benchmark, raise -m on the server\n";
+    }
+
+    for (auto &c : clients) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(epollFd);
+    return (stats.failedConnections > 0 || stats.scoring || stats.timedOut) ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include "binary_protocol.hpp"
+
+static_assert(sizeof(double) == 8, "binary frames carry IEEE 754 binary64 doubles");
+
+/// True if the host stores integers and doubles little-endian, i.e. like the wire.
+static constexpr bool HOST_LITTLE_ENDIAN = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+void appendLE(std::string &out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>(value & 0xff));
+        value >>= 8;
+    }
+}
+
+uint64_t readLE(const char *data, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+}
+
+static double readDouble(const char *data) {
+    uint64_t bits = readLE(data, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void writeBinaryDouble(char *out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<char>(bits & 0xff);
+        bits >>= 8;
+    }
+}
+
+static void appendDouble(std::string &out, double value) {
+    char bytes[8];
+    writeBinaryDouble(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Starts a frame: reserves the whole frame and writes its header.
+ */
+static std::string beginFrame(FrameType type, size_t payloadSize) {
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payloadSize);
+    appendLE(frame, 1 + payloadSize, 4);
+    frame.push_back(static_cast<char>(type));
+    return frame;
+}
+
+std::string makeFrame(FrameType type, std::string_view payload) {
+    std::string frame = beginFrame(type, payload.size());
+    frame.append(payload);
+    return frame;
+}
+
+std::string makeDoublesFrame(FrameType type, const std::vector<double> &values) {
+    const size_t payloadSize = values.size() * sizeof(double);
+    std::string frame = beginFrame(type, payloadSize);
+    if (HOST_LITTLE_ENDIAN) {
+        // The in-memory array already is the wire encoding.
+        frame.append(reinterpret_cast<const char*>(values.data()), payloadSize);
+    } else {
+        for (double v : values) appendDouble(frame, v);
+    }
+    return frame;
+}
+
+std::string makeBinaryPUT(int point, double value) {
+    std::string frame = beginFrame(FrameType::PUT, PUT_PAYLOAD_SIZE);
+    appendLE(frame, static_cast<uint32_t>(point), 4);
+    appendDouble(frame, value);
+    return frame;
+}
+
+std::string makeBinarySCORING(const std::vector<std::pair<std::string, double>> &scores) {
+    size_t payloadSize = 0;
+    for (auto &p : scores) payloadSize += 4 + p.first.size() + sizeof(double);
+
+    std::string frame = beginFrame(FrameType::SCORING, payloadSize);
+    for (auto &p : scores) {
+        appendLE(frame, p.first.size(), 4);
+        frame.append(p.first);
+        appendDouble(frame, p.second);
+    }
+    return frame;
+}
+
+bool splitFrame(std::string_view frame, FrameType &type, std::string_view &payload) {
+    if (frame.empty()) return false;
+    type = static_cast<FrameType>(static_cast<unsigned char>(frame[0]));
+    payload = frame.substr(1);
+    return true;
+}
+
+bool parseBinaryPUT(std::string_view payload, uint32_t &point, double &value) {
+    if (payload.size() != PUT_PAYLOAD_SIZE) return false;
+    point = static_cast<uint32_t>(readLE(payload.data(), 4));
+    value = readDouble(payload.data() + 4);
+    return true;
+}
+
+bool parseBinaryDoubles(std::string_view payload, std::vector<double> &out) {
+    if (payload.empty() || payload.size() % sizeof(double) != 0) return false;
+    out.resize(payload.size() / sizeof(double));
+    if (HOST_LITTLE_ENDIAN) {
+        std::memcpy(out.data(), payload.data(), payload.size());
+    } else {
+        for (size_t i = 0; i < out.size(); ++i)
+            out[i] = readDouble(payload.data() + i * sizeof(double));
+    }
+    return true;
+}
+
+bool parseBinarySCORING(std::string_view payload,
+                        std::vector<std::pair<std::string, double>> &outScores)
+{
+    outScores.clear();
+    while (!payload.empty()) {
+        if (payload.size() < 4) return false;
+        uint64_t idLen = readLE(payload.data(), 4);
+        payload.remove_prefix(4);
+        if (payload.size() < idLen + sizeof(double)) return false;
+        std::string id(payload.substr(0, idLen));
+        payload.remove_prefix(idLen);
+        outScores.emplace_back(std::move(id), readDouble(payload.data()));
+        payload.remove_prefix(sizeof(double));
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Binary framing of the game messages, negotiated by starting the connection with
+ * "HELLO_BIN <player_id> [<room_id>]\r\n" instead of HELLO. Everything after that line,
+ * in both directions, is a sequence of frames:
+ *
+ *   uint32 length   bytes that follow this field (1 + payload size)
+ *   uint8  type     FrameType
+ *   payload         depends on the type
+ *
+ * All integers and doubles are little-endian; doubles are raw IEEE 754 binary64, so
+ * values keep their full precision and nothing is formatted or parsed as text.
+ *
+ *   COEFF    a0 ... aN                 (N + 1 doubles)
+ *   PUT      uint32 point, double value
+ *   STATE    r0 ... rK                 (K + 1 doubles)
+ *   BAD_PUT  the payload of the rejected PUT, as received
+ *   PENALTY  the payload of the penalised PUT, as received
+ *   SCORING  per player: uint32 id length, id bytes, double score
+ */
+
+/// First token of the HELLO that switches the connection to binary frames.
+constexpr const char *HELLO_BINARY = "HELLO_BIN";
+
+/// Type byte of a binary frame.
+enum class FrameType : uint8_t {
+    COEFF   = 1,
+    PUT     = 2,
+    STATE   = 3,
+    BAD_PUT = 4,
+    PENALTY = 5,
+    SCORING = 6
+};
+
+/// Size of the length field and the type byte.
+constexpr size_t FRAME_HEADER_SIZE = 5;
+
+/// Size of a PUT payload (point and value).
+constexpr size_t PUT_PAYLOAD_SIZE = 12;
+
+/**
+ * @brief Appends the low `bytes` bytes of the value, least significant first.
+ */
+void appendLE(std::string &out, uint64_t value, int bytes);
+
+/**
+ * @brief Reads a little-endian integer of `bytes` bytes (the caller checks the size).
+ */
+uint64_t readLE(const char *data, int bytes);
+
+/**
+ * @brief Stores a double in wire format (8 bytes, little-endian) at the given address.
+ */
+void writeBinaryDouble(char *out, double value);
+
+/**
+ * @brief Constructs a frame with an arbitrary payload.
+ *
+ * @param type Frame type.
+ * @param payload Payload bytes.
+ * @return The complete frame, header included.
+ */
+std::string makeFrame(FrameType type, std::string_view payload);
+
+/**
+ * @brief Constructs a frame whose payload is a sequence of doubles (COEFF or STATE).
+ */
+std::string makeDoublesFrame(FrameType type, const std::vector<double> &values);
+
+/**
+ * @brief Constructs a binary PUT frame.
+ *
+ * @param point Integer point in the range 0..K.
+ * @param value Real value in the range [-5, 5].
+ */
+std::string makeBinaryPUT(int point, double value);
+
+/**
+ * @brief Constructs a binary SCORING frame.
+ *
+ * @param scores Pairs of player ID and score, in the order they should appear.
+ */
+std::string makeBinarySCORING(const std::vector<std::pair<std::string, double>> &scores);
+
+/**
+ * @brief Splits a frame returned by LineBuffer::nextFrame() into its type and payload.
+ *
+ * @return false if the frame is empty (it has no type byte).
+ */
+bool splitFrame(std::string_view frame, FrameType &type, std::string_view &payload);
+
+/**
+ * @brief Parses the payload of a binary PUT (or of BAD_PUT / PENALTY echoing it).
+ *
+ * Only the size is checked; the range of the point and value is up to the caller.
+ *
+ * @return false if the payload does not have PUT_PAYLOAD_SIZE bytes.
+ */
+bool parseBinaryPUT(std::string_view payload, uint32_t &point, double &value);
+
+/**
+ * @brief Parses a payload of doubles (COEFF or STATE).
+ *
+ * @param payload The frame payload.
+ * @param out Output values (its capacity is reused, so repeated calls do not allocate).
+ * @return false if the payload is empty or not a whole number of doubles.
+ */
+bool parseBinaryDoubles(std::string_view payload, std::vector<double> &out);
+
+/**
+ * @brief Parses the payload of a binary SCORING frame.
+ *
+ * @param payload The frame payload.
+ * @param outScores Output vector of (player_id, score) pairs.
+ * @return false if the payload is truncated.
+ */
+bool parseBinarySCORING(std::string_view payload,
+                        std::vector<std::pair<std::string, double>> &outScores);
@@ -34,11 +34,14 @@ static bool isAlnumString(const std::string &s) {
  *
  * Supported options:
  *   -u <id>       : Player ID (alphanumeric, required)
- *   -s <server>   : Server address (hostname or IP, required)
- *   -p <port>     : Server port (1–65535, required)
+ *   -s <server>   : Server address (hostname, IP or unix:<path>, required)
+ *   -p <port>     : Server port (1–65535, required unless the address is unix:<path>)
  *   -4            : Force IPv4 (optional)
  *   -6            : Force IPv6 (optional)
  *   -a            : Enable automatic mode (optional)
+ *   -r <room>     : Room ID to join (alphanumeric, optional)
+ *   -b            : Use binary frames instead of text (optional, requires -a)
+ *   -n <puts>     : PUT budget of the automatic strategy (optional, requires -a)
  *
  * @param argc Argument count.
  * @param argv Argument values.
@@ -48,6 +51,9 @@ static bool isAlnumString(const std::string &s) {
  * @param forceIPv4 Output: true if IPv4 is forced.
  * @param forceIPv6 Output: true if IPv6 is forced.
  * @param autoMode Output: true if auto mode is enabled.
+ * @param roomId Output: room ID (empty if not given).
+ * @param binary Output: true if binary frames are requested.
+ * @param budget Output: PUT budget (-1 if unlimited).
  * @return true if parsing succeeded, false otherwise.
  */
 static bool parseClientArgs(int argc, char* argv[],
@@ -56,7 +62,10 @@ static bool parseClientArgs(int argc, char* argv[],
                             int &port,
                             bool &forceIPv4,
                             bool &forceIPv6,
-                            bool &autoMode)
+                            bool &autoMode,
+                            std::string &roomId,
+                            bool &binary,
+                            long &budget)
 {
     playerId.clear();
     serverAddr.clear();
@@ -64,6 +73,9 @@ static bool parseClientArgs(int argc, char* argv[],
     forceIPv4 = false;
     forceIPv6 = false;
     autoMode = false;
+    roomId.clear();
+    binary = false;
+    budget = -1;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -107,6 +119,33 @@ static bool parseClientArgs(int argc, char* argv[],
         else if (arg == "-a") {
             autoMode = true;
         }
+        else if (arg == "-r") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing room ID after -r\n";
+                return false;
+            }
+            roomId = argv[++i];
+            if (!isAlnumString(roomId)) {
+                std::cerr << "ERROR: room ID must consist only of digits and letters: "
+                          << roomId << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-b") {
+            binary = true;
+        }
+        else if (arg == "-n") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing PUT budget after -n\n";
+                return false;
+            }
+            int tmp;
+            if (!parseInteger(argv[++i], tmp) || tmp < 1) {
+                std::cerr << "ERROR: invalid PUT budget (must be positive): " << argv[i] << "\n";
+                return false;
+            }
+            budget = tmp;
+        }
         else {
             std::cerr << "ERROR: unknown argument: " << arg << "\n";
             return false;
@@ -121,10 +160,18 @@ static bool parseClientArgs(int argc, char* argv[],
         std::cerr << "ERROR: missing required argument -s <server>\n";
         return false;
     }
-    if (port < 1) {
+    if (port < 1 && !isLocalAddress(serverAddr)) {
         std::cerr << "ERROR: missing required argument -p <port> (1–65535)\n";
         return false;
     }
+    if (binary && !autoMode) {
+        std::cerr << "ERROR: binary frames (-b) are only supported in automatic mode (-a)\n";
+        return false;
+    }
+    if (budget >= 0 && !autoMode) {
+        std::cerr << "ERROR: a PUT budget (-n) is only supported in automatic mode (-a)\n";
+        return false;
+    }
     return true;
 }
 
@@ -132,13 +179,14 @@ static bool parseClientArgs(int argc, char* argv[],
  * @brief Entry point for the approx-client program.
  */
 int main(int argc, char* argv[]) {
-    std::string playerId, serverAddr;
+    std::string playerId, serverAddr, roomId;
     int port;
-    bool forceIPv4, forceIPv6, autoMode;
+    bool forceIPv4, forceIPv6, autoMode, binary;
+    long budget;
 
     if (!parseClientArgs(argc, argv,
                          playerId, serverAddr, port,
-                         forceIPv4, forceIPv6, autoMode))
+                         forceIPv4, forceIPv6, autoMode, roomId, binary, budget))
     {
         // Error already reported inside parseClientArgs
         return 1;
@@ -150,8 +198,12 @@ int main(int argc, char* argv[]) {
               << ", port = "       << port
               << ", forceIPv4 = "  << (forceIPv4 ? "yes" : "no")
               << ", forceIPv6 = "  << (forceIPv6 ? "yes" : "no")
-              << ", autoMode = "   << (autoMode ? "yes" : "no") << "\n";
+              << ", autoMode = "   << (autoMode ? "yes" : "no")
+              << ", room = "       << (roomId.empty() ? "-" : roomId)
+              << ", binary = "     << (binary ? "yes" : "no")
+              << ", budget = "     << (budget < 0 ? "-" : std::to_string(budget)) << "\n";
 
-    runClient(playerId, serverAddr, port, forceIPv4, forceIPv6, autoMode);
+    runClient(playerId, serverAddr, port, forceIPv4, forceIPv6, autoMode, roomId, binary,
+              budget);
     return 0;
 }
\ No newline at end of file
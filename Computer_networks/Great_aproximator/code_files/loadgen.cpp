@@ -0,0 +1,581 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <optional>
+#include <tuple>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "utils.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+#include "LineBuffer.hpp"
+#include "LatencyHistogram.hpp"
+#include "Strategy.hpp"
+
+/**
+ * approx-loadgen: drives thousands of simulated players against a running approx-server
+ * from one process.
+ *
+ * Every bot is a non-blocking connection in one epoll loop, playing the same automatic
+ * strategy as `approx-client -a` (AutoStrategy). Optionally:
+ *   - the total PUT rate is capped (-R); by default every bot sends its next PUT as soon
+ *     as the STATE for the previous one arrives (closed loop),
+ *   - a fraction of the messages is malformed (-e): bad point, bad value, unparsable
+ *     PUT or unknown command, in turn,
+ *   - bots are disconnected and reconnected at a given rate (-c), which also exercises
+ *     HELLO → COEFF under load.
+ * A bot whose game ended (SCORING) or that was disconnected by the server reconnects.
+ *
+ * It prints the acknowledged PUT rate every second and, at the end, the server
+ * throughput and HELLO → COEFF / PUT → STATE latency percentiles.
+ *
+ * The server needs enough COEFF lines (`-o wrap` is simplest) and, for a steady load, a
+ * large `-m`. Bot IDs have no lowercase letters, so STATE is not delayed.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/// Command-line options of approx-loadgen.
+struct LoadOptions {
+    std::string serverAddr;
+    int port = -1;
+    int bots = 1000;
+    int seconds = 10;
+    double rate = 0.0;      ///< Total PUTs per second; 0 means closed loop.
+    double malformed = 0.0; ///< Fraction of messages that are malformed.
+    double churn = 0.0;     ///< Reconnects per second.
+    bool binary = false;
+};
+
+/**
+ * @brief Parses command-line arguments of approx-loadgen.
+ *
+ * Supported options:
+ *   -s <server>   : Server address: host name, IP or unix:<path> (required)
+ *   -p <port>     : Server port (required unless the address is unix:<path>)
+ *   -n <bots>     : Number of simulated players, default 1000
+ *   -d <seconds>  : Duration of the run, default 10
+ *   -R <puts/s>   : Total PUT rate cap, default 0 (closed loop)
+ *   -e <ratio>    : Fraction of malformed messages (0–1), default 0
+ *   -c <per sec>  : Reconnects per second (churn), default 0
+ *   -b            : Use binary frames instead of text lines
+ *
+ * @return true if parsing succeeded, false otherwise.
+ */
+static bool parseLoadArgs(int argc, char* argv[], LoadOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-b") {
+            opt.binary = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR: missing value after " << arg << "\n";
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "-s") {
+            opt.serverAddr = value;
+        } else if (arg == "-p") {
+            if (!parseInteger(value, opt.port) || opt.port < 1 || opt.port > 65535) {
+                std::cerr << "ERROR: invalid port (1–65535): " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-n") {
+            if (!parseInteger(value, opt.bots) || opt.bots < 1) {
+                std::cerr << "ERROR: invalid number of bots: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-d") {
+            if (!parseInteger(value, opt.seconds) || opt.seconds < 1) {
+                std::cerr << "ERROR: invalid duration: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-R") {
+            if (!parseReal(value, opt.rate) || opt.rate < 0) {
+                std::cerr << "ERROR: invalid PUT rate: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-e") {
+            if (!parseReal(value, opt.malformed) || opt.malformed < 0 || opt.malformed > 1) {
+                std::cerr << "ERROR: invalid malformed ratio (0–1): " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-c") {
+            if (!parseReal(value, opt.churn) || opt.churn < 0) {
+                std::cerr << "ERROR: invalid reconnect rate: " << value << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "ERROR: unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (opt.serverAddr.empty() || (opt.port < 1 && !isLocalAddress(opt.serverAddr))) {
+        std::cerr << "Usage: " << argv[0] << " -s <server> -p <port> [-n <bots>] [-d <seconds>]"
+                  << " [-R <puts/s>] [-e <ratio>] [-c <reconnects/s>] [-b]\n";
+        return false;
+    }
+    return true;
+}
+
+/// Where a bot is in its connection.
+enum class BotPhase {
+    Idle,       ///< Not connected (waiting to reconnect).
+    Connecting, ///< Non-blocking connect in progress.
+    WaitCoeff,  ///< HELLO sent.
+    Playing     ///< COEFF received; sending PUTs.
+};
+
+/// One simulated player.
+struct Bot {
+    int fd = -1;
+    BotPhase phase = BotPhase::Idle;
+    uint32_t generation = 0; ///< Bumped on every (re)connect; older events and timers are stale.
+    LineBuffer input;
+    std::vector<double> coeffs;
+    std::optional<AutoStrategy> strategy;
+    int K = -1;              ///< Maximum point index, once known from STATE.
+    bool awaitingState = false;
+    Clock::time_point helloAt;
+    Clock::time_point putAt;
+};
+
+/// Aggregated results of the run.
+struct LoadStats {
+    LatencyHistogram coeffLatency;
+    LatencyHistogram putLatency;
+    uint64_t putsSent = 0;
+    uint64_t putsAcked = 0;   ///< PUTs answered by STATE.
+    uint64_t malformedSent = 0;
+    uint64_t badPuts = 0;
+    uint64_t penalties = 0;
+    uint64_t games = 0;       ///< SCORING messages received.
+    uint64_t reconnects = 0;  ///< Churn reconnects.
+    uint64_t disconnects = 0; ///< Connections closed by the server.
+    uint64_t connectFailures = 0;
+};
+
+/**
+ * @brief The bots, their event loop and their timers.
+ */
+class LoadGenerator {
+public:
+    LoadGenerator(const LoadOptions &options, const SocketAddress &server, int epollFd)
+        : opt(options), server(server), epollFd(epollFd), bots(options.bots), rng(std::random_device{}())
+    {
+        if (opt.rate > 0) putInterval = std::chrono::duration<double>(opt.bots / opt.rate);
+    }
+
+    /**
+     * @brief Connects all bots and runs the load for the configured duration.
+     */
+    void run();
+
+    /// Results of the run.
+    const LoadStats &stats() const { return total; }
+
+private:
+    /// What a bot's timer is for.
+    enum class TimerAction { Put, Reconnect };
+
+    struct Timer {
+        Clock::time_point at;
+        uint32_t bot;
+        uint32_t generation;
+        TimerAction action;
+        bool operator>(const Timer &other) const { return at > other.at; }
+    };
+
+    void connectBot(uint32_t index);
+    void closeBot(uint32_t index);
+    void reconnectLater(uint32_t index);
+    void schedule(uint32_t index, Clock::time_point at, TimerAction action);
+    void handleEvent(uint32_t index, uint32_t events);
+    bool handleMessage(uint32_t index, std::string_view msg);
+    void sendNext(uint32_t index);
+    void afterState(uint32_t index);
+    void runTimers(Clock::time_point now);
+    void churnOne();
+
+    const LoadOptions &opt;
+    const SocketAddress &server;
+    const int epollFd;
+    std::vector<Bot> bots;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::mt19937_64 rng;
+    std::chrono::duration<double> putInterval{0}; ///< Per-bot PUT interval with -R.
+    uint64_t malformedKind = 0;
+    LoadStats total;
+};
+
+void LoadGenerator::schedule(uint32_t index, Clock::time_point at, TimerAction action) {
+    timers.push({at, index, bots[index].generation, action});
+}
+
+void LoadGenerator::connectBot(uint32_t index) {
+    Bot &b = bots[index];
+    ++b.generation;
+    b.phase = BotPhase::Connecting;
+    b.input = LineBuffer();
+    b.strategy.reset();
+    b.K = -1;
+    b.awaitingState = false;
+
+    b.fd = socket(server.family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (b.fd < 0 ||
+        (connect(b.fd, (const struct sockaddr*)&server.addr, server.length) < 0 &&
+         errno != EINPROGRESS)) {
+        ++total.connectFailures;
+        closeBot(index);
+        reconnectLater(index);
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events   = EPOLLOUT;
+    ev.data.u64 = (uint64_t(b.generation) << 32) | index;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, b.fd, &ev);
+}
+
+void LoadGenerator::closeBot(uint32_t index) {
+    Bot &b = bots[index];
+    if (b.fd >= 0) close(b.fd);
+    b.fd = -1;
+    b.phase = BotPhase::Idle;
+}
+
+void LoadGenerator::reconnectLater(uint32_t index) {
+    // A short pause keeps a refusing server from turning into a reconnect storm.
+    schedule(index, Clock::now() + std::chrono::milliseconds(100), TimerAction::Reconnect);
+}
+
+/**
+ * @brief Returns a malformed message; the kinds rotate so each is exercised equally.
+ */
+static std::string makeMalformed(uint64_t kind, bool binary) {
+    switch (kind % 4) {
+        // Point -1 is invalid for any K (and 0xFFFFFFFF in a binary PUT).
+        case 0:  return binary ? makeBinaryPUT(-1, 1.0) : makePUT(-1, 1.0);
+        case 1:  return binary ? makeBinaryPUT(0, 99.0) : makePUT(0, 99.0);
+        case 2:  return binary ? makeFrame(FrameType::PUT, "abc") : std::string("PUT x y") + CRLF;
+        default: return binary ? makeFrame(static_cast<FrameType>(0x7f), "")
+                               : std::string("JUNK 1 2") + CRLF;
+    }
+}
+
+void LoadGenerator::sendNext(uint32_t index) {
+    Bot &b = bots[index];
+    if (b.phase != BotPhase::Playing || b.awaitingState) return;
+
+    if (opt.malformed > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < opt.malformed) {
+        if (!writeAll(b.fd, makeMalformed(malformedKind++, opt.binary))) return;
+        ++total.malformedSent;
+        if (opt.rate > 0) {
+            schedule(index, Clock::now()
+                     + std::chrono::duration_cast<Clock::duration>(putInterval), TimerAction::Put);
+            return;
+        }
+    }
+
+    auto [point, value] = b.strategy->nextPut();
+    if (point < 0) {
+        // The polynomial is done; play it again so the bot keeps producing load.
+        b.strategy.emplace(b.coeffs);
+        b.strategy->setK(b.K);
+        std::tie(point, value) = b.strategy->nextPut();
+    }
+    b.putAt = Clock::now();
+    if (!writeAll(b.fd, opt.binary ? makeBinaryPUT(point, value) : makePUT(point, value))) return;
+    b.awaitingState = true;
+    ++total.putsSent;
+}
+
+void LoadGenerator::afterState(uint32_t index) {
+    if (opt.rate <= 0) {
+        sendNext(index);
+        return;
+    }
+    Bot &b = bots[index];
+    schedule(index, std::max(Clock::now(),
+                             b.putAt + std::chrono::duration_cast<Clock::duration>(putInterval)),
+             TimerAction::Put);
+}
+
+/**
+ * @brief Handles one message (a line, or a frame in binary mode) received by a bot.
+ *
+ * @return false if the bot was closed.
+ */
+bool LoadGenerator::handleMessage(uint32_t index, std::string_view msg) {
+    static std::vector<std::string_view> tokens;
+    Bot &b = bots[index];
+    auto now = Clock::now();
+
+    std::string_view type, payload;
+    FrameType frameType{};
+    if (opt.binary) {
+        if (!splitFrame(msg, frameType, payload)) return true;
+    } else {
+        type = msg.substr(0, msg.find(' '));
+    }
+    auto is = [&](FrameType t, const char *name) {
+        return opt.binary ? frameType == t : type == name;
+    };
+
+    if (is(FrameType::COEFF, "COEFF") && b.phase == BotPhase::WaitCoeff) {
+        bool ok;
+        if (opt.binary) {
+            ok = parseBinaryDoubles(payload, b.coeffs);
+        } else {
+            splitBySpace(msg, tokens);
+            ok = parseCOEFF(tokens, b.coeffs);
+        }
+        if (!ok) {
+            std::cerr << "ERROR: invalid COEFF received by bot " << index << "\n";
+            closeBot(index);
+            reconnectLater(index);
+            return false;
+        }
+        total.coeffLatency.record(now - b.helloAt);
+        b.strategy.emplace(b.coeffs);
+        b.phase = BotPhase::Playing;
+        if (opt.rate > 0) {
+            // Spread the first PUTs over one interval instead of sending them all at once.
+            auto delay = putInterval * std::uniform_real_distribution<double>(0, 1)(rng);
+            schedule(index, now + std::chrono::duration_cast<Clock::duration>(delay),
+                     TimerAction::Put);
+        } else {
+            sendNext(index);
+        }
+    } else if (is(FrameType::STATE, "STATE")) {
+        if (b.K < 0) {
+            // Only the first STATE is decoded: the strategy needs K.
+            if (opt.binary) {
+                b.K = static_cast<int>(payload.size() / sizeof(double)) - 1;
+            } else {
+                splitBySpace(msg, tokens);
+                b.K = static_cast<int>(tokens.size()) - 2;
+            }
+            b.strategy->setK(b.K);
+        }
+        if (b.awaitingState) {
+            b.awaitingState = false;
+            total.putLatency.record(now - b.putAt);
+            ++total.putsAcked;
+            afterState(index);
+        }
+    } else if (is(FrameType::BAD_PUT, "BAD_PUT")) {
+        ++total.badPuts;
+    } else if (is(FrameType::PENALTY, "PENALTY")) {
+        ++total.penalties;
+    } else if (is(FrameType::SCORING, "SCORING")) {
+        ++total.games;
+        closeBot(index);
+        connectBot(index);
+        return false;
+    }
+    return true;
+}
+
+void LoadGenerator::handleEvent(uint32_t index, uint32_t events) {
+    Bot &b = bots[index];
+
+    if (b.phase == BotPhase::Connecting) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(b.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+            ++total.connectFailures;
+            closeBot(index);
+            reconnectLater(index);
+            return;
+        }
+        struct epoll_event ev{};
+        ev.events   = EPOLLIN;
+        ev.data.u64 = (uint64_t(b.generation) << 32) | index;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, b.fd, &ev);
+
+        b.phase = BotPhase::WaitCoeff;
+        b.helloAt = Clock::now();
+        writeAll(b.fd, makeHELLO("LG" + std::to_string(index), "", opt.binary));
+        return;
+    }
+
+    LineBuffer::FillStatus status = b.input.fill(b.fd);
+    std::string_view msg;
+    while (true) {
+        if (opt.binary) {
+            LineBuffer::FrameStatus frameStatus = b.input.nextFrame(msg);
+            if (frameStatus == LineBuffer::FrameStatus::Invalid) {
+                status = LineBuffer::FillStatus::Closed;
+                break;
+            }
+            if (frameStatus != LineBuffer::FrameStatus::Complete) break;
+        } else if (!b.input.nextLine(msg)) {
+            break;
+        }
+        if (!handleMessage(index, msg)) return;
+    }
+    if (status == LineBuffer::FillStatus::Closed || b.input.full()) {
+        ++total.disconnects;
+        closeBot(index);
+        reconnectLater(index);
+    }
+}
+
+void LoadGenerator::runTimers(Clock::time_point now) {
+    while (!timers.empty() && timers.top().at <= now) {
+        Timer t = timers.top();
+        timers.pop();
+        if (bots[t.bot].generation != t.generation) continue;
+        if (t.action == TimerAction::Put) {
+            sendNext(t.bot);
+        } else if (bots[t.bot].phase == BotPhase::Idle) {
+            connectBot(t.bot);
+        }
+    }
+}
+
+void LoadGenerator::churnOne() {
+    std::uniform_int_distribution<uint32_t> pick(0, bots.size() - 1);
+    // A few tries to find a bot in game; churning a connecting bot would measure nothing.
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        uint32_t index = pick(rng);
+        if (bots[index].phase != BotPhase::Playing) continue;
+        closeBot(index);
+        connectBot(index);
+        ++total.reconnects;
+        return;
+    }
+}
+
+void LoadGenerator::run() {
+    for (uint32_t i = 0; i < bots.size(); ++i) connectBot(i);
+
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::seconds(opt.seconds);
+    auto nextReport = start + std::chrono::seconds(1);
+    auto churnInterval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(opt.churn > 0 ? 1.0 / opt.churn : 0.0));
+    auto nextChurn = start + churnInterval;
+    uint64_t ackedAtReport = 0;
+
+    std::vector<struct epoll_event> events(1024);
+    while (true) {
+        auto now = Clock::now();
+        if (now >= end) break;
+
+        auto wakeAt = std::min(end, nextReport);
+        if (!timers.empty()) wakeAt = std::min(wakeAt, timers.top().at);
+        if (opt.churn > 0) wakeAt = std::min(wakeAt, nextChurn);
+        auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            wakeAt - now + std::chrono::microseconds(999)).count();
+
+        int ready = epoll_wait(epollFd, events.data(), events.size(), static_cast<int>(waitMs));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: epoll_wait(): " << strerror(errno) << "\n";
+            return;
+        }
+        for (int e = 0; e < ready; ++e) {
+            uint32_t index = static_cast<uint32_t>(events[e].data.u64);
+            uint32_t generation = static_cast<uint32_t>(events[e].data.u64 >> 32);
+            if (bots[index].generation != generation || bots[index].fd < 0) continue;
+            handleEvent(index, events[e].events);
+        }
+
+        now = Clock::now();
+        runTimers(now);
+        while (opt.churn > 0 && nextChurn <= now) {
+            churnOne();
+            nextChurn += churnInterval;
+        }
+        if (now >= nextReport) {
+            int playing = 0;
+            for (const Bot &b : bots) playing += b.phase == BotPhase::Playing;
+            std::printf("[%3lds] %9.0f PUTs/s  %d/%zu bots playing\n",
+                        static_cast<long>(std::chrono::duration_cast<std::chrono::seconds>(
+                            nextReport - start).count()),
+                        static_cast<double>(total.putsAcked - ackedAtReport),
+                        playing, bots.size());
+            std::fflush(stdout);
+            ackedAtReport = total.putsAcked;
+            nextReport += std::chrono::seconds(1);
+        }
+    }
+
+    for (uint32_t i = 0; i < bots.size(); ++i) closeBot(i);
+}
+
+/**
+ * @brief Prints count and percentiles of a latency histogram in microseconds.
+ */
+static void printLatency(const char *name, const LatencyHistogram &h) {
+    std::printf("%-14s n=%-9llu p50=%9.1fus p99=%9.1fus p999=%9.1fus max=%9.1fus\n",
+                name, static_cast<unsigned long long>(h.count()),
+                h.percentile(0.50) / 1e3, h.percentile(0.99) / 1e3,
+                h.percentile(0.999) / 1e3, h.max() / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions opt;
+    if (!parseLoadArgs(argc, argv, opt)) {
+        return 1;
+    }
+
+    // The server closes bots at the end of a game; writing to them must not kill us.
+    signal(SIGPIPE, SIG_IGN);
+
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    std::vector<SocketAddress> addresses;
+    if (!resolveServer(opt.serverAddr, opt.port, AF_UNSPEC, addresses)) return 1;
+
+    int epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        std::cerr << "ERROR: epoll_create1(): " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    LoadGenerator generator(opt, addresses.front(), epollFd);
+    generator.run();
+    const LoadStats &s = generator.stats();
+
+    std::printf("bots=%d duration=%ds encoding=%s malformed=%.3f churn=%.1f/s ",
+                opt.bots, opt.seconds, opt.binary ? "binary" : "text", opt.malformed, opt.churn);
+    if (opt.rate > 0) std::printf("rate=%.0f PUTs/s\n", opt.rate);
+    else std::printf("rate=closed-loop\n");
+    std::printf("PUT throughput %.0f PUTs/s (%llu answered by STATE of %llu sent, %llu malformed)\n",
+                s.putsAcked / static_cast<double>(opt.seconds),
+                static_cast<unsigned long long>(s.putsAcked),
+                static_cast<unsigned long long>(s.putsSent),
+                static_cast<unsigned long long>(s.malformedSent));
+    std::printf("bad_put=%llu penalty=%llu games=%llu reconnects=%llu disconnects=%llu connect_failures=%llu\n",
+                static_cast<unsigned long long>(s.badPuts),
+                static_cast<unsigned long long>(s.penalties),
+                static_cast<unsigned long long>(s.games),
+                static_cast<unsigned long long>(s.reconnects),
+                static_cast<unsigned long long>(s.disconnects),
+                static_cast<unsigned long long>(s.connectFailures));
+    printLatency("HELLO->COEFF", s.coeffLatency);
+    printLatency("PUT->STATE", s.putLatency);
+
+    close(epollFd);
+    return 0;
+}
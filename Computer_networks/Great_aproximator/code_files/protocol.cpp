@@ -1,50 +1,40 @@
 #include "protocol.hpp"
-#include <cstdlib>      // std::strtod
+#include "utils.hpp"
 #include <utility>      // std::pair
 
-bool parseCOEFF(const std::vector<std::string> &tokens, std::vector<double> &outCoeffs) {
+bool parseCOEFF(const std::vector<std::string_view> &tokens, std::vector<double> &outCoeffs) {
     if (tokens.empty() || tokens[0] != "COEFF")
         return false;
 
     outCoeffs.clear();
     for (size_t i = 1; i < tokens.size(); ++i) {
-        try {
-            size_t pos;
-            double val = std::stod(tokens[i], &pos);
-            if (pos != tokens[i].size())
-                return false;
-            outCoeffs.push_back(val);
-        } catch (...) {
+        double val;
+        if (!parseReal(tokens[i], val))
             return false;
-        }
+        outCoeffs.push_back(val);
     }
 
     // COEFF must contain at least one coefficient
     return !outCoeffs.empty();
 }
 
-bool parseSTATE(const std::vector<std::string> &tokens, std::vector<double> &outState) {
+bool parseSTATE(const std::vector<std::string_view> &tokens, std::vector<double> &outState) {
     if (tokens.empty() || tokens[0] != "STATE")
         return false;
 
     outState.clear();
     for (size_t i = 1; i < tokens.size(); ++i) {
-        try {
-            size_t pos;
-            double val = std::stod(tokens[i], &pos);
-            if (pos != tokens[i].size())
-                return false;
-            outState.push_back(val);
-        } catch (...) {
+        double val;
+        if (!parseReal(tokens[i], val))
             return false;
-        }
+        outState.push_back(val);
     }
 
     // STATE must contain at least one value
     return !outState.empty();
 }
 
-bool parseSCORING(const std::vector<std::string> &tokens, std::vector<std::pair<std::string,double>> &outScores) {
+bool parseSCORING(const std::vector<std::string_view> &tokens, std::vector<std::pair<std::string,double>> &outScores) {
     if (tokens.empty() || tokens[0] != "SCORING")
         return false;
 
@@ -54,16 +44,10 @@ bool parseSCORING(const std::vector<std::string> &tokens, std::vector<std::pair<
 
     outScores.clear();
     for (size_t i = 1; i + 1 < tokens.size(); i += 2) {
-        const std::string &id = tokens[i];
-        try {
-            size_t pos;
-            double score = std::stod(tokens[i + 1], &pos);
-            if (pos != tokens[i + 1].size())
-                return false;
-            outScores.emplace_back(id, score);
-        } catch (...) {
+        double score;
+        if (!parseReal(tokens[i + 1], score))
             return false;
-        }
+        outScores.emplace_back(std::string(tokens[i]), score);
     }
 
     return !outScores.empty();
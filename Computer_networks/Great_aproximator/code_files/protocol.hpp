@@ -1,8 +1,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "binary_protocol.hpp"
+
 /**
  * @brief Constant for CRLF line terminator used in protocol.
  */
@@ -11,13 +15,20 @@ static const char *CRLF = "\r\n";
 /**
  * @brief Constructs a HELLO message.
  *
- * Format: "HELLO <player_id>\r\n"
+ * Format: "HELLO <player_id> [<room_id>]\r\n", or "HELLO_BIN ..." to switch the rest of
+ * the connection to binary frames (see binary_protocol.hpp).
  *
  * @param playerId The player's identifier.
+ * @param roomId The room to join; empty to let the server place the player.
+ * @param binary Whether to negotiate binary frames.
  * @return Constructed HELLO message.
  */
-inline std::string makeHELLO(const std::string &playerId) {
-    return "HELLO " + playerId + std::string(CRLF);
+inline std::string makeHELLO(const std::string &playerId, const std::string &roomId = "",
+                             bool binary = false) {
+    std::string msg = binary ? HELLO_BINARY : "HELLO";
+    msg.append(" ").append(playerId);
+    if (!roomId.empty()) msg.append(" ").append(roomId);
+    return msg + CRLF;
 }
 
 /**
@@ -33,6 +44,23 @@ inline std::string makePUT(int point, double value) {
     return "PUT " + std::to_string(point) + " " + std::to_string(value) + std::string(CRLF);
 }
 
+/**
+ * @brief Constructs a SCORING message.
+ *
+ * Format: "SCORING <player_id> <score> <player_id> <score> ...\r\n"
+ *
+ * @param scores Pairs of player ID and score, in the order they should appear.
+ * @return Constructed SCORING message.
+ */
+inline std::string makeSCORING(const std::vector<std::pair<std::string, double>> &scores) {
+    std::string msg = "SCORING";
+    for (auto &p : scores) {
+        msg.append(" ").append(p.first).append(" ").append(std::to_string(p.second));
+    }
+    msg += CRLF;
+    return msg;
+}
+
 /**
  * @brief Parses a COEFF message.
  *
@@ -42,7 +70,7 @@ inline std::string makePUT(int point, double value) {
  * @param outCoeffs Output vector of parsed coefficients.
  * @return true if parsing succeeded, false otherwise.
  */
-bool parseCOEFF(const std::vector<std::string> &tokens, std::vector<double> &outCoeffs);
+bool parseCOEFF(const std::vector<std::string_view> &tokens, std::vector<double> &outCoeffs);
 
 /**
  * @brief Parses a STATE message.
@@ -50,10 +78,11 @@ bool parseCOEFF(const std::vector<std::string> &tokens, std::vector<double> &out
  * Format: "STATE <r0> <r1> ... <rK>"
  *
  * @param tokens The tokenized message (including "STATE" as tokens[0]).
- * @param outState Output vector of state values.
+ * @param outState Output vector of state values (its capacity is reused, so parsing
+ *                 repeated STATE messages into the same vector does not allocate).
  * @return true if parsing succeeded, false otherwise.
  */
-bool parseSTATE(const std::vector<std::string> &tokens, std::vector<double> &outState);
+bool parseSTATE(const std::vector<std::string_view> &tokens, std::vector<double> &outState);
 
 /**
  * @brief Parses a SCORING message.
@@ -64,4 +93,4 @@ bool parseSTATE(const std::vector<std::string> &tokens, std::vector<double> &out
  * @param outScores Output vector of (player_id, score) pairs.
  * @return true if parsing succeeded, false otherwise.
  */
-bool parseSCORING(const std::vector<std::string> &tokens, std::vector<std::pair<std::string,double>> &outScores);
+bool parseSCORING(const std::vector<std::string_view> &tokens, std::vector<std::pair<std::string,double>> &outScores);
@@ -0,0 +1,596 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "utils.hpp"
+#include "binary_protocol.hpp"
+#include "protocol.hpp"
+#include "LineBuffer.hpp"
+#include "Trace.hpp"
+
+/**
+ * approx-replay: feeds a traffic trace recorded with `approx-server -w` to a server and
+ * compares the server's replies with the recorded ones.
+ *
+ * Every recorded connection is replayed on its own non-blocking connection, all in one
+ * epoll loop. A client message is sent once the replies that preceded it in the trace
+ * have arrived, so a PUT never overtakes the STATE it originally waited for; otherwise
+ * messages go out as fast as the server answers, or at their recorded times with -P.
+ * Likewise a connection is opened once as many replies have been settled in total
+ * (received, given up on, or owed by a finished connection) as had been sent when it
+ * was accepted, so players reach matchmaking in about the recorded order. If an
+ * awaited reply does not come within the stall timeout (-T), the replay goes on
+ * without it.
+ *
+ * Every reply is compared (by size and hash, see TraceReply) with the recorded reply
+ * at the same position of its connection. Replies depend on the server's COEFF file and on how the players'
+ * messages interleave, so identical replies are expected when the server starts
+ * fresh with the same options and the trace was recorded at the same pacing.
+ *
+ * The exit status is 0 if every reply matched, 1 on errors and 2 on divergence.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/// Command-line options of approx-replay.
+struct ReplayOptions {
+    std::string serverAddr;
+    int port = -1;
+    std::string tracePath;
+    bool paced = false;  ///< Keep the recorded pacing instead of replaying at full speed.
+    int stallSeconds = 10;
+};
+
+/**
+ * @brief Parses command-line arguments of approx-replay.
+ *
+ * Supported options:
+ *   -s <server>   : Server address: host name, IP or unix:<path> (required)
+ *   -p <port>     : Server port (required unless the address is unix:<path>)
+ *   -f <file>     : Trace recorded with approx-server -w (required)
+ *   -P            : Send messages at their recorded times (default: as fast as possible)
+ *   -T <seconds>  : Stall timeout for an awaited reply, default 10
+ *
+ * @return true if parsing succeeded, false otherwise.
+ */
+static bool parseReplayArgs(int argc, char* argv[], ReplayOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-P") {
+            opt.paced = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "ERROR: missing value after " << arg << "\n";
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "-s") {
+            opt.serverAddr = value;
+        } else if (arg == "-p") {
+            if (!parseInteger(value, opt.port) || opt.port < 1 || opt.port > 65535) {
+                std::cerr << "ERROR: invalid port (1–65535): " << value << "\n";
+                return false;
+            }
+        } else if (arg == "-f") {
+            opt.tracePath = value;
+        } else if (arg == "-T") {
+            if (!parseInteger(value, opt.stallSeconds) || opt.stallSeconds < 1) {
+                std::cerr << "ERROR: invalid stall timeout: " << value << "\n";
+                return false;
+            }
+        } else {
+            std::cerr << "ERROR: unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (opt.serverAddr.empty() || (opt.port < 1 && !isLocalAddress(opt.serverAddr)) ||
+        opt.tracePath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " -s <server> -p <port> -f <trace> [-P] [-T <seconds>]\n";
+        return false;
+    }
+    return true;
+}
+
+/// A client message (or the client's close) to replay.
+struct Step {
+    TraceKind kind;            ///< Line, Frame or Close.
+    std::string_view payload;  ///< The message, as recorded.
+    uint64_t time;             ///< Recorded time, ns after the first record.
+    size_t repliesBefore;      ///< Replies recorded on the connection before this step.
+};
+
+/**
+ * @brief A recorded connection and its replay.
+ */
+struct Connection {
+    uint32_t id = 0;
+    uint64_t openTime = 0;                ///< Recorded time of the accept.
+    size_t repliesBeforeOpen = 0;         ///< Replies recorded on all connections before the accept.
+    std::vector<Step> steps;
+    std::vector<TraceReply> replies;      ///< Recorded replies.
+
+    int fd = -1;
+    bool connected = false;
+    bool binary = false;                  ///< HELLO_BIN was sent: replies are frames.
+    bool finished = false;
+    size_t nextStep = 0;
+    size_t received = 0;                  ///< Replies received so far.
+    Clock::time_point progressAt;         ///< Last send or receive.
+    LineBuffer input;
+};
+
+/// Results of a replay.
+struct ReplayStats {
+    uint64_t sent = 0;       ///< Client messages sent.
+    uint64_t expected = 0;   ///< Replies in the trace.
+    uint64_t received = 0;
+    uint64_t identical = 0;
+    uint64_t different = 0;
+    uint64_t unexpected = 0; ///< Replies beyond the recorded ones.
+    uint64_t stalls = 0;     ///< Awaited replies given up on.
+    uint64_t unsent = 0;     ///< Steps left when the server closed the connection.
+    uint64_t connectFailures = 0;
+    std::vector<std::string> examples; ///< First differences, for the report.
+};
+
+/// Number of differences printed in the report.
+static const size_t MAX_EXAMPLES = 5;
+
+/**
+ * @brief Reads a whole file into memory.
+ */
+static bool readFile(const std::string &path, std::string &out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "ERROR: cannot open trace file: " << path << "\n";
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    out = contents.str();
+    return true;
+}
+
+/**
+ * @brief Splits a trace into connections, ordering each one's records by time.
+ */
+static bool loadTrace(const std::string &data, std::vector<Connection> &connections) {
+    std::string_view rest = data;
+    if (rest.substr(0, TRACE_MAGIC.size()) != TRACE_MAGIC) {
+        std::cerr << "ERROR: not a trace file (or an unsupported version)\n";
+        return false;
+    }
+    rest.remove_prefix(TRACE_MAGIC.size());
+
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (nextTraceRecord(rest, record)) records.push_back(record);
+    if (!rest.empty()) {
+        std::cerr << "WARNING: ignoring " << rest.size() << " bytes of a truncated record\n";
+    }
+    // Shards write in batches; a stable sort keeps the order of equal times.
+    std::stable_sort(records.begin(), records.end(),
+                     [](const TraceRecord &a, const TraceRecord &b){ return a.time < b.time; });
+
+    uint64_t origin = records.empty() ? 0 : records.front().time;
+    size_t replies = 0;
+    std::unordered_map<uint32_t, size_t> index;
+    for (const TraceRecord &r : records) {
+        auto inserted = index.emplace(r.connection, connections.size());
+        if (inserted.second) {
+            connections.emplace_back();
+            connections.back().id = r.connection;
+            connections.back().openTime = r.time - origin;
+            connections.back().repliesBeforeOpen = replies;
+        }
+        Connection &c = connections[inserted.first->second];
+        switch (r.kind) {
+            case TraceKind::Open:
+                c.openTime = r.time - origin;
+                break;
+            case TraceKind::Reply: {
+                TraceReply reply;
+                if (!parseTraceReply(r.payload, reply)) {
+                    std::cerr << "ERROR: malformed reply record\n";
+                    return false;
+                }
+                c.replies.push_back(reply);
+                ++replies;
+                break;
+            }
+            default:
+                c.steps.push_back({r.kind, r.payload, r.time - origin, c.replies.size()});
+                break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Restores the framing ("\r\n" or the length field) LineBuffer stripped from
+ *        a received reply, giving the message as the server sent it.
+ */
+static void reframe(std::string_view msg, bool binary, std::string &out) {
+    out.clear();
+    if (binary) {
+        appendLE(out, msg.size(), 4);
+        out.append(msg);
+    } else {
+        out.append(msg);
+        out.append(CRLF);
+    }
+}
+
+/**
+ * @brief Strips the framing from the start of a recorded reply, for reports.
+ */
+static std::string_view unframe(const TraceReply &reply, bool binary) {
+    std::string_view prefix = reply.prefix;
+    if (binary) return prefix.size() >= 4 ? prefix.substr(4) : std::string_view();
+    if (prefix.size() == reply.size && prefix.size() >= 2) prefix.remove_suffix(2);
+    return prefix;
+}
+
+/**
+ * @brief Returns a short printable form of a message.
+ *
+ * @param msg The message without framing, or its start.
+ * @param size Size of the whole message as sent, framing included.
+ * @param binary Whether the message is a frame.
+ */
+static std::string describe(std::string_view msg, size_t size, bool binary) {
+    if (binary) {
+        if (msg.empty()) return "<empty frame>";
+        return "<frame type " + std::to_string(static_cast<uint8_t>(msg[0])) + ", "
+               + std::to_string(size - 5) + " payload bytes>";
+    }
+    const size_t limit = TRACE_REPLY_PREFIX - 2;
+    if (size - 2 <= limit) return "\"" + std::string(msg) + "\"";
+    return "\"" + std::string(msg.substr(0, limit)) + "...\"";
+}
+
+/**
+ * @brief Replays the connections against the server.
+ */
+class Replayer {
+public:
+    Replayer(const ReplayOptions &options, const SocketAddress &server, int epollFd,
+             std::vector<Connection> &connections)
+        : opt(options), server(server), epollFd(epollFd), connections(connections) {}
+
+    /**
+     * @brief Runs until every connection has finished.
+     */
+    void run();
+
+    /// Results of the replay.
+    const ReplayStats &stats() const { return total; }
+
+private:
+    struct Wakeup {
+        Clock::time_point at;
+        size_t connection;
+        bool operator>(const Wakeup &other) const { return at > other.at; }
+    };
+
+    void open(size_t index);
+    void openReady();
+    void finish(size_t index);
+    void advance(size_t index);
+    void receive(size_t index);
+    void checkStalls();
+
+    Clock::time_point recordedTime(uint64_t time) const {
+        return start + std::chrono::nanoseconds(time);
+    }
+
+    const ReplayOptions &opt;
+    const SocketAddress &server;
+    const int epollFd;
+    std::vector<Connection> &connections;
+    std::priority_queue<Wakeup, std::vector<Wakeup>, std::greater<Wakeup>> wakeups;
+    Clock::time_point start;
+    size_t active = 0;   ///< Connections not finished yet.
+    size_t nextOpen = 0; ///< First connection not opened yet (full speed only).
+    size_t settled = 0;  ///< Recorded replies received, given up on or owed by finished connections.
+    Clock::time_point progressAt; ///< Last send or receive on any connection.
+    std::string framed;  ///< Scratch for reframe().
+    ReplayStats total;
+};
+
+void Replayer::open(size_t index) {
+    Connection &c = connections[index];
+    c.fd = socket(server.family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c.fd < 0 ||
+        (connect(c.fd, (const struct sockaddr*)&server.addr, server.length) < 0 &&
+         errno != EINPROGRESS)) {
+        ++total.connectFailures;
+        finish(index);
+        return;
+    }
+    struct epoll_event ev{};
+    ev.events   = EPOLLOUT;
+    ev.data.u64 = index;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    c.progressAt = Clock::now();
+}
+
+void Replayer::openReady() {
+    while (nextOpen < connections.size() &&
+           settled >= connections[nextOpen].repliesBeforeOpen) {
+        open(nextOpen++);
+    }
+}
+
+void Replayer::finish(size_t index) {
+    Connection &c = connections[index];
+    if (c.finished) return;
+    settled += c.replies.size() - std::min(c.received, c.replies.size());
+    if (c.fd >= 0) close(c.fd);
+    c.fd = -1;
+    c.finished = true;
+    --active;
+}
+
+void Replayer::advance(size_t index) {
+    Connection &c = connections[index];
+    while (c.connected && c.nextStep < c.steps.size()) {
+        const Step &step = c.steps[c.nextStep];
+        if (c.received < step.repliesBefore) return; // receive() or checkStalls() resumes
+        if (opt.paced && Clock::now() < recordedTime(step.time)) {
+            wakeups.push({recordedTime(step.time), index});
+            return;
+        }
+
+        ++c.nextStep;
+        c.progressAt = progressAt = Clock::now();
+        if (step.kind == TraceKind::Close) {
+            finish(index);
+            return;
+        }
+
+        std::string msg;
+        if (step.kind == TraceKind::Line) {
+            msg = std::string(step.payload) + CRLF;
+            if (step.payload.substr(0, strlen(HELLO_BINARY) + 1) == std::string(HELLO_BINARY) + " ") {
+                c.binary = true;
+            }
+        } else {
+            FrameType type;
+            std::string_view payload;
+            splitFrame(step.payload, type, payload);
+            msg = makeFrame(type, payload);
+        }
+        if (!writeAll(c.fd, msg)) {
+            total.unsent += c.steps.size() - c.nextStep + 1;
+            finish(index);
+            return;
+        }
+        ++total.sent;
+    }
+    // A trace that stops without a close (the recording ended) needs no more waiting.
+    if (c.connected && c.nextStep == c.steps.size() && c.received >= c.replies.size()) {
+        finish(index);
+    }
+}
+
+void Replayer::receive(size_t index) {
+    Connection &c = connections[index];
+    LineBuffer::FillStatus status = c.input.fill(c.fd);
+    std::string_view msg;
+    while (true) {
+        if (c.binary) {
+            LineBuffer::FrameStatus frameStatus = c.input.nextFrame(msg);
+            if (frameStatus == LineBuffer::FrameStatus::Invalid) {
+                status = LineBuffer::FillStatus::Closed;
+                break;
+            }
+            if (frameStatus != LineBuffer::FrameStatus::Complete) break;
+        } else if (!c.input.nextLine(msg)) {
+            break;
+        }
+
+        ++total.received;
+        c.progressAt = progressAt = Clock::now();
+        if (c.received >= c.replies.size()) {
+            ++total.unexpected;
+            ++c.received;
+            continue;
+        }
+        ++settled;
+        const TraceReply &expected = c.replies[c.received];
+        reframe(msg, c.binary, framed);
+        if (framed.size() == expected.size && traceHash(framed) == expected.hash) {
+            ++total.identical;
+        } else {
+            ++total.different;
+            if (total.examples.size() < MAX_EXAMPLES) {
+                total.examples.push_back(
+                    "connection " + std::to_string(c.id) + ", reply " + std::to_string(c.received + 1)
+                    + ": expected " + describe(unframe(expected, c.binary), expected.size, c.binary)
+                    + ", got " + describe(msg, framed.size(), c.binary));
+            }
+        }
+        ++c.received;
+    }
+
+    if (status == LineBuffer::FillStatus::Closed || c.input.full()) {
+        // The server closed the connection; whatever the client still had to say is lost.
+        total.unsent += c.steps.size() - c.nextStep;
+        finish(index);
+    } else {
+        advance(index);
+    }
+}
+
+void Replayer::checkStalls() {
+    auto now = Clock::now();
+    auto timeout = std::chrono::seconds(opt.stallSeconds);
+    if (!opt.paced && nextOpen < connections.size() && now - progressAt >= timeout) {
+        // The replies the next accept waited for are not coming.
+        ++total.stalls;
+        progressAt = now;
+        open(nextOpen++);
+    }
+    for (size_t i = 0; i < connections.size(); ++i) {
+        Connection &c = connections[i];
+        if (c.finished || c.fd < 0 || now - c.progressAt < timeout) continue;
+        if (!c.connected) {
+            ++total.connectFailures;
+            finish(i);
+            continue;
+        }
+        if (c.nextStep < c.steps.size() && c.received < c.steps[c.nextStep].repliesBefore) {
+            // Give up on the awaited replies and go on.
+            ++total.stalls;
+            settled += c.steps[c.nextStep].repliesBefore - c.received;
+            c.received = c.steps[c.nextStep].repliesBefore;
+            advance(i);
+        } else if (c.nextStep == c.steps.size()) {
+            // Trace ends without a close (the recording stopped): stop waiting.
+            finish(i);
+        }
+    }
+}
+
+void Replayer::run() {
+    start = progressAt = Clock::now();
+    active = connections.size();
+    for (size_t i = 0; i < connections.size(); ++i) {
+        total.expected += connections[i].replies.size();
+        if (opt.paced) {
+            wakeups.push({recordedTime(connections[i].openTime), i});
+        }
+    }
+    if (!opt.paced) openReady();
+
+    std::vector<struct epoll_event> events(1024);
+    auto nextStallCheck = start + std::chrono::milliseconds(100);
+    while (active > 0) {
+        auto now = Clock::now();
+        auto wakeAt = nextStallCheck;
+        if (!wakeups.empty()) wakeAt = std::min(wakeAt, wakeups.top().at);
+        auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            wakeAt - now + std::chrono::microseconds(999)).count();
+
+        int ready = epoll_wait(epollFd, events.data(), events.size(),
+                               static_cast<int>(std::max<decltype(waitMs)>(waitMs, 0)));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "ERROR: epoll_wait(): " << strerror(errno) << "\n";
+            return;
+        }
+        for (int e = 0; e < ready; ++e) {
+            size_t index = static_cast<size_t>(events[e].data.u64);
+            Connection &c = connections[index];
+            if (c.finished) continue;
+            if (!c.connected) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                if (getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+                    ++total.connectFailures;
+                    finish(index);
+                    continue;
+                }
+                struct epoll_event ev{};
+                ev.events   = EPOLLIN;
+                ev.data.u64 = index;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+                c.connected = true;
+                advance(index);
+                continue;
+            }
+            receive(index);
+        }
+
+        now = Clock::now();
+        while (!wakeups.empty() && wakeups.top().at <= now) {
+            size_t index = wakeups.top().connection;
+            wakeups.pop();
+            Connection &c = connections[index];
+            if (c.finished) continue;
+            if (c.fd < 0) open(index);
+            else advance(index);
+        }
+        if (now >= nextStallCheck) {
+            checkStalls();
+            nextStallCheck = now + std::chrono::milliseconds(100);
+        }
+        if (!opt.paced) openReady();
+    }
+}
+
+/**
+ * @brief Entry point of approx-replay.
+ */
+int main(int argc, char* argv[]) {
+    ReplayOptions opt;
+    if (!parseReplayArgs(argc, argv, opt)) {
+        return 1;
+    }
+
+    // The server may close a connection while we write to it.
+    signal(SIGPIPE, SIG_IGN);
+
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    std::string trace;
+    std::vector<Connection> connections;
+    if (!readFile(opt.tracePath, trace) || !loadTrace(trace, connections)) return 1;
+
+    std::vector<SocketAddress> addresses;
+    if (!resolveServer(opt.serverAddr, opt.port, AF_UNSPEC, addresses)) return 1;
+
+    int epollFd = epoll_create1(0);
+    if (epollFd < 0) {
+        std::cerr << "ERROR: epoll_create1(): " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    Replayer replayer(opt, addresses.front(), epollFd, connections);
+    auto started = Clock::now();
+    replayer.run();
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    const ReplayStats &s = replayer.stats();
+
+    std::printf("connections=%zu pacing=%s duration=%.3fs\n",
+                connections.size(), opt.paced ? "recorded" : "full speed", seconds);
+    std::printf("sent %llu messages (%.0f messages/s), received %llu replies (%.0f replies/s)\n",
+                static_cast<unsigned long long>(s.sent), s.sent / std::max(seconds, 1e-9),
+                static_cast<unsigned long long>(s.received), s.received / std::max(seconds, 1e-9));
+    uint64_t missing = s.expected - std::min(s.expected, s.identical + s.different);
+    std::printf("replies: expected=%llu identical=%llu different=%llu missing=%llu unexpected=%llu\n",
+                static_cast<unsigned long long>(s.expected),
+                static_cast<unsigned long long>(s.identical),
+                static_cast<unsigned long long>(s.different),
+                static_cast<unsigned long long>(missing),
+                static_cast<unsigned long long>(s.unexpected));
+    std::printf("stalls=%llu unsent=%llu connect_failures=%llu\n",
+                static_cast<unsigned long long>(s.stalls),
+                static_cast<unsigned long long>(s.unsent),
+                static_cast<unsigned long long>(s.connectFailures));
+    for (const std::string &example : s.examples) std::printf("  %s\n", example.c_str());
+
+    close(epollFd);
+    bool diverged = s.different > 0 || missing > 0 || s.unexpected > 0;
+    return diverged ? 2 : 0;
+}
@@ -1,21 +1,62 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <map>
 #include <cstring>
 #include <cstdlib>
+#include <atomic>
 #include <thread>
+#include <csignal>
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <poll.h>
 
 #include "utils.hpp"
 #include "protocol.hpp"
 #include "Server.hpp"
+#include "GameCoordinator.hpp"
+#include "CoeffStore.hpp"
+#include "GameClock.hpp"
+#include "IoEngine.hpp"
+#include "Metrics.hpp"
+#include "Logger.hpp"
+#include "TraceRecorder.hpp"
+#include "SnapshotStore.hpp"
+
+/// Upper bound of the -t option.
+static const int MAX_THREADS = 64;
+
+/**
+ * @brief Descriptors owned by one shard (worker thread).
+ */
+struct Shard {
+    int listenFd = -1; ///< Own listening socket bound to the common port (SO_REUSEPORT).
+    int localFd = -1;  ///< Unix-domain listening socket shared by all shards, or -1.
+    int wakeFd = -1;   ///< eventfd signalled by the coordinator when the game ends.
+};
+
+/**
+ * @brief Raises the limit of open descriptors to the hard limit.
+ *
+ * Every connected player holds one descriptor, so the default soft limit
+ * (usually 1024) would cap the number of concurrent players.
+ */
+static void raiseFileLimit() {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &lim) < 0) {
+            std::cerr << "WARNING: setrlimit(RLIMIT_NOFILE): " << strerror(errno) << "\n";
+        }
+    }
+}
 
 /**
  * @brief Parses command-line arguments for the approx-server.
@@ -25,7 +66,21 @@
  *   -k <K>        : Maximum x value (1–10000), default 100
  *   -n <N>        : Polynomial degree (1–8), default 4
  *   -m <M>        : Number of allowed PUTs (1–12341234), default 131
- *   -f <filename> : Required file containing COEFF lines
+ *   -f <filename> : Required file containing COEFF lines (reloaded on SIGHUP)
+ *   -o <order>    : Order of COEFF lines: seq (each once), wrap or random, default seq
+ *   -t <threads>  : Number of shards (worker threads), 1–64, default 1
+ *   -r <size>     : Players per matchmade room, 0–10000, default 0 (one global game)
+ *   -x <scale>    : Game time runs this many times faster than wall-clock time, 1–1000, default 1
+ *   -a <port>     : Admin port serving the metrics as plain text (1–65535), default none
+ *   -v <level>    : Log level: debug, info, warning or off, default debug (SIGUSR2 cycles it)
+ *   -u <path>     : Also accept clients on a Unix-domain socket at path, default none
+ *   -w <file>     : Record the traffic into a trace file for approx-replay, default none
+ *   -e <engine>   : Socket I/O of the shards: epoll or uring (io_uring), default epoll
+ *   -l <lines>    : Lines a client may send per second of game time, 0–1000000, default 0 (no limit)
+ *   -b <bytes>    : Bytes a client may send per second of game time, 0–1000000000, default 0 (no limit)
+ *   -q <count>    : Connections that may await HELLO at once, 0–1000000, default 0 (no limit)
+ *   -s <file>     : Snapshot the games in flight into file, and restore them from it at startup
+ *   -i <seconds>  : Time between two snapshots, 0.01–3600, default 1
  *
  * @param argc Argument count.
  * @param argv Argument values.
@@ -38,13 +93,30 @@
  * @return true if parsing succeeded; false otherwise.
  */
 static bool parseServerArgs(int argc, char* argv[],
-                            int &port, int &K, int &N, int &M, std::string &filename)
+                            int &port, int &K, int &N, int &M, std::string &filename,
+                            int &threads, int &roomSize, CoeffStore::Order &order,
+                            double &timeScale, int &adminPort, LogLevel &logLevel,
+                            std::string &localPath, std::string &tracePath,
+                            IoEngine::Backend &engine, ClientLimits &limits,
+                            std::string &snapshotPath, double &snapshotInterval)
 {
     port     = 0;      // default: let OS choose free port
     K        = 100;    // default K
     N        = 4;      // default N
     M        = 131;    // default M
+    threads  = 1;      // default: a single event loop
+    roomSize = 0;      // default: players without a room ID share one game
+    order    = CoeffStore::Order::Sequential;
+    timeScale = 1.0;   // default: real time
+    adminPort = 0;     // default: metrics only on SIGUSR1
+    logLevel = LogLevel::Debug; // default: log every message sent
     filename.clear();
+    localPath.clear(); // default: TCP only
+    tracePath.clear(); // default: no recording
+    engine = IoEngine::Backend::Epoll;
+    limits = ClientLimits{}; // default: no limits
+    snapshotPath.clear();    // default: no snapshots
+    snapshotInterval = 1.0;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -103,6 +175,157 @@ static bool parseServerArgs(int argc, char* argv[],
             }
             filename = argv[++i];
         }
+        else if (arg == "-t") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -t\n";
+                return false;
+            }
+            int tmp;
+            if (!parseInteger(argv[++i], tmp) || tmp < 1 || tmp > MAX_THREADS) {
+                std::cerr << "ERROR: invalid number of threads (1–" << MAX_THREADS << "): "
+                          << argv[i] << "\n";
+                return false;
+            }
+            threads = tmp;
+        }
+        else if (arg == "-r") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -r\n";
+                return false;
+            }
+            int tmp;
+            if (!parseInteger(argv[++i], tmp) || tmp < 0 || tmp > 10000) {
+                std::cerr << "ERROR: invalid room size (0–10000): " << argv[i] << "\n";
+                return false;
+            }
+            roomSize = tmp;
+        }
+        else if (arg == "-o") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -o\n";
+                return false;
+            }
+            if (!CoeffStore::parseOrder(argv[++i], order)) {
+                std::cerr << "ERROR: invalid COEFF order (seq, wrap or random): " << argv[i] << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-x") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -x\n";
+                return false;
+            }
+            double tmp;
+            if (!parseReal(argv[++i], tmp) || !(tmp >= 1.0 && tmp <= GameClock::MAX_SCALE)) {
+                std::cerr << "ERROR: invalid time scale (1–" << GameClock::MAX_SCALE << "): "
+                          << argv[i] << "\n";
+                return false;
+            }
+            timeScale = tmp;
+        }
+        else if (arg == "-a") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -a\n";
+                return false;
+            }
+            int tmp;
+            if (!parseInteger(argv[++i], tmp) || tmp < 1 || tmp > 65535) {
+                std::cerr << "ERROR: invalid admin port (1–65535): " << argv[i] << "\n";
+                return false;
+            }
+            adminPort = tmp;
+        }
+        else if (arg == "-v") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -v\n";
+                return false;
+            }
+            if (!Logger::parseLevel(argv[++i], logLevel)) {
+                std::cerr << "ERROR: invalid log level (debug, info, warning or off): "
+                          << argv[i] << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-u") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing path after -u\n";
+                return false;
+            }
+            localPath = argv[++i];
+        }
+        else if (arg == "-w") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing filename after -w\n";
+                return false;
+            }
+            tracePath = argv[++i];
+        }
+        else if (arg == "-e") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -e\n";
+                return false;
+            }
+            if (!IoEngine::parseBackend(argv[++i], engine)) {
+                std::cerr << "ERROR: invalid I/O engine (epoll or uring): " << argv[i] << "\n";
+                return false;
+            }
+        }
+        else if (arg == "-l") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -l\n";
+                return false;
+            }
+            double tmp;
+            if (!parseReal(argv[++i], tmp) || !(tmp >= 0.0 && tmp <= 1e6)) {
+                std::cerr << "ERROR: invalid line rate (0–1000000): " << argv[i] << "\n";
+                return false;
+            }
+            limits.linesPerSecond = tmp;
+        }
+        else if (arg == "-b") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -b\n";
+                return false;
+            }
+            double tmp;
+            if (!parseReal(argv[++i], tmp) || !(tmp >= 0.0 && tmp <= 1e9)) {
+                std::cerr << "ERROR: invalid byte rate (0–1000000000): " << argv[i] << "\n";
+                return false;
+            }
+            limits.bytesPerSecond = tmp;
+        }
+        else if (arg == "-q") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -q\n";
+                return false;
+            }
+            int tmp;
+            if (!parseInteger(argv[++i], tmp) || tmp < 0 || tmp > 1000000) {
+                std::cerr << "ERROR: invalid number of connections awaiting HELLO (0–1000000): "
+                          << argv[i] << "\n";
+                return false;
+            }
+            limits.maxAwaitingHello = tmp;
+        }
+        else if (arg == "-s") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing filename after -s\n";
+                return false;
+            }
+            snapshotPath = argv[++i];
+        }
+        else if (arg == "-i") {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing value after -i\n";
+                return false;
+            }
+            double tmp;
+            if (!parseReal(argv[++i], tmp) || !(tmp >= 0.01 && tmp <= 3600.0)) {
+                std::cerr << "ERROR: invalid snapshot interval (0.01–3600): " << argv[i] << "\n";
+                return false;
+            }
+            snapshotInterval = tmp;
+        }
         else {
             std::cerr << "ERROR: unknown parameter: " << arg << "\n";
             return false;
@@ -118,119 +341,290 @@ static bool parseServerArgs(int argc, char* argv[],
 
 
 /**
- * @brief Entry point of the approx-server.
- *
- * Initializes the server, listens for incoming client connections,
- * handles game communication, enforces timeouts and game rules,
- * and broadcasts results when the game ends.
+ * @brief Creates the wake eventfd of a shard.
  *
- * @param argc Argument count.
- * @param argv Argument vector.
- * @return int Exit code.
+ * @param shard Shard whose wakeFd is filled in.
+ * @return true on success, false otherwise.
  */
-int main(int argc, char* argv[]) {
-    int port, K, N, M;
-    std::string coeffFilename;
-
-    if (!parseServerArgs(argc, argv, port, K, N, M, coeffFilename)) {
-        return 1;
-    }
-    std::cout << "Starting server with config: port=" << port
-              << ", K=" << K << ", N=" << N << ", M=" << M
-              << ", coeff file=\"" << coeffFilename << "\"\n";
-
-    std::ifstream coeffFile(coeffFilename);
-    if (!coeffFile.is_open()) {
-        std::cerr << "ERROR: unable to open file " << coeffFilename << "\n";
-        return 1;
+static bool setupShard(Shard &shard) {
+    shard.wakeFd = eventfd(0, EFD_NONBLOCK);
+    if (shard.wakeFd < 0) {
+        std::cerr << "ERROR: eventfd(): " << strerror(errno) << "\n";
+        return false;
     }
+    return true;
+}
 
-    int listenFd = setupListeningSocket(port);
-    if (listenFd < 0) return 1;
-
-    std::map<int, ClientState> clients;
-    int correctPutCount = 0;
+/**
+ * @brief Returns the port a socket is bound to, or -1 on error.
+ */
+static int boundPort(int fd) {
+    struct sockaddr_in6 addr{};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr*)&addr, &len) < 0) return -1;
+    return ntohs(addr.sin6_port);
+}
 
+/**
+ * @brief Reloads the COEFF file on SIGHUP, prints the metrics on SIGUSR1 and switches
+ *        to the next log level on SIGUSR2 (debug → info → warning → off → debug).
+ *
+ * Runs in its own thread with sigwait(); the signals are blocked in all other threads,
+ * so the event loops are never interrupted and never wait for the file to be parsed.
+ *
+ * @param coeffs The store to reload.
+ * @param metrics The metrics to print.
+ */
+static void handleSignals(CoeffStore &coeffs, const Metrics &metrics) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGUSR2);
     while (true) {
-        fd_set readFds;
-        FD_ZERO(&readFds);
-        FD_SET(listenFd, &readFds);
-        int maxFd = listenFd;
+        int sig;
+        if (sigwait(&set, &sig) != 0) continue;
+        if (sig == SIGUSR2) {
+            LogLevel next = static_cast<LogLevel>((static_cast<int>(Logger::level()) + 1)
+                                                  % (static_cast<int>(LogLevel::Off) + 1));
+            Logger::setLevel(next);
+            std::cout << "SIGUSR2 received, log level " << Logger::levelName(next) << "\n";
+            continue;
+        }
+        if (sig == SIGUSR1) {
+            std::cout << "SIGUSR1 received, metrics:\n" + metrics.render() << std::flush;
+            continue;
+        }
+        std::cout << "SIGHUP received, reloading COEFF file.\n";
+        if (!coeffs.load()) {
+            std::cerr << "ERROR: reload failed, keeping the previous COEFF lines\n";
+        }
+    }
+}
 
-        for (auto &[fd, state] : clients) {
-            FD_SET(fd, &readFds);
-            if (fd > maxFd) maxFd = fd;
+/**
+ * @brief Serves the metrics on the admin port: every connection gets the current
+ *        metrics as plain text and is closed.
+ *
+ * Runs in its own thread with blocking I/O, so a slow reader never delays a shard.
+ * For example: nc localhost <admin port>
+ *
+ * @param listenFd Listening socket of the admin port.
+ * @param metrics The metrics to serve.
+ */
+static void serveMetrics(int listenFd, const Metrics &metrics) {
+    while (true) {
+        // The listening socket is non-blocking; wait for the next connection.
+        struct pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, -1) < 0) continue;
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (!writeAll(fd, metrics.render())) {
+            std::cerr << "ERROR: admin write(): " << strerror(errno) << "\n";
         }
+        close(fd);
+    }
+}
 
-        bool haveTimeout = false;
-        auto now = std::chrono::steady_clock::now();
-        auto nextTime = now + std::chrono::hours(24);
+/**
+ * @brief Event loop of one shard: accepts its share of connections and serves its clients.
+ *
+ * Shards share nothing but the coordinator, so they never wait for each other except
+ * at the end of the global game, when every shard contributes its results to SCORING.
+ * Rooms are owned by a single shard and end without any coordination.
+ *
+ * The I/O engine is created here, as an io_uring instance belongs to the thread that
+ * submits to it. The Unix-domain socket is shared by all shards; the engine hands each
+ * local connection to one of them.
+ *
+ * @param sockets Descriptors of the shard.
+ * @param index Index of the shard.
+ * @param backend I/O engine to use.
+ * @param game Shared game state.
+ * @param metrics Metrics of all shards (the shard updates its own).
+ */
+static void runShard(const Shard &sockets, int index, IoEngine::Backend backend,
+                     GameCoordinator &game, Metrics &metrics)
+{
+    ShardMetrics &shardMetrics = metrics.shard(index);
+    std::unique_ptr<IoEngine> io = IoEngine::create(backend, shardMetrics.syscalls);
+    if (!io || !io->addListener(sockets.listenFd, false) ||
+        (sockets.localFd >= 0 && !io->addListener(sockets.localFd, true)) ||
+        !io->setWakeFd(sockets.wakeFd)) {
+        exit(1);
+    }
+    ShardState shard(index, *io, game, shardMetrics);
+    auto nextSnapshot = std::chrono::steady_clock::now() + SnapshotStore::interval();
 
-        for (auto &[fd, state] : clients) {
-            if (!state.hasSentCoeff && state.helloDeadline < nextTime) {
-                nextTime = state.helloDeadline;
-                haveTimeout = true;
-            }
-            if (state.pendingBadPut && state.badPutAt < nextTime) {
-                nextTime = state.badPutAt;
-                haveTimeout = true;
-            }
-            if (state.pendingState && state.stateAt < nextTime) {
-                nextTime = state.stateAt;
-                haveTimeout = true;
+    while (true) {
+        std::chrono::nanoseconds timeout(-1);
+        if (!shard.timers.empty()) {
+            auto wait = GameClock::toReal(shard.timers.nextDeadline() - GameClock::now());
+            timeout = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(wait),
+                               std::chrono::nanoseconds::zero());
+        }
+        if (SnapshotStore::enabled()) {
+            auto untilSnapshot = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              nextSnapshot - std::chrono::steady_clock::now()),
+                                          std::chrono::nanoseconds::zero());
+            if (timeout < std::chrono::nanoseconds::zero() || untilSnapshot < timeout) {
+                timeout = untilSnapshot;
             }
         }
+        // The other shards would wait for this one at the end of the game.
+        if (!io->wait(timeout)) exit(1);
+        auto iterationStart = std::chrono::steady_clock::now();
 
-        struct timeval tv;
-        struct timeval *ptimeout = nullptr;
-        if (haveTimeout) {
-            auto diff = std::chrono::duration_cast<std::chrono::microseconds>(nextTime - now);
-            tv.tv_sec  = std::max<int64_t>(0, diff.count() / 1000000);
-            tv.tv_usec = std::max<int64_t>(0, diff.count() % 1000000);
-            ptimeout = &tv;
+        for (IoEvent &event : io->events()) {
+            switch (event.kind) {
+                case IoEventKind::Accepted:
+                    acceptClient(event.fd, shard);
+                    break;
+                case IoEventKind::Wake:
+                    // endRequested() is checked below.
+                    adoptHandOffs(shard);
+                    break;
+                case IoEventKind::Readable:
+                case IoEventKind::Writable:
+                    // Erased right away, so that later events for a closed descriptor
+                    // are ignored.
+                    if (handleClientEvent(event, shard)) removeClient(shard, event.fd);
+                    break;
+            }
         }
 
-        int ready = select(maxFd + 1, &readFds, nullptr, nullptr, ptimeout);
-        if (ready < 0) {
-            if (errno == EINTR) continue;
-            std::cerr << "ERROR: select(): " << strerror(errno) << "\n";
-            break;
+        checkTimers(shard);
+        finishRooms(shard);
+
+        // Between iterations, so the shard's records are consistent with each other.
+        if (SnapshotStore::enabled() && std::chrono::steady_clock::now() >= nextSnapshot) {
+            snapshotShard(shard);
+            nextSnapshot = std::chrono::steady_clock::now() + SnapshotStore::interval();
         }
 
-        if (FD_ISSET(listenFd, &readFds)) {
-            acceptNewClient(listenFd, clients, K);
+        shard.metrics.loops.add();
+        shard.metrics.clients.set(shard.clients.size());
+        shard.metrics.timers.set(shard.timers.size());
+        shard.metrics.loopTime.record(std::chrono::steady_clock::now() - iterationStart);
+
+        if (game.endRequested()) {
+            sendScoringAndReset(shard);
         }
 
-        std::vector<int> toRemove;
-        for (auto &[fd, state] : clients) {
-            if (!state.hasSentCoeff && now >= state.helloDeadline) {
-                std::cout << "Client (fd=" << fd << ") did not send HELLO in time. Disconnecting.\n";
-                close(fd);
-                toRemove.push_back(fd);
-                continue;
-            }
+        // One write per iteration, and only when recording.
+        TraceRecorder::flush();
+    }
+}
+
+/**
+ * @brief Entry point of the approx-server.
+ *
+ * Initializes the server, listens for incoming client connections,
+ * handles game communication, enforces timeouts and game rules,
+ * and broadcasts results when the game ends. With -t T, T shards run in T threads,
+ * each with its own SO_REUSEPORT listening socket, event loop, clients and timers.
+ *
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return int Exit code.
+ */
+int main(int argc, char* argv[]) {
+    int port, K, N, M, threads, roomSize, adminPort;
+    double timeScale;
+    LogLevel logLevel;
+    CoeffStore::Order order;
+    std::string coeffFilename, localPath, tracePath;
+    IoEngine::Backend engine;
+    ClientLimits limits;
+    std::string snapshotPath;
+    double snapshotInterval;
 
-            if (!FD_ISSET(fd, &readFds)) continue;
+    if (!parseServerArgs(argc, argv, port, K, N, M, coeffFilename, threads, roomSize, order,
+                         timeScale, adminPort, logLevel, localPath, tracePath, engine, limits,
+                         snapshotPath, snapshotInterval)) {
+        return 1;
+    }
+    std::cout << "Starting server with config: port=" << port
+              << ", K=" << K << ", N=" << N << ", M=" << M
+              << ", coeff file=\"" << coeffFilename << "\""
+              << ", threads=" << threads << ", room size=" << roomSize
+              << ", time scale=" << timeScale
+              << ", I/O engine=" << IoEngine::backendName(engine)
+              << ", lines/s=" << limits.linesPerSecond
+              << ", bytes/s=" << limits.bytesPerSecond
+              << ", awaiting HELLO=" << limits.maxAwaitingHello << "\n";
+    // Before any shard starts reading the clock.
+    GameClock::setScale(timeScale);
 
-            bool disconnected = handleClientMessage(fd, clients, correctPutCount, K, coeffFile);
-            if (disconnected) {
-                toRemove.push_back(fd);
-                correctPutCount -= state.correctPutCountForThisClient;
-            }
-        }
+    CoeffStore coeffs(coeffFilename, order);
+    if (!coeffs.load()) return 1;
 
-        for (int fd : toRemove) {
-            clients.erase(fd);
-        }
+    raiseFileLimit();
 
-        checkTimers(clients);
+    // A client disconnecting while we write to it must not terminate the server.
+    signal(SIGPIPE, SIG_IGN);
 
-        if (correctPutCount >= M) {
-            sendScoringAndReset(clients, correctPutCount, K);
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
+    // SIGHUP, SIGUSR1 and SIGUSR2 are handled only by the signal thread; threads started
+    // later inherit the mask.
+    Metrics metrics(threads);
+    sigset_t handled;
+    sigemptyset(&handled);
+    sigaddset(&handled, SIGHUP);
+    sigaddset(&handled, SIGUSR1);
+    sigaddset(&handled, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &handled, nullptr);
+    std::thread(handleSignals, std::ref(coeffs), std::cref(metrics)).detach();
+    Logger::start(logLevel);
+
+    if (adminPort > 0) {
+        int adminFd = setupListeningSocket(adminPort);
+        if (adminFd < 0) return 1;
+        std::cout << "Metrics served on admin port " << adminPort << "\n";
+        std::thread(serveMetrics, adminFd, std::cref(metrics)).detach();
+    }
+
+    if (!tracePath.empty()) {
+        if (!TraceRecorder::start(tracePath)) return 1;
+        std::cout << "Recording traffic to " << tracePath << "\n";
+    }
+
+    // Local clients connect through one Unix-domain socket; the shards take turns at it.
+    int localFd = -1;
+    if (!localPath.empty()) {
+        localFd = setupLocalSocket(localPath);
+        if (localFd < 0) return 1;
+    }
+
+    // Every shard listens on its own socket; with port 0 the later ones reuse the port
+    // the first one got.
+    GameCoordinator game(K, M, coeffs, roomSize, limits);
+    if (!snapshotPath.empty()) {
+        auto restoreStart = std::chrono::steady_clock::now();
+        auto interval = std::chrono::milliseconds(static_cast<int64_t>(snapshotInterval * 1000));
+        if (!SnapshotStore::start(snapshotPath, K, threads, interval)) return 1;
+        game.skipMatchmadeRooms(SnapshotStore::matchmadeRooms());
+        auto restoreTime = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - restoreStart);
+        std::cout << "Restored " << SnapshotStore::restoredCount() << " players from "
+                  << snapshotPath << " in " << restoreTime.count() << " ms; snapshots every "
+                  << snapshotInterval << " s\n";
+    }
+    std::vector<Shard> shards(threads);
+    for (Shard &shard : shards) {
+        shard.localFd = localFd;
+        shard.listenFd = setupListeningSocket(port, threads > 1);
+        if (shard.listenFd < 0 || !setupShard(shard)) return 1;
+        if (port == 0) port = boundPort(shard.listenFd);
+        game.addShard(shard.wakeFd);
+    }
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(runShard, std::cref(shards[i]), i, engine, std::ref(game),
+                             std::ref(metrics));
     }
+    runShard(shards[0], 0, engine, game, metrics);
 
-    close(listenFd);
+    for (std::thread &worker : workers) worker.join();
     return 0;
 }
@@ -1,15 +1,15 @@
 #include "utils.hpp"
 #include <algorithm>
-#include <climits>
+#include <charconv>
+#include <cmath>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <iostream>
 
-std::string trimCRLF(const std::string &s) {
-    size_t end = s.size();
-    while (end > 0 && (s[end - 1] == '\r' || s[end - 1] == '\n')) --end;
-    return s.substr(0, end);
-}
-
-std::vector<std::string> splitBySpace(const std::string &s) {
-    std::vector<std::string> out;
+void splitBySpace(std::string_view s, std::vector<std::string_view> &out) {
+    out.clear();
     size_t i = 0, n = s.size();
     while (i < n) {
         while (i < n && s[i] == ' ') ++i;
@@ -19,56 +19,40 @@ std::vector<std::string> splitBySpace(const std::string &s) {
         out.push_back(s.substr(i, j - i));
         i = j;
     }
-    return out;
 }
 
-bool parseInteger(const std::string &s, int &out) {
+/**
+ * @brief Drops a leading '+' (accepted by strtol/strtod, but not by std::from_chars).
+ */
+static std::string_view skipPlus(std::string_view s) {
+    if (s.size() > 1 && s[0] == '+' && s[1] != '-') s.remove_prefix(1);
+    return s;
+}
+
+bool parseInteger(std::string_view s, int &out) {
+    s = skipPlus(s);
     if (s.empty()) return false;
-    char *endptr = nullptr;
-    errno = 0;
-    long val = strtol(s.c_str(), &endptr, 10);
-    if (errno != 0 || *endptr != '\0') return false;
-    if (val < INT_MIN || val > INT_MAX) return false;
-    out = static_cast<int>(val);
+    int val;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), val);
+    if (res.ec != std::errc() || res.ptr != s.data() + s.size()) return false;
+    out = val;
     return true;
 }
 
-bool parseReal(const std::string &s, double &out) {
+bool parseReal(std::string_view s, double &out) {
+    s = skipPlus(s);
     if (s.empty()) return false;
-    char *endptr = nullptr;
-    errno = 0;
-    out = strtod(s.c_str(), endptr ? &endptr : nullptr);
-    if (errno != 0 || *endptr != '\0') return false;
+    double val;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), val);
+    if (res.ec != std::errc() || res.ptr != s.data() + s.size() || !std::isfinite(val)) return false;
+    out = val;
     return true;
 }
 
-std::string readLine(int fd, bool &success) {
-    static std::string buffer;
-    while (true) {
-        auto pos = buffer.find("\r\n");
-        if (pos != std::string::npos) {
-            std::string line = buffer.substr(0, pos);
-            buffer.erase(0, pos + 2);
-            success = true;
-            return line;
-        }
-
-        char temp[512];
-        ssize_t n = read(fd, temp, sizeof(temp));
-        if (n < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                success = false;
-                return "";
-            }
-            success = false;
-            return "";
-        }
-        if (n == 0) {
-            success = false;
-            return "";
-        }
-        buffer.append(temp, n);
-    }
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return false;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0;
 }
 
 bool writeAll(int fd, const std::string &data) {
@@ -78,9 +62,59 @@ bool writeAll(int fd, const std::string &data) {
         ssize_t w = ::write(fd, ptr + total, len - total);
         if (w < 0) {
             if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                if (poll(&pfd, 1, -1) < 0 && errno != EINTR) return false;
+                continue;
+            }
             return false;
         }
         total += w;
     }
     return true;
-}
\ No newline at end of file
+}
+
+bool isLocalAddress(std::string_view address) {
+    return address.substr(0, LOCAL_ADDRESS_PREFIX.size()) == LOCAL_ADDRESS_PREFIX;
+}
+
+bool resolveServer(const std::string &address, int port, int family,
+                   std::vector<SocketAddress> &out) {
+    out.clear();
+    if (isLocalAddress(address)) {
+        std::string path = address.substr(LOCAL_ADDRESS_PREFIX.size());
+        struct sockaddr_un un{};
+        if (path.empty() || path.size() >= sizeof(un.sun_path)) {
+            std::cerr << "ERROR: invalid Unix socket path: " << path << "\n";
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        memcpy(un.sun_path, path.c_str(), path.size() + 1);
+        SocketAddress result{};
+        result.family = AF_UNIX;
+        result.length = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.size() + 1);
+        memcpy(&result.addr, &un, sizeof(un));
+        out.push_back(result);
+        return true;
+    }
+
+    struct addrinfo hints{}, *res;
+    hints.ai_family   = family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_ADDRCONFIG;
+    std::string portStr = std::to_string(port);
+    int gaiErr = getaddrinfo(address.c_str(), portStr.c_str(), &hints, &res);
+    if (gaiErr != 0) {
+        std::cerr << "ERROR: getaddrinfo: " << gai_strerror(gaiErr) << "\n";
+        return false;
+    }
+    for (struct addrinfo *rp = res; rp != nullptr; rp = rp->ai_next) {
+        SocketAddress result{};
+        result.family = rp->ai_family;
+        result.length = rp->ai_addrlen;
+        memcpy(&result.addr, rp->ai_addr, rp->ai_addrlen);
+        out.push_back(result);
+    }
+    freeaddrinfo(res);
+    return !out.empty();
+}
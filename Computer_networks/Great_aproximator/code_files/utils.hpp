@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cerrno>
 #include <cstring>
@@ -9,22 +10,31 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 
+/// Prefix of a server address that names a Unix-domain socket, e.g. "unix:/tmp/approx.sock".
+inline constexpr std::string_view LOCAL_ADDRESS_PREFIX = "unix:";
+
 /**
- * @brief Reads a full line from the socket until "\r\n" is encountered.
- *
- * Uses an internal static buffer to accumulate data across calls.
- * Does not assume blocking I/O.
+ * @brief A socket address to connect to.
+ */
+struct SocketAddress {
+    int family;                   ///< AF_INET, AF_INET6 or AF_UNIX.
+    socklen_t length;             ///< Length of the address in `addr`.
+    struct sockaddr_storage addr; ///< The address.
+};
+
+/**
+ * @brief Sets the O_NONBLOCK flag on a file descriptor.
  *
- * @param fd File descriptor to read from.
- * @param success Set to true if a full line was read, false otherwise.
- * @return The line without "\r\n", or an empty string if not yet complete or on error.
+ * @param fd File descriptor.
+ * @return true on success, false otherwise.
  */
-std::string readLine(int fd, bool &success);
+bool setNonBlocking(int fd);
 
 /**
  * @brief Writes the entire content of the string to the socket.
  *
- * Handles partial writes.
+ * Handles partial writes. On a non-blocking socket waits with poll()
+ * until the socket is writable again.
  *
  * @param fd File descriptor to write to.
  * @param data The string to write.
@@ -35,37 +45,55 @@ bool writeAll(int fd, const std::string &data);
 /**
  * @brief Attempts to parse an integer from a string.
  *
+ * Uses std::from_chars: no allocation, independent of the locale.
+ * An optional leading '+' is accepted.
+ *
  * @param s The input string.
  * @param out Output variable for the parsed integer.
  * @return true if parsing succeeded, false otherwise.
  */
-bool parseInteger(const std::string &s, int &out);
+bool parseInteger(std::string_view s, int &out);
 
 /**
  * @brief Attempts to parse a floating-point number (double) from a string.
  *
- * Accepts optional decimal part, up to 7 digits after the dot.
+ * Uses std::from_chars: no allocation, and '.' is the decimal separator whatever
+ * the locale. An optional leading '+' is accepted; infinities and NaN are rejected.
  *
  * @param s The input string.
  * @param out Output variable for the parsed double.
  * @return true if parsing succeeded, false otherwise.
  */
-bool parseReal(const std::string &s, double &out);
+bool parseReal(std::string_view s, double &out);
 
 /**
- * @brief Trims trailing '\r' and '\n' characters from the string.
+ * @brief Splits a string by single spaces.
+ *
+ * Consecutive spaces are treated as one separator. Tokens are views into `s`,
+ * so they are valid only as long as the underlying buffer. Reusing the same
+ * output vector across calls avoids any allocation once it has grown.
  *
  * @param s The input string.
- * @return A copy of the string without trailing CR/LF.
+ * @param out Output: the tokens (cleared first).
  */
-std::string trimCRLF(const std::string &s);
+void splitBySpace(std::string_view s, std::vector<std::string_view> &out);
 
 /**
- * @brief Splits a string by single spaces.
+ * @brief Returns true if the server address names a Unix-domain socket ("unix:<path>").
+ */
+bool isLocalAddress(std::string_view address);
+
+/**
+ * @brief Resolves a server address to the socket addresses to try, in order.
  *
- * Consecutive spaces are treated as one separator.
+ * "unix:<path>" is the Unix-domain socket at path (the port is not used); anything else
+ * is a host name or IP address, resolved with getaddrinfo(). Errors are reported.
  *
- * @param s The input string.
- * @return Vector of tokens.
+ * @param address Server address.
+ * @param port Server port (TCP only).
+ * @param family AF_UNSPEC, AF_INET or AF_INET6 (TCP only).
+ * @param out Output: the addresses (cleared first).
+ * @return true if at least one address was found, false otherwise.
  */
-std::vector<std::string> splitBySpace(const std::string &s);
\ No newline at end of file
+bool resolveServer(const std::string &address, int port, int family,
+                   std::vector<SocketAddress> &out);